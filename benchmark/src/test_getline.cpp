@@ -1,5 +1,6 @@
 #include "bench_framework.hpp"
 #include "../plugins/input/csv/csv_getline.hpp"
+#include "../plugins/input/csv/csv_scanner.hpp"
 
 
 
@@ -100,6 +101,47 @@ public:
     }
 };
 
+class test3 : public benchmark::test_case
+{
+public:
+    std::string line_data_;
+    test3(mapnik::parameters const& params)
+     : test_case(params),
+       line_data_("this is one line\nand this is a second line\nand a third line")
+       {
+          boost::optional<std::string> line_data = params.get<std::string>("line");
+          if (line_data)
+          {
+              line_data_ = *line_data;
+          }
+       }
+
+    bool validate() const
+    {
+        bool quoted = false;
+        char const* start = line_data_.data();
+        char const* end = start + line_data_.size();
+        char const* line_end = csv_utils::find_row_end(start, end, '\n', '"', quoted);
+        return std::string(start, line_end) == line_data_.substr(0, line_data_.find('\n'));
+    }
+    bool operator()() const
+    {
+        char const* start = line_data_.data();
+        char const* end = start + line_data_.size();
+        std::string csv_line;
+        char const* itr = start;
+        for (unsigned i=0;i<iterations_;++i)
+        {
+            if (itr >= end) itr = start;
+            bool quoted = false;
+            char const* line_end = csv_utils::find_row_end(itr, end, '\n', '"', quoted);
+            csv_line.assign(itr, line_end);
+            itr = (line_end == end) ? end : line_end + 1;
+        }
+        return true;
+    }
+};
+
 int main(int argc, char** argv)
 {
     int return_value = 0;
@@ -115,6 +157,10 @@ int main(int argc, char** argv)
             test2 test_runner2(params);
             return_value = return_value | run(test_runner2,"csv_utils::getline_csv");
         }
+        {
+            test3 test_runner3(params);
+            return_value = return_value | run(test_runner3,"csv_utils::find_row_end");
+        }
     }
     catch (std::exception const& ex)
     {
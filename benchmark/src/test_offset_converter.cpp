@@ -88,6 +88,50 @@ public:
     }
 };
 
+// many short lines, as in casing heavy road styles with `offset`
+// on every line: dominated by per-geometry setup cost
+class test_offset_many : public benchmark::test_case
+{
+    mutable std::vector<fake_path> paths_;
+public:
+    test_offset_many(mapnik::parameters const& params)
+     : test_case(params)
+    {
+        for (int n = 0; n < 1000; ++n)
+        {
+            std::vector<double> path;
+            for (int i = 0; i < 20; ++i)
+            {
+                path.push_back(n + i);
+                path.push_back((i % 2) ? 5 : 0);
+            }
+            paths_.emplace_back(path);
+        }
+    }
+    bool validate() const
+    {
+        return true;
+    }
+    bool operator()() const
+    {
+        std::size_t count = 0;
+        for (std::size_t i=0;i<iterations_;++i) {
+            for (fake_path & fpath : paths_)
+            {
+                fpath.rewind(0);
+                mapnik::offset_converter<fake_path> off_path(fpath);
+                off_path.set_offset(10);
+                unsigned cmd;
+                double x, y;
+                while ((cmd = off_path.vertex(&x, &y)) != mapnik::SEG_END)
+                {
+                    ++count;
+                }
+            }
+        }
+        return count > 0;
+    }
+};
 
 int main(int argc, char** argv)
 {
@@ -98,5 +142,9 @@ int main(int argc, char** argv)
         test_offset test_runner(params);
         return_value = run(test_runner,"offset_test");
     }
+    {
+        test_offset_many test_runner(params);
+        return_value = return_value | run(test_runner,"offset_test many short lines");
+    }
     return return_value;
 }
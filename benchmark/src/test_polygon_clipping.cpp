@@ -16,6 +16,7 @@
 #include <mapnik/geometry/is_empty.hpp>
 #include <mapnik/image_util.hpp>
 #include <mapnik/color.hpp>
+#include <mapnik/polygon_clipper.hpp>
 // boost geometry
 #include <boost/geometry.hpp>
 // agg
@@ -209,6 +210,177 @@ public:
 };
 
 
+// Vertex count (SEG_CLOSE included) of agg's clipped polygon once the
+// runs of vertices along a single clip edge, which polygon_clipper
+// collapses, are reduced to their end points. Both clippers must agree
+// on everything else.
+unsigned collapsed_agg_vertex_count(mapnik::geometry::polygon<double> const& poly,
+                                    mapnik::box2d<double> const& box)
+{
+    mapnik::geometry::polygon_vertex_adapter<double> va(poly);
+    agg::conv_clip_polygon<mapnik::geometry::polygon_vertex_adapter<double>> clipped(va);
+    clipped.clip_box(box.minx(), box.miny(), box.maxx(), box.maxy());
+    clipped.rewind(0);
+
+    auto same = [] (mapnik::vertex2d const& a, mapnik::vertex2d const& b)
+    {
+        return a.x == b.x && a.y == b.y;
+    };
+    auto on_same_edge = [&box] (mapnik::vertex2d const& a, mapnik::vertex2d const& b, mapnik::vertex2d const& c)
+    {
+        return (a.x == b.x && b.x == c.x && (b.x == box.minx() || b.x == box.maxx()))
+            || (a.y == b.y && b.y == c.y && (b.y == box.miny() || b.y == box.maxy()));
+    };
+    unsigned count = 0;
+    std::vector<mapnik::vertex2d> ring;
+    auto flush = [&] ()
+    {
+        std::vector<mapnik::vertex2d> out;
+        for (auto const& p : ring)
+        {
+            if (!out.empty() && same(out.back(), p)) continue;
+            while (out.size() >= 2 && on_same_edge(out[out.size() - 2], out.back(), p)) out.pop_back();
+            out.push_back(p);
+        }
+        // the ring wraps around
+        while (out.size() >= 3)
+        {
+            if (same(out.back(), out.front())) out.pop_back();
+            else if (on_same_edge(out[out.size() - 2], out.back(), out.front())) out.pop_back();
+            else if (on_same_edge(out.back(), out[0], out[1])) out.erase(out.begin());
+            else break;
+        }
+        if (out.size() >= 3) count += out.size() + 1;
+        ring.clear();
+    };
+    mapnik::vertex2d v(mapnik::vertex2d::no_init);
+    while ((v.cmd = clipped.vertex(&v.x, &v.y)) != mapnik::SEG_END)
+    {
+        if (v.cmd == mapnik::SEG_MOVETO)
+        {
+            flush();
+            ring.push_back(v);
+        }
+        else if (v.cmd == mapnik::SEG_LINETO)
+        {
+            ring.push_back(v);
+        }
+        else
+        {
+            flush();
+        }
+    }
+    flush();
+    return count;
+}
+
+class test2 : public benchmark::test_case
+{
+    std::string wkt_in_;
+    mapnik::box2d<double> extent_;
+    std::string expected_;
+public:
+    using conv_clip = mapnik::polygon_clipper<mapnik::geometry::polygon_vertex_adapter<double>>;
+    test2(mapnik::parameters const& params,
+          std::string const& wkt_in,
+          mapnik::box2d<double> const& extent)
+     : test_case(params),
+       wkt_in_(wkt_in),
+       extent_(extent),
+       expected_("./benchmark/data/polygon_clipping_mapnik") {}
+    bool validate() const
+    {
+        mapnik::geometry::geometry<double> geom;
+        if (!mapnik::from_wkt(wkt_in_, geom))
+        {
+            throw std::runtime_error("Failed to parse WKT");
+        }
+        if (!geom.is<mapnik::geometry::polygon<double>>())
+        {
+            std::clog << "not a polygon!\n";
+            return false;
+        }
+        mapnik::geometry::polygon<double> const& poly = mapnik::util::get<mapnik::geometry::polygon<double>>(geom);
+        mapnik::geometry::polygon_vertex_adapter<double> va(poly);
+        conv_clip clipped(va);
+        clipped.clip_box(
+                    extent_.minx(),
+                    extent_.miny(),
+                    extent_.maxx(),
+                    extent_.maxy());
+        clipped.rewind(0);
+        mapnik::geometry::polygon<double> poly2;
+        mapnik::geometry::linear_ring<double> ring;
+        unsigned cmd;
+        double x, y, x0 = 0, y0 = 0;
+        while ((cmd = clipped.vertex(&x, &y)) != mapnik::SEG_END)
+        {
+            if (cmd == mapnik::SEG_MOVETO)
+            {
+                x0 = x; y0 = y;
+            }
+            else if (cmd == mapnik::SEG_CLOSE)
+            {
+                ring.emplace_back(x0,y0);
+                poly2.push_back(std::move(ring));
+                ring.clear();
+                continue;
+            }
+            ring.emplace_back(x,y);
+        }
+        std::string expect = expected_+".png";
+        std::string actual = expected_+"_actual.png";
+        mapnik::geometry::multi_polygon<double> mp;
+        mp.emplace_back(poly2);
+        auto env = mapnik::geometry::envelope(mp);
+        if (!mapnik::util::exists(expect) || (std::getenv("UPDATE") != nullptr))
+        {
+            std::clog << "generating expected image: " << expect << "\n";
+            render(mp,env,expect);
+        }
+        render(mp,env,actual);
+        return benchmark::compare_images(actual,expect);
+    }
+    bool operator()() const
+    {
+        mapnik::geometry::geometry<double> geom;
+        if (!mapnik::from_wkt(wkt_in_, geom))
+        {
+            throw std::runtime_error("Failed to parse WKT");
+        }
+        if (!geom.is<mapnik::geometry::polygon<double>>())
+        {
+            std::clog << "not a polygon!\n";
+            return false;
+        }
+        bool valid = true;
+        mapnik::geometry::polygon<double> const& poly = mapnik::util::get<mapnik::geometry::polygon<double>>(geom);
+        unsigned expected_count = collapsed_agg_vertex_count(poly, extent_);
+        for (unsigned i=0;i<iterations_;++i)
+        {
+            unsigned count = 0;
+            mapnik::geometry::polygon_vertex_adapter<double> va(poly);
+            conv_clip clipped(va);
+            clipped.clip_box(
+                        extent_.minx(),
+                        extent_.miny(),
+                        extent_.maxx(),
+                        extent_.maxy());
+            unsigned cmd;
+            double x,y;
+            clipped.rewind(0);
+            while ((cmd = clipped.vertex(&x, &y)) != mapnik::SEG_END) {
+                count++;
+            }
+            if (count != expected_count) {
+                std::clog << "test2: clipping failed: processed " << count << " verticies but expected " << expected_count << "\n";
+                valid = false;
+            }
+        }
+        return valid;
+    }
+};
+
 class test3 : public benchmark::test_case
 {
     std::string wkt_in_;
@@ -533,6 +705,10 @@ int main(int argc, char** argv)
         test1 test_runner(params,wkt_in,clipping_box);
         return_value = return_value | run(test_runner,"clipping polygon with agg");
     }
+    {
+        test2 test_runner(params,wkt_in,clipping_box);
+        return_value = return_value | run(test_runner,"clipping polygon with mapnik::polygon_clipper");
+    }
     {
         test3 test_runner(params,wkt_in,clipping_box);
         return_value = return_value | run(test_runner,"clipping polygon with boost");
@@ -55,6 +55,9 @@ namespace mapnik {
   class proj_transform;
   struct rasterizer;
   struct rgba8_t;
+  struct transformed_path;
+  struct transformed_geometry_key;
+  class transformed_geometry_cache;
   template<typename T> class image;
 }
 
@@ -178,13 +181,11 @@ public:
                  mapnik::feature_impl & feature,
                  proj_transform const& prj_trans);
 
-    inline bool process(rule::symbolizers const&,
-                        mapnik::feature_impl&,
-                        proj_transform const& )
-    {
-        // agg renderer doesn't support processing of multiple symbolizers.
-        return false;
-    }
+    // agg renderer doesn't support processing of multiple symbolizers,
+    // only prepares sharing of transformed geometries between them
+    bool process(rule::symbolizers const& syms,
+                 mapnik::feature_impl & feature,
+                 proj_transform const& prj_trans);
 
     void painted(bool painted);
     bool painted();
@@ -199,6 +200,12 @@ public:
         return common_.scale_factor_;
     }
 
+    // geometries shared between the symbolizers of a rule
+    inline transformed_geometry_cache const& geometry_cache() const
+    {
+        return *common_.geometry_cache_;
+    }
+
     inline attributes const& variables() const
     {
         return common_.vars_;
@@ -220,6 +227,19 @@ private:
     double gamma_;
     renderer_common common_;
     void setup(Map const & m, buffer_type & pixmap);
+    // chain key (without clip box) of `sym` applied to `feature` and the
+    // padding its clip box needs; false for lines that never share their
+    // transformed geometry
+    bool line_geometry_key(line_symbolizer const& sym,
+                           mapnik::feature_impl & feature,
+                           proj_transform const& prj_trans,
+                           transformed_geometry_key & key,
+                           double & padding) const;
+    transformed_path const& transformed_geometry(line_symbolizer const& sym,
+                                                 mapnik::feature_impl & feature,
+                                                 proj_transform const& prj_trans,
+                                                 agg::trans_affine const& tr,
+                                                 transformed_geometry_key const& key);
 };
 
 extern template class MAPNIK_DECL agg_renderer<image<rgba8_t>>;
@@ -0,0 +1,162 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_FEATURE_CACHE_HPP
+#define MAPNIK_FEATURE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/datasource_geometry_type.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/featureset.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/query.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/optional.hpp>
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mapnik {
+
+// Binary feature cache stored next to a text data source (`<file>.fcache`).
+//
+// Host byte order layout (the header records it, caches written on a host
+// of the other byte order are rejected), all sections page (4096 bytes)
+// aligned:
+//
+//   header   : magic "mapnik-fcache" (16 bytes), u32 version, u32 number of
+//              columns, u64 number of features, double extent[4], u64 size
+//              of the source file, i32 geometry type (-1 = unknown), u32
+//              number of described columns, u64 offset/size of the columns,
+//              the R-tree and the features sections, i64 modification time
+//              of the source file, u32 byte order mark 0x01020304, u32
+//              length of the parse options and the options
+//   columns  : u8 attribute type, u32 name length, name (UTF-8); described
+//              columns (the source layer descriptor) come first
+//   R-tree   : packed Hilbert R-tree (see mapnik/util/packed_rtree.hpp) of
+//              feature_cache_entry
+//   features : per feature a u32 WKB size and the geometry as WKB (NDR), a
+//              u32 number of attributes and for each a u32 column index, a
+//              u8 value tag and the value (bool: u8, integer: i64,
+//              double: f64, string: u32 length + UTF-8)
+//
+// Caches are written by `mapnik-index --cache` and describe one version of
+// the source file, parsed with one set of options (feature_cache_source).
+struct feature_cache_entry
+{
+    std::uint64_t offset; // of the feature record, within the features section
+    std::uint64_t size;
+    std::int64_t id;
+};
+
+// Identifies the source a cache was built from: size and modification time
+// of the file, and the datasource parameters changing how it is parsed
+// (CSV separator, quote and headers).
+struct MAPNIK_DECL feature_cache_source
+{
+    std::uint64_t size = 0;
+    std::int64_t mtime = 0;
+    std::string options;
+
+    // none if the file can't be read
+    static boost::optional<feature_cache_source> from_file(std::string const& filename,
+                                                           parameters const& params);
+
+    bool operator==(feature_cache_source const& other) const
+    {
+        return size == other.size && mtime == other.mtime && options == other.options;
+    }
+};
+
+class MAPNIK_DECL feature_cache_writer : private util::noncopyable
+{
+public:
+    feature_cache_writer(layer_descriptor const& desc,
+                         boost::optional<datasource_geometry_t> const& geometry_type);
+    // features with an empty geometry are skipped
+    void add(feature_impl const& feature);
+    std::size_t size() const { return entries_.size(); }
+    void write(std::ostream & out, feature_cache_source const& source) const;
+private:
+    std::uint32_t column(std::string const& name, value const& val);
+    std::vector<std::pair<std::string, eAttributeType>> columns_;
+    std::unordered_map<std::string, std::uint32_t> column_index_;
+    std::uint32_t num_described_;
+    std::int32_t geometry_type_;
+    box2d<double> extent_;
+    std::vector<char> records_;
+    std::vector<std::pair<feature_cache_entry, box2d<float>>> entries_;
+};
+
+class MAPNIK_DECL feature_cache : public std::enable_shared_from_this<feature_cache>,
+                                  private util::noncopyable
+{
+public:
+    static std::string filename(std::string const& source_filename);
+    // cache of `source_filename` read with `params`, or nullptr when there
+    // is none or it does not match the current source file and parameters
+    static std::shared_ptr<feature_cache const> open(std::string const& source_filename,
+                                                     parameters const& params);
+    explicit feature_cache(std::shared_ptr<void const> const& storage, char const* data, std::size_t size);
+    box2d<double> const& envelope() const { return extent_; }
+    std::uint64_t size() const { return num_features_; }
+    feature_cache_source const& source() const { return source_; }
+    boost::optional<datasource_geometry_t> geometry_type() const;
+    // adds the columns of the source layer descriptor
+    void describe(layer_descriptor & desc) const;
+    // features intersecting the query box, in their original order
+    featureset_ptr features(query const& q) const;
+    feature_ptr read(feature_cache_entry const& entry) const;
+private:
+    std::shared_ptr<void const> storage_; // keeps `data_` alive
+    char const* data_;
+    std::size_t size_;
+    std::uint64_t num_features_;
+    feature_cache_source source_;
+    std::int32_t geometry_type_;
+    box2d<double> extent_;
+    std::vector<std::pair<std::string, eAttributeType>> columns_;
+    std::uint32_t num_described_;
+    char const* rtree_;
+    std::size_t rtree_size_;
+    char const* features_;
+    std::size_t features_size_;
+    context_ptr ctx_;
+};
+
+}
+
+#endif // MAPNIK_FEATURE_CACHE_HPP
@@ -0,0 +1,60 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_GEOMETRY_VERTEX_IMPORTANCE_HPP
+#define MAPNIK_GEOMETRY_VERTEX_IMPORTANCE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/geometry.hpp>
+
+// stl
+#include <vector>
+
+namespace mapnik { namespace geometry {
+
+// Visvalingam-Whyatt effective area of every coordinate of a geometry,
+// flattened in storage order (parts, rings, points). Line end points,
+// ring closing points and points get +infinity; rings never drop below
+// four points. Computed once for static sources, the annotation turns
+// scale dependent simplification into a single linear filtering pass.
+using vertex_importance = std::vector<double>;
+
+MAPNIK_DECL vertex_importance compute_vertex_importance(geometry<double> const& geom);
+
+// Copy of `geom` keeping only vertices with effective area >= min_area.
+// Vertices not covered by `importance` are always kept.
+MAPNIK_DECL geometry<double> filter_by_importance(geometry<double> const& geom,
+                                                  vertex_importance const& importance,
+                                                  double min_area);
+
+// Effective area (map units squared) of a triangle spanning `tolerance`
+// pixels at query resolution `res_x`, `res_y` (pixels per map unit).
+inline double importance_threshold(double res_x, double res_y, double tolerance)
+{
+    if (res_x <= 0.0 || res_y <= 0.0) return 0.0;
+    return (tolerance * tolerance) / (res_x * res_y);
+}
+
+}}
+
+#endif // MAPNIK_GEOMETRY_VERTEX_IMPORTANCE_HPP
@@ -28,6 +28,14 @@
 #include <cstring>
 #include <cmath>
 
+// Byte order of the target, as reported by the compiler. Hosts without
+// these macros (e.g. MSVC) are little endian.
+#if !defined(MAPNIK_BIG_ENDIAN) && defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define MAPNIK_BIG_ENDIAN
+#endif
+#endif
+
 namespace mapnik
 {
 
@@ -69,19 +77,39 @@ namespace mapnik
 // read int16_t NDR (little endian)
 inline void read_int16_ndr(const char* data, std::int16_t & val)
 {
+#ifndef MAPNIK_BIG_ENDIAN
     std::memcpy(&val,data,2);
+#else
+    val = static_cast<std::int16_t>((data[0]&0xff) | ((data[1]&0xff)<<8));
+#endif
 }
 
 // read int32_t NDR (little endian)
 inline void read_int32_ndr(const char* data, std::int32_t & val)
 {
+#ifndef MAPNIK_BIG_ENDIAN
     std::memcpy(&val,data,4);
+#else
+    val = (data[0]&0xff) | ((data[1]&0xff)<<8) | ((data[2]&0xff)<<16) | ((data[3]&0xff)<<24);
+#endif
 }
 
 // read double NDR (little endian)
 inline void read_double_ndr(const char* data, double & val)
 {
+#ifndef MAPNIK_BIG_ENDIAN
     std::memcpy(&val,&data[0],8);
+#else
+    std::int64_t bits = (static_cast<std::int64_t>(data[0]) & 0xff) |
+        (static_cast<std::int64_t>(data[1]) & 0xff) << 8   |
+        (static_cast<std::int64_t>(data[2]) & 0xff) << 16  |
+        (static_cast<std::int64_t>(data[3]) & 0xff) << 24  |
+        (static_cast<std::int64_t>(data[4]) & 0xff) << 32  |
+        (static_cast<std::int64_t>(data[5]) & 0xff) << 40  |
+        (static_cast<std::int64_t>(data[6]) & 0xff) << 48  |
+        (static_cast<std::int64_t>(data[7]) & 0xff) << 56  ;
+    std::memcpy(&val,&bits,8);
+#endif
 }
 
 // read int16_t XDR (big endian)
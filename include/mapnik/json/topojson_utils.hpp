@@ -34,11 +34,103 @@
 
 namespace mapnik { namespace topojson {
 
+// Decoded coordinates of one arc
+struct arc_span
+{
+    coordinate const* first;
+    coordinate const* last;
+    coordinate const* begin() const { return first; }
+    coordinate const* end() const { return last; }
+    std::size_t size() const { return static_cast<std::size_t>(last - first); }
+    bool empty() const { return first == last; }
+};
+
+struct arc_stats
+{
+    std::size_t num_arcs;
+    std::size_t num_coordinates;
+    std::size_t memory_usage; // bytes held by the decoded arcs
+};
+
+inline std::size_t num_arcs(topology const& topo)
+{
+    return topo.decoded.offsets.empty() ? topo.arcs.size() : topo.decoded.offsets.size() - 1;
+}
+
+// Delta decodes (quantized topologies only) and transforms an arc
+inline void decode_arc(arc const& a, boost::optional<transform> const& tr, std::vector<coordinate> & out)
+{
+    double px = 0, py = 0;
+    for (auto const& pt : a.coordinates)
+    {
+        if (tr)
+        {
+            out.push_back(coordinate{(px += pt.x) * (*tr).scale_x + (*tr).translate_x,
+                                     (py += pt.y) * (*tr).scale_y + (*tr).translate_y});
+        }
+        else
+        {
+            out.push_back(pt);
+        }
+    }
+}
+
+// Coordinates of arc `arc_index`: a view into the decoded arcs, or, if
+// decode_arcs() has not been run on the topology, decoded into `buffer`
+inline arc_span get_arc(topology const& topo, index_type arc_index, std::vector<coordinate> & buffer)
+{
+    if (!topo.decoded.offsets.empty())
+    {
+        coordinate const* data = topo.decoded.coordinates.data();
+        return arc_span{data + topo.decoded.offsets[arc_index], data + topo.decoded.offsets[arc_index + 1]};
+    }
+    buffer.clear();
+    decode_arc(topo.arcs[arc_index], topo.tr, buffer);
+    return arc_span{buffer.data(), buffer.data() + buffer.size()};
+}
+
+// Decodes every arc once into topo.decoded, so that arcs shared by
+// several geometries are not decoded again for each of them, and
+// releases the parsed arcs
+inline arc_stats decode_arcs(topology & topo)
+{
+    decoded_arcs & decoded = topo.decoded;
+    std::size_t count = 0;
+    for (auto const& a : topo.arcs) count += a.coordinates.size();
+    decoded.coordinates.clear();
+    decoded.coordinates.reserve(count);
+    decoded.offsets.clear();
+    decoded.offsets.reserve(topo.arcs.size() + 1);
+    decoded.offsets.push_back(0);
+    decoded.boxes.clear();
+    decoded.boxes.reserve(topo.arcs.size());
+    for (auto const& a : topo.arcs)
+    {
+        std::size_t start = decoded.coordinates.size();
+        decode_arc(a, topo.tr, decoded.coordinates);
+        decoded.offsets.push_back(decoded.coordinates.size());
+        box2d<double> box;
+        for (std::size_t i = start; i < decoded.coordinates.size(); ++i)
+        {
+            coordinate const& c = decoded.coordinates[i];
+            if (i == start) box.init(c.x, c.y, c.x, c.y);
+            else box.expand_to_include(c.x, c.y);
+        }
+        decoded.boxes.push_back(box);
+    }
+    topo.arcs.clear();
+    topo.arcs.shrink_to_fit();
+    return arc_stats{decoded.boxes.size(), decoded.coordinates.size(),
+                     decoded.coordinates.capacity() * sizeof(coordinate) +
+                     decoded.offsets.capacity() * sizeof(std::size_t) +
+                     decoded.boxes.capacity() * sizeof(box2d<double>)};
+}
+
 struct bounding_box_visitor
 {
     bounding_box_visitor(topology const& topo)
         : topo_(topo),
-          num_arcs_(topo_.arcs.size()) {}
+          num_arcs_(num_arcs(topo)) {}
 
     box2d<double> operator() (mapnik::topojson::empty const&) const
     {
@@ -88,78 +180,17 @@ struct bounding_box_visitor
     {
         box2d<double> bbox;
         bool first = true;
-        if (num_arcs_ > 0)
-        {
-            for (auto index : line.rings)
-            {
-                index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
-                if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                {
-
-                    double px = 0, py = 0;
-                    auto const& arcs = topo_.arcs[arc_index];
-                    for (auto pt : arcs.coordinates)
-                    {
-                        double x = pt.x;
-                        double y = pt.y;
-                        if (topo_.tr)
-                        {
-                            x =  (px += x) * (*topo_.tr).scale_x + (*topo_.tr).translate_x;
-                            y =  (py += y) * (*topo_.tr).scale_y + (*topo_.tr).translate_y;
-                        }
-                        if (first)
-                        {
-                            first = false;
-                            bbox.init(x, y, x, y);
-                        }
-                        else
-                        {
-                            bbox.expand_to_include(x, y);
-                        }
-                    }
-                }
-            }
-        }
+        expand(bbox, first, line.rings);
         return bbox;
     }
 
     box2d<double> operator() (mapnik::topojson::multi_linestring const& multi_line) const
     {
         box2d<double> bbox;
-        if (num_arcs_ > 0)
+        bool first = true;
+        for (auto const& line : multi_line.lines)
         {
-            bool first = true;
-            for (auto const& line : multi_line.lines)
-            {
-                for (auto index : line)
-                {
-                    index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
-                    if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                    {
-                        double px = 0, py = 0;
-                        auto const& arcs = topo_.arcs[arc_index];
-                        for (auto pt : arcs.coordinates)
-                        {
-                            double x = pt.x;
-                            double y = pt.y;
-                            if (topo_.tr)
-                            {
-                                x =  (px += x) * (*topo_.tr).scale_x + (*topo_.tr).translate_x;
-                                y =  (py += y) * (*topo_.tr).scale_y + (*topo_.tr).translate_y;
-                            }
-                            if (first)
-                            {
-                                first = false;
-                                bbox.init(x, y, x, y);
-                            }
-                            else
-                            {
-                                bbox.expand_to_include(x, y);
-                            }
-                        }
-                    }
-                }
-            }
+            expand(bbox, first, line);
         }
         return bbox;
     }
@@ -167,42 +198,10 @@ struct bounding_box_visitor
     box2d<double> operator() (mapnik::topojson::polygon const& poly) const
     {
         box2d<double> bbox;
-        if (num_arcs_ > 0)
+        bool first = true;
+        for (auto const& ring : poly.rings)
         {
-            bool first = true;
-            for (auto const& ring : poly.rings)
-            {
-                for (auto index : ring)
-                {
-                    index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
-                    if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                    {
-                        double px = 0, py = 0;
-                        auto const& arcs = topo_.arcs[arc_index];
-                        for (auto const& pt : arcs.coordinates)
-                        {
-                            double x = pt.x;
-                            double y = pt.y;
-
-                            if (topo_.tr)
-                            {
-                                x =  (px += x) * (*topo_.tr).scale_x + (*topo_.tr).translate_x;
-                                y =  (py += y) * (*topo_.tr).scale_y + (*topo_.tr).translate_y;
-                            }
-
-                            if (first)
-                            {
-                                first = false;
-                                bbox.init( x, y, x, y);
-                            }
-                            else
-                            {
-                                bbox.expand_to_include(x, y);
-                            }
-                        }
-                    }
-                }
-            }
+            expand(bbox, first, ring);
         }
         return bbox;
     }
@@ -210,51 +209,59 @@ struct bounding_box_visitor
     box2d<double> operator() (mapnik::topojson::multi_polygon const& multi_poly) const
     {
         box2d<double> bbox;
-        if (num_arcs_ > 0)
+        bool first = true;
+        for (auto const& poly : multi_poly.polygons)
         {
-            bool first = true;
-            for (auto const& poly : multi_poly.polygons)
+            for (auto const& ring : poly)
             {
-                for (auto const& ring : poly)
+                expand(bbox, first, ring);
+            }
+        }
+        return bbox;
+    }
+private:
+    void expand(box2d<double> & bbox, bool & first, std::vector<index_type> const& indices) const
+    {
+        for (auto index : indices)
+        {
+            index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
+            if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
+            {
+                if (!topo_.decoded.boxes.empty())
                 {
-                    for (auto index : ring)
+                    // decoded arcs come with their bounding box
+                    box2d<double> const& box = topo_.decoded.boxes[arc_index];
+                    if (!box.valid()) continue;
+                    if (first)
                     {
-                        index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
-                        if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                        {
-                            double px = 0, py = 0;
-                            auto const& arcs = topo_.arcs[arc_index];
-                            for (auto const& pt : arcs.coordinates)
-                            {
-                                double x = pt.x;
-                                double y = pt.y;
-
-                                if (topo_.tr)
-                                {
-                                    x =  (px += x) * (*topo_.tr).scale_x + (*topo_.tr).translate_x;
-                                    y =  (py += y) * (*topo_.tr).scale_y + (*topo_.tr).translate_y;
-                                }
-
-                                if (first)
-                                {
-                                    first = false;
-                                    bbox.init( x, y, x, y);
-                                }
-                                else
-                                {
-                                    bbox.expand_to_include(x, y);
-                                }
-                            }
-                        }
+                        first = false;
+                        bbox = box;
+                    }
+                    else
+                    {
+                        bbox.expand_to_include(box);
+                    }
+                    continue;
+                }
+                for (auto const& c : get_arc(topo_, arc_index, buffer_))
+                {
+                    if (first)
+                    {
+                        first = false;
+                        bbox.init(c.x, c.y, c.x, c.y);
+                    }
+                    else
+                    {
+                        bbox.expand_to_include(c.x, c.y);
                     }
                 }
             }
         }
-        return bbox;
     }
-private:
+
     topology const& topo_;
     std::size_t num_arcs_;
+    mutable std::vector<coordinate> buffer_;
 };
 
 namespace {
@@ -280,7 +287,7 @@ struct feature_generator
         : ctx_(ctx),
           tr_(tr),
           topo_(topo),
-          num_arcs_(topo.arcs.size()),
+          num_arcs_(num_arcs(topo)),
           feature_id_(feature_id) {}
 
     feature_ptr operator() (point const& pt) const
@@ -326,28 +333,7 @@ struct feature_generator
         if (num_arcs_ > 0)
         {
             mapnik::geometry::line_string<double> line_string;
-
-            for (auto index : line.rings)
-            {
-                index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
-                if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                {
-                    auto const& arcs = topo_.arcs[arc_index];
-                    double px = 0, py = 0;
-                    line_string.reserve(line_string.size() + arcs.coordinates.size());
-                    for (auto pt : arcs.coordinates)
-                    {
-                        double x = pt.x;
-                        double y = pt.y;
-                        if (topo_.tr)
-                        {
-                            x =  (px += x) * (*topo_.tr).scale_x + (*topo_.tr).translate_x;
-                            y =  (py += y) * (*topo_.tr).scale_y + (*topo_.tr).translate_y;
-                        }
-                        line_string.emplace_back(x,y);
-                    }
-                }
-            }
+            append_arcs(line_string, line.rings);
             feature->set_geometry(std::move(line_string));
             assign_properties(*feature, line, tr_);
         }
@@ -360,34 +346,12 @@ struct feature_generator
         if (num_arcs_ > 0)
         {
             mapnik::geometry::multi_line_string<double> multi_line_string;
+            multi_line_string.reserve(multi_line.lines.size());
             bool hit = false;
             for (auto const& line : multi_line.lines)
             {
-                multi_line_string.reserve(multi_line_string.size() + line.size());
                 mapnik::geometry::line_string<double> line_string;
-                for (auto index : line)
-                {
-                    index_type arc_index = index < 0 ? std::abs(index) - 1 : index;
-                    if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                    {
-                        hit = true;
-                        double px = 0, py = 0;
-                        auto const& arcs = topo_.arcs[arc_index];
-                        line_string.reserve(line_string.size() + arcs.coordinates.size());
-                        for (auto pt : arcs.coordinates)
-                        {
-                            double x = pt.x;
-                            double y = pt.y;
-                            if (topo_.tr)
-                            {
-                                x =  (px += x) * (*topo_.tr).scale_x + (*topo_.tr).translate_x;
-                                y =  (py += y) * (*topo_.tr).scale_y + (*topo_.tr).translate_y;
-                            }
-                            line_string.emplace_back(x, y);
-                        }
-
-                    }
-                }
+                if (append_arcs(line_string, line)) hit = true;
                 multi_line_string.push_back(std::move(line_string));
             }
             if (hit)
@@ -404,55 +368,13 @@ struct feature_generator
         mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx_,feature_id_));
         if (num_arcs_ > 0)
         {
-            std::vector<mapnik::topojson::coordinate> processed_coords;
             mapnik::geometry::polygon<double> polygon;
             polygon.reserve(poly.rings.size());
             bool hit = false;
             for (auto const& ring : poly.rings)
             {
                 mapnik::geometry::linear_ring<double> linear_ring;
-                for (auto const& index : ring)
-                {
-                    double px = 0, py = 0;
-                    bool reverse = index < 0;
-                    index_type arc_index = reverse ? std::abs(index) - 1 : index;
-                    if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                    {
-                        hit = true;
-                        auto const& arcs = topo_.arcs[arc_index];
-                        auto const& coords = arcs.coordinates;
-                        processed_coords.clear();
-                        processed_coords.reserve(coords.size());
-                        for (auto const& pt : coords )
-                        {
-                            double x = pt.x;
-                            double y = pt.y;
-
-                            if (topo_.tr)
-                            {
-                                transform const& tr = *topo_.tr;
-                                x =  (px += x) * tr.scale_x + tr.translate_x;
-                                y =  (py += y) * tr.scale_y + tr.translate_y;
-                            }
-                            processed_coords.emplace_back(coordinate{x,y});
-                        }
-                        linear_ring.reserve(linear_ring.size() + processed_coords.size());
-                        if (reverse)
-                        {
-                            for (auto const& c : processed_coords | boost::adaptors::reversed)
-                            {
-                                linear_ring.emplace_back(c.x, c.y);
-                            }
-                        }
-                        else
-                        {
-                            for (auto const& c : processed_coords)
-                            {
-                                linear_ring.emplace_back(c.x, c.y);
-                            }
-                        }
-                    }
-                }
+                if (append_arcs(linear_ring, ring)) hit = true;
                 polygon.push_back(std::move(linear_ring));
             }
             if (hit)
@@ -470,7 +392,6 @@ struct feature_generator
         mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx_,feature_id_));
         if (num_arcs_ > 0)
         {
-            std::vector<mapnik::topojson::coordinate> processed_coords;
             mapnik::geometry::multi_polygon<double> multi_polygon;
             multi_polygon.reserve(multi_poly.polygons.size());
             bool hit = false;
@@ -478,54 +399,10 @@ struct feature_generator
             {
                 mapnik::geometry::polygon<double> polygon;
                 polygon.reserve(poly.size());
-
                 for (auto const& ring : poly)
                 {
                     mapnik::geometry::linear_ring<double> linear_ring;
-                    for (auto const& index : ring)
-                    {
-                        double px = 0, py = 0;
-                        bool reverse = index < 0;
-                        index_type arc_index = reverse ? std::abs(index) - 1 : index;
-                        if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
-                        {
-                            hit = true;
-                            auto const& arcs = topo_.arcs[arc_index];
-                            auto const& coords = arcs.coordinates;
-                            processed_coords.clear();
-                            processed_coords.reserve(coords.size());
-                            for (auto const& pt : coords )
-                            {
-                                double x = pt.x;
-                                double y = pt.y;
-
-                                if (topo_.tr)
-                                {
-                                    transform const& tr = *topo_.tr;
-                                    x =  (px += x) * tr.scale_x + tr.translate_x;
-                                    y =  (py += y) * tr.scale_y + tr.translate_y;
-                                }
-                                processed_coords.emplace_back(coordinate{x,y});
-                            }
-
-                            using namespace boost::adaptors;
-                            linear_ring.reserve(linear_ring.size() + processed_coords.size());
-                            if (reverse)
-                            {
-                                for (auto const& c : (processed_coords | reversed))
-                                {
-                                    linear_ring.emplace_back(c.x, c.y);
-                                }
-                            }
-                            else
-                            {
-                                for (auto const& c : processed_coords)
-                                {
-                                    linear_ring.emplace_back(c.x, c.y);
-                                }
-                            }
-                        }
-                    }
+                    if (append_arcs(linear_ring, ring)) hit = true;
                     polygon.push_back(std::move(linear_ring));
                 }
                 multi_polygon.push_back(std::move(polygon));
@@ -546,11 +423,48 @@ struct feature_generator
         return feature_ptr();
     }
 
+    // Appends the arcs referenced by `indices` to `line`, a negative
+    // index standing for the reversed arc ~index. Returns true if any
+    // index refers to an existing arc.
+    template <typename Line>
+    bool append_arcs(Line & line, std::vector<index_type> const& indices) const
+    {
+        bool hit = false;
+        for (auto index : indices)
+        {
+            bool reverse = index < 0;
+            index_type arc_index = reverse ? std::abs(index) - 1 : index;
+            if (arc_index >= 0 && arc_index < static_cast<int>(num_arcs_))
+            {
+                hit = true;
+                arc_span coords = get_arc(topo_, arc_index, buffer_);
+                line.reserve(line.size() + coords.size());
+                if (reverse)
+                {
+                    for (auto itr = coords.end(); itr != coords.begin();)
+                    {
+                        --itr;
+                        line.emplace_back(itr->x, itr->y);
+                    }
+                }
+                else
+                {
+                    for (auto const& c : coords)
+                    {
+                        line.emplace_back(c.x, c.y);
+                    }
+                }
+            }
+        }
+        return hit;
+    }
+
     Context & ctx_;
     mapnik::transcoder const& tr_;
     topology const& topo_;
     std::size_t num_arcs_;
     std::size_t feature_id_;
+    mutable std::vector<coordinate> buffer_;
 };
 
 
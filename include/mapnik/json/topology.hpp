@@ -25,6 +25,7 @@
 
 #include <mapnik/json/json_value.hpp>
 #include <mapnik/util/variant.hpp>
+#include <mapnik/geometry/box2d.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -118,12 +119,23 @@ struct bounding_box
     double maxy;
 };
 
+// All arcs, delta decoded and transformed, back to back: arc i spans
+// coordinates [offsets[i], offsets[i + 1]) and is bounded by boxes[i].
+// Filled by decode_arcs() (see topojson_utils.hpp).
+struct decoded_arcs
+{
+    std::vector<coordinate> coordinates;
+    std::vector<std::size_t> offsets;
+    std::vector<box2d<double>> boxes;
+};
+
 struct topology
 {
     std::vector<geometry> geometries;
     std::vector<arc> arcs;
     boost::optional<transform> tr;
     boost::optional<bounding_box> bbox;
+    decoded_arcs decoded;
 };
 
 }}
@@ -26,9 +26,15 @@
 // mapnik
 #include <mapnik/datasource.hpp>
 #include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/vertex_importance_cache.hpp>
 
 // stl
 #include <deque>
+#include <memory>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
 
 namespace mapnik {
 
@@ -51,13 +57,26 @@ public:
     size_t size() const;
     void clear();
 private:
+    // R-tree over feature extents, built on the first query and kept up to
+    // date by push() afterwards
+    struct spatial_index;
+    // positions in features_ of features intersecting `box`, in push order
+    std::vector<std::size_t> query_index(box2d<double> const& box) const;
     std::deque<feature_ptr> features_;
+    // per-feature vertex importance, parallel to features_ (optional)
+    vertex_importance_cache importance_;
     mapnik::layer_descriptor desc_;
     datasource::datasource_t type_;
     bool bbox_check_;
     bool type_set_;
+    bool vertex_importance_;
+    double vertex_importance_tolerance_;
     mutable box2d<double> extent_;
     mutable bool dirty_extent_ = true;
+    mutable std::unique_ptr<spatial_index> tree_;
+#ifdef MAPNIK_THREADSAFE
+    mutable std::mutex tree_mutex_;
+#endif
 };
 
 }
@@ -27,6 +27,7 @@
 #include <mapnik/geometry/box2d.hpp>
 #include <mapnik/geometry.hpp>
 #include <mapnik/geometry/envelope.hpp>
+#include <mapnik/vertex_importance_cache.hpp>
 #include <mapnik/featureset.hpp>
 #include <mapnik/datasource.hpp>
 #include <mapnik/memory_datasource.hpp>
@@ -34,18 +35,39 @@
 #include <mapnik/raster.hpp>
 
 #include <deque>
+#include <vector>
 
 namespace mapnik {
 
 class memory_featureset : public Featureset
 {
 public:
-    memory_featureset(box2d<double> const& bbox, memory_datasource const& ds, bool bbox_check = true)
+    memory_featureset(box2d<double> const& bbox, memory_datasource const& ds, bool bbox_check = true,
+                      double min_importance = 0.0)
         : bbox_(bbox),
           pos_(ds.features_.begin()),
           end_(ds.features_.end()),
           type_(ds.type()),
-          bbox_check_(bbox_check)
+          bbox_check_(bbox_check),
+          importance_(min_importance > 0.0 && !ds.importance_.empty() ? &ds.importance_ : nullptr),
+          min_importance_(min_importance),
+          index_(0)
+    {}
+
+    // features at `positions` (as selected by the datasource spatial index)
+    memory_featureset(memory_datasource const& ds, std::vector<std::size_t> && positions,
+                      double min_importance = 0.0)
+        : bbox_(),
+          pos_(ds.features_.begin()),
+          end_(ds.features_.begin()),
+          type_(ds.type()),
+          bbox_check_(false),
+          importance_(min_importance > 0.0 && !ds.importance_.empty() ? &ds.importance_ : nullptr),
+          min_importance_(min_importance),
+          index_(0),
+          features_(&ds.features_),
+          positions_(std::move(positions)),
+          positions_itr_(positions_.begin())
     {}
 
     memory_featureset(box2d<double> const& bbox, std::deque<feature_ptr> const& features, bool bbox_check = true)
@@ -53,49 +75,73 @@ public:
           pos_(features.begin()),
           end_(features.end()),
           type_(datasource::Vector),
-          bbox_check_(bbox_check)
+          bbox_check_(bbox_check),
+          importance_(nullptr),
+          min_importance_(0.0),
+          index_(0)
     {}
 
     virtual ~memory_featureset() {}
 
     feature_ptr next()
     {
+        if (features_ != nullptr)
+        {
+            if (positions_itr_ == positions_.end()) return feature_ptr();
+            std::size_t index = *positions_itr_++;
+            feature_ptr const& feature = (*features_)[index];
+            return type_ == datasource::Raster ? feature : filtered(feature, index);
+        }
         while (pos_ != end_)
         {
+            std::size_t index = index_++;
+            feature_ptr const& feature = *pos_++;
             if (!bbox_check_)
             {
-                return *pos_++;
+                return filtered(feature, index);
             }
             else
             {
                 if (type_ == datasource::Raster)
                 {
-                    raster_ptr const& source = (*pos_)->get_raster();
+                    raster_ptr const& source = feature->get_raster();
                     if (source && bbox_.intersects(source->ext_))
                     {
-                        return *pos_++;
+                        return feature;
                     }
                 }
                 else
                 {
-                    geometry::geometry<double> const& geom = (*pos_)->get_geometry();
+                    geometry::geometry<double> const& geom = feature->get_geometry();
                     if (bbox_.intersects(geometry::envelope(geom)))
                     {
-                        return *pos_++;
+                        return filtered(feature, index);
                     }
                 }
-                ++pos_;
             }
         }
         return feature_ptr();
     }
 
 private:
+    // drop vertices which are not significant at the query resolution
+    feature_ptr filtered(feature_ptr const& feature, std::size_t index) const
+    {
+        if (importance_ == nullptr) return feature;
+        return importance_->filtered(feature, index, min_importance_);
+    }
+
     box2d<double> bbox_;
     std::deque<feature_ptr>::const_iterator pos_;
     std::deque<feature_ptr>::const_iterator end_;
     datasource::datasource_t type_;
     bool bbox_check_;
+    vertex_importance_cache const* importance_;
+    double min_importance_;
+    std::size_t index_;
+    std::deque<feature_ptr> const* features_ = nullptr;
+    std::vector<std::size_t> positions_;
+    std::vector<std::size_t>::const_iterator positions_itr_;
 };
 }
 
@@ -34,6 +34,7 @@
 // stl
 #include <cmath>
 #include <vector>
+#include <memory>
 #include <cstddef>
 #include <algorithm>
 
@@ -42,22 +43,107 @@ namespace mapnik
 
 static constexpr double offset_converter_default_threshold = 5.0;
 
+namespace detail {
+
+// Working storage of an offset_converter
+struct offset_converter_buffer
+{
+    std::vector<vertex2d> points;
+    std::vector<vertex2d> close_points;
+    std::vector<vertex2d> vertices;
+};
+
+// Per thread pool of offset_converter_buffers. A converter is created for
+// every geometry (part) rendered with an offset, taking its buffers from
+// the pool and handing them back when done means no allocations once the
+// pool is warmed up.
+class offset_converter_buffer_pool
+{
+    using buffer_ptr = std::unique_ptr<offset_converter_buffer>;
+    static constexpr std::size_t max_pooled = 16;
+    // don't hold on to memory for huge geometries
+    static constexpr std::size_t max_pooled_capacity = 1 << 16;
+
+public:
+    static buffer_ptr acquire()
+    {
+        auto * free_list = buffers();
+        if (!free_list || free_list->empty())
+        {
+            return buffer_ptr(new offset_converter_buffer);
+        }
+        buffer_ptr buffer = std::move(free_list->back());
+        free_list->pop_back();
+        return buffer;
+    }
+
+    static void release(buffer_ptr && buffer)
+    {
+        auto * free_list = buffers();
+        if (!buffer || !free_list || free_list->size() >= max_pooled) return;
+        release(buffer->points);
+        release(buffer->close_points);
+        release(buffer->vertices);
+        free_list->push_back(std::move(buffer));
+    }
+
+private:
+    struct free_list_type
+    {
+        std::vector<buffer_ptr> buffers;
+        bool & destroyed;
+        ~free_list_type() { destroyed = true; }
+    };
+
+    static void release(std::vector<vertex2d> & v)
+    {
+        v.clear();
+        if (v.capacity() > max_pooled_capacity) v.shrink_to_fit();
+    }
+
+    // nullptr once the thread's free list is destroyed: converters that
+    // outlive it (e.g. held by other thread_local objects) then own their
+    // buffers and free them on destruction
+    static std::vector<buffer_ptr> * buffers()
+    {
+        // trivially destructible, so it can still be read after the free list is gone
+        thread_local static bool destroyed = false;
+        if (destroyed) return nullptr;
+        thread_local static free_list_type free_list{{}, destroyed};
+        return &free_list.buffers;
+    }
+};
+
+} // namespace detail
+
 template <typename Geometry>
 struct offset_converter
 {
     using size_type = std::size_t;
 
     offset_converter(Geometry & geom)
-        : geom_(geom)
+        : geom_(&geom)
         , offset_(0.0)
         , threshold_(offset_converter_default_threshold)
         , half_turn_segments_(16)
         , status_(initial)
+        , pos_(0)
+        , buffer_(detail::offset_converter_buffer_pool::acquire())
         , pre_first_(vertex2d::no_init)
         , pre_(vertex2d::no_init)
         , cur_(vertex2d::no_init)
     {}
 
+    offset_converter(offset_converter const&) = delete;
+    offset_converter & operator=(offset_converter const&) = delete;
+    offset_converter(offset_converter &&) = default;
+    offset_converter & operator=(offset_converter &&) = default;
+
+    ~offset_converter()
+    {
+        detail::offset_converter_buffer_pool::release(std::move(buffer_));
+    }
+
     enum status
     {
         initial,
@@ -66,7 +152,7 @@ struct offset_converter
 
     unsigned type() const
     {
-        return static_cast<unsigned>(geom_.type());
+        return static_cast<unsigned>(geom_->type());
     }
 
     double get_offset() const
@@ -100,7 +186,7 @@ struct offset_converter
     {
         if (offset_ == 0.0)
         {
-            return geom_.vertex(x, y);
+            return geom_->vertex(x, y);
         }
 
         if (status_ == initial)
@@ -108,15 +194,15 @@ struct offset_converter
             init_vertices();
         }
 
-        if (pos_ >= vertices_.size())
+        if (pos_ >= buffer_->vertices.size())
         {
             return SEG_END;
         }
 
         pre_ = (pos_ ? cur_ : pre_first_);
-        cur_ = vertices_.at(pos_++);
+        cur_ = buffer_->vertices[pos_++];
 
-        if (pos_ == vertices_.size())
+        if (pos_ == buffer_->vertices.size())
         {
             return output_vertex(x, y);
         }
@@ -126,11 +212,11 @@ struct offset_converter
         double t = 1.0;
         double vt, ut;
 
-        for (size_t i = pos_; i+1 < vertices_.size(); ++i)
+        for (size_t i = pos_; i+1 < buffer_->vertices.size(); ++i)
         {
             //break; // uncomment this to see all the curls
 
-            vertex2d const& u0 = vertices_[i];
+            vertex2d const& u0 = buffer_->vertices[i];
 
             // End or beginning of a line or ring must not be filtered out
             // to not to join lines or rings together.
@@ -139,7 +225,7 @@ struct offset_converter
                 break;
             }
 
-            vertex2d const& u1 = vertices_[i+1];
+            vertex2d const& u1 = buffer_->vertices[i+1];
             double const dx = u0.x - cur_.x;
             double const dy = u0.y - cur_.y;
 
@@ -169,8 +255,8 @@ struct offset_converter
 
     void reset()
     {
-        geom_.rewind(0);
-        vertices_.clear();
+        geom_->rewind(0);
+        buffer_->vertices.clear();
         status_ = initial;
         pos_ = 0;
     }
@@ -377,11 +463,13 @@ private:
         vertex2d w(vertex2d::no_init);
         vertex2d start(vertex2d::no_init);
         vertex2d start_v2(vertex2d::no_init);
-        std::vector<vertex2d> points;
-        std::vector<vertex2d> close_points;
+        std::vector<vertex2d> & points = buffer_->points;
+        std::vector<vertex2d> & close_points = buffer_->close_points;
+        points.clear();
+        close_points.clear();
         bool is_polygon = false;
         std::size_t cpt = 0;
-        v0.cmd = geom_.vertex(&v0.x, &v0.y);
+        v0.cmd = geom_->vertex(&v0.x, &v0.y);
         v1 = v0;
         // PUSH INITIAL
         points.push_back(v0);
@@ -390,7 +478,7 @@ private:
             return status_ = process;
         }
         start = v0;
-        while ((v0.cmd = geom_.vertex(&v0.x, &v0.y)) != SEG_END)
+        while ((v0.cmd = geom_->vertex(&v0.x, &v0.y)) != SEG_END)
         {
             if (v0.cmd == SEG_CLOSE)
             {
@@ -649,16 +737,16 @@ private:
 
     void push_vertex(vertex2d const& v)
     {
-        vertices_.push_back(v);
+        buffer_->vertices.push_back(v);
     }
 
-    Geometry &              geom_;
+    Geometry *              geom_;
     double                  offset_;
     double                  threshold_;
     unsigned                half_turn_segments_;
     status                  status_;
     size_t                  pos_;
-    std::vector<vertex2d>   vertices_;
+    std::unique_ptr<detail::offset_converter_buffer> buffer_;
     vertex2d                start_;
     vertex2d                pre_first_;
     vertex2d                pre_;
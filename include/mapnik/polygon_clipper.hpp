@@ -0,0 +1,287 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_POLYGON_CLIPPER_HPP
+#define MAPNIK_POLYGON_CLIPPER_HPP
+
+// mapnik
+#include <mapnik/vertex.hpp>
+#include <mapnik/geometry/box2d.hpp>
+
+// stl
+#include <vector>
+
+namespace mapnik
+{
+
+// Rectangular polygon clipper (Sutherland-Hodgman specialised for an
+// axis-aligned box). Every ring is clipped independently, so holes are
+// handled naturally with both even-odd and non-zero filling. Unlike
+// agg::conv_clip_polygon, runs of vertices lying on the same clip edge
+// are collapsed, so rings that wander outside the box do not leave
+// zero-area edges along the boundary for the rasterizer to walk.
+// Rings entirely inside the box are passed through untouched and rings
+// entirely outside are dropped without any per-edge work.
+template <typename Geometry>
+struct polygon_clipper
+{
+    using coordinate_type = double;
+
+    polygon_clipper(Geometry & geom)
+        : geom_(geom),
+          box_(),
+          pos_(0),
+          has_next_start_(false),
+          close_pending_(false),
+          done_(false)
+    {}
+
+    void clip_box(double x0, double y0, double x1, double y1)
+    {
+        box_.init(x0, y0, x1, y1);
+    }
+
+    box2d<double> const& clip_box() const
+    {
+        return box_;
+    }
+
+    unsigned type() const
+    {
+        return static_cast<unsigned>(geom_.type());
+    }
+
+    void rewind(unsigned)
+    {
+        geom_.rewind(0);
+        ring_.clear();
+        pos_ = 0;
+        has_next_start_ = false;
+        close_pending_ = false;
+        done_ = false;
+    }
+
+    unsigned vertex(double * x, double * y)
+    {
+        for (;;)
+        {
+            if (pos_ < ring_.size())
+            {
+                vertex2d const& v = ring_[pos_];
+                *x = v.x;
+                *y = v.y;
+                return (pos_++ == 0) ? SEG_MOVETO : SEG_LINETO;
+            }
+            if (close_pending_)
+            {
+                close_pending_ = false;
+                *x = 0;
+                *y = 0;
+                return SEG_CLOSE;
+            }
+            if (done_) return SEG_END;
+            next_ring();
+        }
+    }
+
+private:
+    // read the next ring from the source and clip it into ring_
+    void next_ring()
+    {
+        ring_.clear();
+        pos_ = 0;
+        input_.clear();
+        if (has_next_start_)
+        {
+            input_.push_back(next_start_);
+            has_next_start_ = false;
+        }
+        vertex2d v(vertex2d::no_init);
+        for (;;)
+        {
+            v.cmd = geom_.vertex(&v.x, &v.y);
+            if (v.cmd == SEG_END)
+            {
+                done_ = true;
+                break;
+            }
+            else if (v.cmd == SEG_MOVETO)
+            {
+                if (!input_.empty())
+                {
+                    next_start_ = v;
+                    has_next_start_ = true;
+                    break;
+                }
+                input_.push_back(v);
+            }
+            else if (v.cmd == SEG_CLOSE)
+            {
+                break;
+            }
+            else if (!input_.empty())
+            {
+                input_.push_back(v);
+            }
+        }
+        // closing vertex is implicit
+        if (input_.size() > 1 && input_.front().x == input_.back().x
+            && input_.front().y == input_.back().y)
+        {
+            input_.pop_back();
+        }
+        if (input_.size() < 3) return;
+
+        box2d<double> ring_box(input_.front().x, input_.front().y,
+                               input_.front().x, input_.front().y);
+        for (auto const& p : input_) ring_box.expand_to_include(p.x, p.y);
+        if (box_.contains(ring_box))
+        {
+            ring_.swap(input_);
+        }
+        else if (box_.intersects(ring_box))
+        {
+            clip();
+            collapse_boundary_edges();
+        }
+        if (ring_.size() < 3)
+        {
+            ring_.clear();
+            return;
+        }
+        close_pending_ = true;
+    }
+
+    template <typename Inside, typename Intersect>
+    static void clip_edge(std::vector<vertex2d> const& in, std::vector<vertex2d> & out,
+                          Inside inside, Intersect intersect)
+    {
+        out.clear();
+        if (in.empty()) return;
+        vertex2d const* prev = &in.back();
+        bool prev_inside = inside(*prev);
+        for (auto const& curr : in)
+        {
+            bool curr_inside = inside(curr);
+            if (curr_inside)
+            {
+                if (!prev_inside) out.push_back(intersect(*prev, curr));
+                out.push_back(curr);
+            }
+            else if (prev_inside)
+            {
+                out.push_back(intersect(*prev, curr));
+            }
+            prev = &curr;
+            prev_inside = curr_inside;
+        }
+    }
+
+    void clip()
+    {
+        double const minx = box_.minx();
+        double const miny = box_.miny();
+        double const maxx = box_.maxx();
+        double const maxy = box_.maxy();
+        // intersection coordinates on the clip edge are assigned exactly,
+        // which is what makes collapse_boundary_edges() reliable
+        auto at_x = [] (vertex2d const& a, vertex2d const& b, double x)
+        {
+            return vertex2d(x, a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x), SEG_LINETO);
+        };
+        auto at_y = [] (vertex2d const& a, vertex2d const& b, double y)
+        {
+            return vertex2d(a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y), y, SEG_LINETO);
+        };
+        clip_edge(input_, ring_,
+                  [minx] (vertex2d const& p) { return p.x >= minx; },
+                  [&] (vertex2d const& a, vertex2d const& b) { return at_x(a, b, minx); });
+        clip_edge(ring_, input_,
+                  [maxx] (vertex2d const& p) { return p.x <= maxx; },
+                  [&] (vertex2d const& a, vertex2d const& b) { return at_x(a, b, maxx); });
+        clip_edge(input_, ring_,
+                  [miny] (vertex2d const& p) { return p.y >= miny; },
+                  [&] (vertex2d const& a, vertex2d const& b) { return at_y(a, b, miny); });
+        clip_edge(ring_, input_,
+                  [maxy] (vertex2d const& p) { return p.y <= maxy; },
+                  [&] (vertex2d const& a, vertex2d const& b) { return at_y(a, b, maxy); });
+        ring_.swap(input_);
+    }
+
+    bool on_same_edge(vertex2d const& a, vertex2d const& b, vertex2d const& c) const
+    {
+        return (a.x == b.x && b.x == c.x && (b.x == box_.minx() || b.x == box_.maxx()))
+            || (a.y == b.y && b.y == c.y && (b.y == box_.miny() || b.y == box_.maxy()));
+    }
+
+    // Drop duplicates and the middle vertex of any three consecutive
+    // vertices on the same clip edge. Such a vertex only contributes
+    // a collinear or back-tracking (zero-area) edge.
+    void collapse_boundary_edges()
+    {
+        input_.clear();
+        for (auto const& p : ring_)
+        {
+            if (!input_.empty() && input_.back().x == p.x && input_.back().y == p.y) continue;
+            while (input_.size() >= 2 && on_same_edge(input_[input_.size() - 2], input_.back(), p))
+            {
+                input_.pop_back();
+            }
+            input_.push_back(p);
+        }
+        // the ring wraps around: check the seam as well
+        std::size_t first = 0;
+        for (;;)
+        {
+            std::size_t size = input_.size() - first;
+            if (size < 3) break;
+            if (input_.back().x == input_[first].x && input_.back().y == input_[first].y)
+            {
+                input_.pop_back();
+            }
+            else if (on_same_edge(input_[input_.size() - 2], input_.back(), input_[first]))
+            {
+                input_.pop_back();
+            }
+            else if (on_same_edge(input_.back(), input_[first], input_[first + 1]))
+            {
+                ++first;
+            }
+            else break;
+        }
+        ring_.assign(input_.begin() + first, input_.end());
+    }
+
+    Geometry & geom_;
+    box2d<double> box_;
+    std::vector<vertex2d> input_;
+    std::vector<vertex2d> ring_;
+    std::size_t pos_;
+    vertex2d next_start_;
+    bool has_next_start_;
+    bool close_pending_;
+    bool done_;
+};
+
+}
+
+#endif // MAPNIK_POLYGON_CLIPPER_HPP
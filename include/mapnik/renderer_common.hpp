@@ -35,6 +35,7 @@ namespace mapnik {
   class label_collision_detector4;
   class Map;
   class request;
+  class transformed_geometry_cache;
 //  class attributes;
 }
 
@@ -64,6 +65,9 @@ struct renderer_common : private util::noncopyable
     box2d<double> query_extent_;
     view_transform t_;
     detector_ptr detector_;
+    // optional, set by renderers that share transformed geometries
+    // between symbolizers
+    std::shared_ptr<transformed_geometry_cache> geometry_cache_;
 
 protected:
     // it's desirable to keep this class implicitly noncopyable to prevent
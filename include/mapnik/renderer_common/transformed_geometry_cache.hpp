@@ -0,0 +1,364 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+
+#ifndef MAPNIK_TRANSFORMED_GEOMETRY_CACHE_HPP
+#define MAPNIK_TRANSFORMED_GEOMETRY_CACHE_HPP
+
+// mapnik
+#include <mapnik/feature.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/symbolizer_enumerations.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/simplify.hpp>
+#include <mapnik/view_transform.hpp>
+#include <mapnik/vertex.hpp>
+#include <mapnik/vertex_processor.hpp>
+#include <mapnik/geometry/geometry_type.hpp>
+#include <mapnik/geometry/geometry_types.hpp>
+#include <mapnik/renderer_common/apply_vertex_converter.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// agg
+#include <agg_trans_affine.h>
+
+// stl
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mapnik {
+
+// Screen space output of a vertex_converter chain for all parts of a
+// feature geometry, recorded as a single path.
+struct transformed_path
+{
+    std::vector<vertex2d> vertices;
+    geometry::geometry_types type = geometry::geometry_types::Unknown;
+};
+
+// Vertex source replaying a transformed_path, suitable as input to the
+// remaining (symbolizer specific) converters or straight to a rasterizer.
+struct transformed_path_adapter
+{
+    using value_type = double;
+
+    explicit transformed_path_adapter(transformed_path const& path)
+        : path_(path),
+          pos_(0) {}
+
+    unsigned vertex(double * x, double * y)
+    {
+        if (pos_ >= path_.vertices.size()) return SEG_END;
+        vertex2d const& v = path_.vertices[pos_++];
+        *x = v.x;
+        *y = v.y;
+        return v.cmd;
+    }
+
+    void rewind(unsigned)
+    {
+        pos_ = 0;
+    }
+
+    geometry::geometry_types type() const
+    {
+        return path_.type;
+    }
+
+private:
+    transformed_path const& path_;
+    std::size_t pos_;
+};
+
+namespace detail {
+
+struct transformed_path_recorder
+{
+    explicit transformed_path_recorder(transformed_path & path)
+        : path_(path) {}
+
+    template <typename Path>
+    void add_path(Path & path)
+    {
+        vertex2d v(vertex2d::no_init);
+        path.rewind(0);
+        while ((v.cmd = path.vertex(&v.x, &v.y)) != SEG_END)
+        {
+            path_.vertices.push_back(v);
+        }
+    }
+
+    transformed_path & path_;
+};
+
+}
+
+// Evaluated parameters of the common vertex_converter prefix (clip,
+// transform, affine_transform, simplify, smooth, offset_transform) for one
+// feature. Two chains with equal keys produce the same output, so the
+// result can be shared between symbolizers.
+struct transformed_geometry_key
+{
+    enum clip_type : std::uint8_t
+    {
+        no_clip,
+        clip_line,
+        clip_poly
+    };
+
+    value_integer feature_id = 0;
+    proj_transform const* prj_trans = nullptr;
+    bool prj_trans_equal = true;
+    clip_type clip = no_clip;
+    box2d<double> clip_box;
+    box2d<double> extent;
+    double scale_x = 0.0;
+    double scale_y = 0.0;
+    int view_offset = 0;
+    double affine[6] = {1.0, 0.0, 0.0, 1.0, 0.0, 0.0};
+    double scale_factor = 1.0;
+    double offset = 0.0;
+    double simplify_tolerance = 0.0;
+    simplify_algorithm_e simplify_algorithm = radial_distance;
+    double smooth = 0.0;
+    smooth_algorithm_enum smooth_algorithm = SMOOTH_ALGORITHM_BASIC;
+
+    bool operator==(transformed_geometry_key const& other) const
+    {
+        return feature_id == other.feature_id &&
+            prj_trans == other.prj_trans &&
+            prj_trans_equal == other.prj_trans_equal &&
+            clip == other.clip &&
+            (clip == no_clip || clip_box == other.clip_box) &&
+            extent == other.extent &&
+            scale_x == other.scale_x &&
+            scale_y == other.scale_y &&
+            view_offset == other.view_offset &&
+            std::equal(affine, affine + 6, other.affine) &&
+            scale_factor == other.scale_factor &&
+            offset == other.offset &&
+            simplify_tolerance == other.simplify_tolerance &&
+            (simplify_tolerance <= 0.0 || simplify_algorithm == other.simplify_algorithm) &&
+            smooth == other.smooth &&
+            (smooth <= 0.0 || smooth_algorithm == other.smooth_algorithm);
+    }
+};
+
+// Key of a chain applied to `feature` with `sym`, `t`, `prj_trans`,
+// geometry transform `tr` and scale factor. `clip` tells which clipping
+// converter is enabled, `offset` is the unscaled offset or 0 if the chain
+// has no offset_transform.
+template <typename Symbolizer>
+transformed_geometry_key transformed_geometry_config(Symbolizer const& sym,
+                                                     feature_impl const& feature,
+                                                     attributes const& vars,
+                                                     view_transform const& t,
+                                                     proj_transform const& prj_trans,
+                                                     agg::trans_affine const& tr,
+                                                     double scale_factor,
+                                                     transformed_geometry_key::clip_type clip,
+                                                     box2d<double> const& clip_box,
+                                                     double offset)
+{
+    transformed_geometry_key key;
+    key.feature_id = feature.id();
+    key.prj_trans = &prj_trans;
+    key.prj_trans_equal = prj_trans.equal();
+    key.clip = clip;
+    if (clip != transformed_geometry_key::no_clip) key.clip_box = clip_box;
+    key.extent = t.extent();
+    key.scale_x = t.scale_x();
+    key.scale_y = t.scale_y();
+    key.view_offset = t.offset();
+    tr.store_to(key.affine);
+    key.scale_factor = scale_factor;
+    key.offset = offset;
+    key.simplify_tolerance = get<value_double, keys::simplify_tolerance>(sym, feature, vars);
+    if (key.simplify_tolerance > 0.0)
+    {
+        key.simplify_algorithm = get<simplify_algorithm_e, keys::simplify_algorithm>(sym, feature, vars);
+    }
+    key.smooth = get<value_double, keys::smooth>(sym, feature, vars);
+    if (key.smooth > 0.0)
+    {
+        key.smooth_algorithm = get<smooth_algorithm_enum, keys::smooth_algorithm>(sym, feature, vars);
+    }
+    return key;
+}
+
+// Cache of transformed geometries for the symbolizers of one rule applied
+// to one feature, so that e.g. a casing and a fill line symbolizer run
+// reprojection, clipping and offsetting once.
+//
+// The renderer calls start_rule for every rule and feature, which drops all
+// entries, then registers the key (without clip box) of every symbolizer
+// that may draw from the cache with add_candidate. The cache is active only
+// if two candidates have equal keys; those symbolizers then clip to one box
+// padded by the largest padding among them (see shared), so that their full
+// keys match. Lookups compare the full transformed_geometry_key.
+class transformed_geometry_cache : private util::noncopyable
+{
+public:
+    explicit transformed_geometry_cache(std::size_t max_vertices = 1 << 20)
+        : max_vertices_(max_vertices),
+          num_vertices_(0),
+          active_(false),
+          hits_(0),
+          misses_(0) {}
+
+    void start_rule()
+    {
+        clear();
+    }
+
+    // `key` is the chain key of a symbolizer of the rule with the clip box
+    // not set, `padding` the amount its clip box needs to be padded by
+    void add_candidate(transformed_geometry_key const& key, double padding)
+    {
+        for (auto & item : candidates_)
+        {
+            if (item.key == key)
+            {
+                item.padding = std::max(item.padding, padding);
+                ++item.count;
+                active_ = true;
+                return;
+            }
+        }
+        candidates_.push_back(candidate{key, padding, 1});
+    }
+
+    // true if a symbolizer with `key` (clip box not set) shares its geometry
+    // with another symbolizer of the rule; `padding` is then set to the
+    // padding of the clip box all of them use
+    bool shared(transformed_geometry_key const& key, double & padding) const
+    {
+        if (!active_) return false;
+        for (auto const& item : candidates_)
+        {
+            if (item.key == key)
+            {
+                if (item.count < 2) return false;
+                padding = item.padding;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // false when no two symbolizers of the rule can share an entry
+    bool active() const
+    {
+        return active_;
+    }
+
+    // Return the output of `converter` applied to the geometry of `feature`,
+    // running the converter chain only if `key` hasn't been seen yet.
+    template <typename Converter>
+    transformed_path const& get(feature_impl const& feature,
+                                transformed_geometry_key const& key,
+                                Converter & converter)
+    {
+        for (auto const& item : paths_)
+        {
+            if (item.first == key)
+            {
+                ++hits_;
+                return item.second;
+            }
+        }
+        ++misses_;
+        transformed_path path;
+        record(feature, converter, path);
+        std::size_t size = path.vertices.size();
+        if (num_vertices_ + size > max_vertices_)
+        {
+            scratch_ = std::move(path);
+            return scratch_;
+        }
+        num_vertices_ += size;
+        paths_.emplace_back(key, std::move(path));
+        return paths_.back().second;
+    }
+
+    void clear()
+    {
+        candidates_.clear();
+        paths_.clear();
+        num_vertices_ = 0;
+        active_ = false;
+    }
+
+    std::size_t size() const { return paths_.size(); }
+    std::size_t hits() const { return hits_; }
+    std::size_t misses() const { return misses_; }
+
+private:
+    template <typename Converter>
+    static void record(feature_impl const& feature, Converter & converter, transformed_path & path)
+    {
+        geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
+        switch (type)
+        {
+        case geometry::geometry_types::MultiPoint:
+            path.type = geometry::geometry_types::Point;
+            break;
+        case geometry::geometry_types::MultiLineString:
+            path.type = geometry::geometry_types::LineString;
+            break;
+        case geometry::geometry_types::MultiPolygon:
+            path.type = geometry::geometry_types::Polygon;
+            break;
+        default:
+            path.type = type;
+        }
+        using recorder_type = detail::transformed_path_recorder;
+        using apply_vertex_converter_type = detail::apply_vertex_converter<Converter, recorder_type>;
+        using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
+        recorder_type recorder(path);
+        apply_vertex_converter_type apply(converter, recorder);
+        mapnik::util::apply_visitor(vertex_processor_type(apply), feature.get_geometry());
+    }
+
+    struct candidate
+    {
+        transformed_geometry_key key;
+        double padding;
+        std::size_t count;
+    };
+
+    std::vector<candidate> candidates_;
+    std::vector<std::pair<transformed_geometry_key, transformed_path>> paths_;
+    transformed_path scratch_;
+    std::size_t max_vertices_;
+    std::size_t num_vertices_;
+    bool active_;
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+} // namespace mapnik
+
+#endif // MAPNIK_TRANSFORMED_GEOMETRY_CACHE_HPP
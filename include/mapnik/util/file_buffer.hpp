@@ -0,0 +1,83 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_UTIL_FILE_BUFFER_HPP
+#define MAPNIK_UTIL_FILE_BUFFER_HPP
+
+// mapnik
+#include <mapnik/util/noncopyable.hpp>
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+#include <mapnik/mapped_memory_cache.hpp>
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+MAPNIK_DISABLE_WARNING_POP
+#endif
+
+// stl
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace mapnik { namespace util {
+
+// Encoded source file kept in memory by datasources which decode features
+// on demand: the file mapping with MAPNIK_MEMORY_MAPPED_FILE, the file
+// contents otherwise.
+class file_buffer : private util::noncopyable
+{
+public:
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+    using buffer_type = mapped_region_ptr;
+#else
+    using buffer_type = std::string;
+#endif
+
+    explicit file_buffer(buffer_type && buffer)
+        : buffer_(std::move(buffer)) {}
+
+    char const* data() const
+    {
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        return reinterpret_cast<char const*>(buffer_->get_address());
+#else
+        return buffer_.data();
+#endif
+    }
+
+    std::size_t size() const
+    {
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        return buffer_->get_size();
+#else
+        return buffer_.size();
+#endif
+    }
+
+private:
+    buffer_type buffer_;
+};
+
+}}
+
+#endif // MAPNIK_UTIL_FILE_BUFFER_HPP
@@ -0,0 +1,466 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_UTIL_PACKED_RTREE_HPP
+#define MAPNIK_UTIL_PACKED_RTREE_HPP
+
+// mapnik
+#include <mapnik/geometry/box2d.hpp>
+
+// stl
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mapnik { namespace util {
+
+// Static packed Hilbert R-tree, a successor of the quad_tree based
+// "mapnik-index" format. Items are sorted by the Hilbert index of their
+// centre and packed bottom-up into fixed fanout nodes, so a node is a
+// contiguous run of entries and needs no pointers: entry i of a branch
+// level describes node i of the level below. Levels start page aligned,
+// which lets the index be queried in place from a memory mapping.
+//
+// Layout (native little endian):
+//   0   char[16] magic "mapnik-prtree"
+//   16  uint32   version
+//   20  uint32   fanout
+//   24  uint32   number of levels (root level first, leaves last)
+//   28  uint32   sizeof(Value)
+//   32  uint64   number of items
+//   40  float[4] extent
+//   56  {uint64 offset, uint64 count} per level
+//   branch entry: box2d<float>; leaf entry: box2d<float> followed by Value
+
+static constexpr char packed_rtree_magic[] = "mapnik-prtree";
+static constexpr std::uint32_t packed_rtree_version = 1;
+static constexpr std::uint32_t packed_rtree_default_fanout = 64;
+static constexpr std::size_t packed_rtree_page_size = 4096;
+static constexpr std::size_t packed_rtree_max_levels = 32;
+
+// Hilbert curve index of (x, y) on a 2^16 x 2^16 grid
+inline std::uint64_t hilbert_index(std::uint32_t x, std::uint32_t y)
+{
+    std::uint32_t const n = 1 << 16;
+    std::uint64_t d = 0;
+    for (std::uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        std::uint32_t rx = (x & s) > 0 ? 1 : 0;
+        std::uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Z-order (Morton) index of (x, y) on a 2^16 x 2^16 grid
+inline std::uint64_t zorder_index(std::uint32_t x, std::uint32_t y)
+{
+    auto spread = [](std::uint64_t v)
+    {
+        v &= 0xffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+namespace detail {
+
+// position of the centre of `box` on a 2^16 x 2^16 grid covering `extent`
+template <typename T>
+std::pair<std::uint32_t, std::uint32_t> grid_position(box2d<T> const& box, box2d<T> const& extent)
+{
+    double const max = (1 << 16) - 1;
+    double w = extent.width();
+    double h = extent.height();
+    double x = w > 0 ? max * ((box.minx() + box.maxx()) / 2.0 - extent.minx()) / w : 0;
+    double y = h > 0 ? max * ((box.miny() + box.maxy()) / 2.0 - extent.miny()) / h : 0;
+    x = std::min(std::max(x, 0.0), max);
+    y = std::min(std::max(y, 0.0), max);
+    return { static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y) };
+}
+
+} // namespace detail
+
+// Hilbert index of the centre of `box` within `extent`
+template <typename T>
+std::uint64_t hilbert_index(box2d<T> const& box, box2d<T> const& extent)
+{
+    auto pos = detail::grid_position(box, extent);
+    return hilbert_index(pos.first, pos.second);
+}
+
+// Z-order index of the centre of `box` within `extent`
+template <typename T>
+std::uint64_t zorder_index(box2d<T> const& box, box2d<T> const& extent)
+{
+    auto pos = detail::grid_position(box, extent);
+    return zorder_index(pos.first, pos.second);
+}
+
+namespace detail {
+
+struct packed_rtree_level
+{
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct packed_rtree_header
+{
+    std::uint32_t fanout = 0;
+    std::uint32_t value_size = 0;
+    std::uint64_t num_items = 0;
+    box2d<float> extent;
+    std::vector<packed_rtree_level> levels;
+};
+
+template <typename T>
+inline void write_pod(char * data, T const& val)
+{
+    std::memcpy(data, &val, sizeof(T));
+}
+
+template <typename T>
+inline T read_pod(char const* data)
+{
+    T val;
+    std::memcpy(&val, data, sizeof(T));
+    return val;
+}
+
+inline box2d<float> read_box(char const* data)
+{
+    float c[4];
+    std::memcpy(c, data, sizeof(c));
+    return box2d<float>(c[0], c[1], c[2], c[3]);
+}
+
+inline void write_box(char * data, box2d<float> const& box)
+{
+    float c[4] = { box.minx(), box.miny(), box.maxx(), box.maxy() };
+    std::memcpy(data, c, sizeof(c));
+}
+
+inline bool parse_packed_rtree_header(char const* data, std::size_t size, packed_rtree_header & header)
+{
+    if (size < packed_rtree_page_size) return false;
+    if (std::strncmp(data, packed_rtree_magic, 16) != 0) return false;
+    if (read_pod<std::uint32_t>(data + 16) != packed_rtree_version) return false;
+    header.fanout = read_pod<std::uint32_t>(data + 20);
+    std::uint32_t num_levels = read_pod<std::uint32_t>(data + 24);
+    header.value_size = read_pod<std::uint32_t>(data + 28);
+    header.num_items = read_pod<std::uint64_t>(data + 32);
+    header.extent = read_box(data + 40);
+    if (header.fanout < 2 || num_levels > packed_rtree_max_levels) return false;
+    header.levels.clear();
+    for (std::uint32_t i = 0; i < num_levels; ++i)
+    {
+        char const* p = data + 56 + i * 16;
+        header.levels.push_back({read_pod<std::uint64_t>(p), read_pod<std::uint64_t>(p + 8)});
+    }
+    return true;
+}
+
+// node access straight from memory
+struct packed_rtree_memory_source
+{
+    packed_rtree_memory_source(char const* data, std::size_t size)
+        : data_(data), size_(size) {}
+
+    char const* read(std::uint64_t offset, std::size_t length)
+    {
+        if (offset + length > size_) throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        return data_ + offset;
+    }
+
+    char const* data_;
+    std::size_t size_;
+};
+
+// node access through a stream, one read per visited node
+template <typename InputStream>
+struct packed_rtree_stream_source
+{
+    explicit packed_rtree_stream_source(InputStream & in)
+        : in_(in) {}
+
+    char const* read(std::uint64_t offset, std::size_t length)
+    {
+        buffer_.resize(length);
+        in_.seekg(offset, std::ios::beg);
+        in_.read(buffer_.data(), length);
+        if (!in_) throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        return buffer_.data();
+    }
+
+    InputStream & in_;
+    std::vector<char> buffer_;
+};
+
+} // namespace detail
+
+inline bool check_packed_rtree(char const* data, std::size_t size)
+{
+    detail::packed_rtree_header header;
+    return detail::parse_packed_rtree_header(data, size, header);
+}
+
+template <typename InputStream>
+bool check_packed_rtree(InputStream & in)
+{
+    char header[16];
+    std::memset(header, 0, 16);
+    in.read(header, 16);
+    return (std::strncmp(header, packed_rtree_magic, 16) == 0);
+}
+
+template <typename Value>
+class packed_rtree_builder
+{
+    static_assert(std::is_standard_layout<Value>::value, "Values stored in packed R-tree must be standard layout type");
+public:
+    explicit packed_rtree_builder(box2d<float> const& extent,
+                                  std::uint32_t fanout = packed_rtree_default_fanout)
+        : extent_(extent),
+          fanout_(std::max(fanout, 2u)) {}
+
+    void insert(Value const& value, box2d<float> const& box)
+    {
+        items_.push_back({hilbert_index(box, extent_), box, value});
+    }
+
+    std::size_t count() const { return items_.size(); }
+
+    // sorts items in Hilbert order and serialises the tree
+    template <typename OutputStream>
+    void write(OutputStream & out)
+    {
+        std::stable_sort(items_.begin(), items_.end(),
+                         [](item const& a, item const& b) { return a.hilbert < b.hilbert; });
+        // build levels bottom up
+        std::vector<std::vector<box2d<float>>> branch_levels;
+        std::vector<box2d<float>> boxes;
+        boxes.reserve(items_.size());
+        for (auto const& i : items_) boxes.push_back(i.box);
+        while (boxes.size() > fanout_)
+        {
+            std::vector<box2d<float>> parents;
+            parents.reserve((boxes.size() + fanout_ - 1) / fanout_);
+            for (std::size_t i = 0; i < boxes.size(); i += fanout_)
+            {
+                box2d<float> box = boxes[i];
+                std::size_t end = std::min(boxes.size(), i + fanout_);
+                for (std::size_t j = i + 1; j < end; ++j) box.expand_to_include(boxes[j]);
+                parents.push_back(box);
+            }
+            branch_levels.push_back(parents);
+            boxes = std::move(parents);
+        }
+        std::reverse(branch_levels.begin(), branch_levels.end());
+        std::size_t num_levels = branch_levels.size() + 1;
+        if (num_levels > packed_rtree_max_levels) throw std::runtime_error("packed R-tree: too many levels");
+
+        std::size_t const leaf_entry_size = 16 + sizeof(Value);
+        std::vector<detail::packed_rtree_level> levels;
+        std::uint64_t offset = packed_rtree_page_size;
+        auto page_align = [](std::uint64_t pos)
+        {
+            return (pos + packed_rtree_page_size - 1) / packed_rtree_page_size * packed_rtree_page_size;
+        };
+        for (auto const& level : branch_levels)
+        {
+            levels.push_back({offset, level.size()});
+            offset = page_align(offset + level.size() * 16);
+        }
+        levels.push_back({offset, items_.size()});
+
+        std::vector<char> header(packed_rtree_page_size, 0);
+        std::memcpy(header.data(), packed_rtree_magic, sizeof(packed_rtree_magic));
+        detail::write_pod(header.data() + 16, packed_rtree_version);
+        detail::write_pod(header.data() + 20, fanout_);
+        detail::write_pod(header.data() + 24, static_cast<std::uint32_t>(num_levels));
+        detail::write_pod(header.data() + 28, static_cast<std::uint32_t>(sizeof(Value)));
+        detail::write_pod(header.data() + 32, static_cast<std::uint64_t>(items_.size()));
+        detail::write_box(header.data() + 40, extent_);
+        for (std::size_t i = 0; i < levels.size(); ++i)
+        {
+            detail::write_pod(header.data() + 56 + i * 16, levels[i].offset);
+            detail::write_pod(header.data() + 56 + i * 16 + 8, levels[i].count);
+        }
+        out.write(header.data(), header.size());
+
+        std::uint64_t pos = packed_rtree_page_size;
+        std::vector<char> buffer;
+        for (std::size_t l = 0; l < branch_levels.size(); ++l)
+        {
+            buffer.assign(levels[l].offset - pos + branch_levels[l].size() * 16, 0);
+            char * p = buffer.data() + (levels[l].offset - pos);
+            for (auto const& box : branch_levels[l])
+            {
+                detail::write_box(p, box);
+                p += 16;
+            }
+            out.write(buffer.data(), buffer.size());
+            pos += buffer.size();
+        }
+        buffer.assign(levels.back().offset - pos + leaf_entry_size, 0);
+        out.write(buffer.data(), levels.back().offset - pos);
+        for (auto const& i : items_)
+        {
+            detail::write_box(buffer.data(), i.box);
+            std::memcpy(buffer.data() + 16, &i.value, sizeof(Value));
+            out.write(buffer.data(), leaf_entry_size);
+        }
+    }
+
+    // items in Hilbert order, valid after write()
+    template <typename F>
+    void for_each(F && f) const
+    {
+        for (auto const& i : items_) f(i.value, i.box);
+    }
+
+private:
+    struct item
+    {
+        std::uint64_t hilbert;
+        box2d<float> box;
+        Value value;
+    };
+    box2d<float> extent_;
+    std::uint32_t fanout_;
+    std::vector<item> items_;
+};
+
+template <typename Value, typename Filter>
+class packed_rtree
+{
+    static_assert(std::is_standard_layout<Value>::value, "Values stored in packed R-tree must be standard layout type");
+public:
+    // query an index mapped in memory, without any copying of nodes
+    static void query(Filter const& filter, char const* data, std::size_t size, std::vector<Value> & results)
+    {
+        detail::packed_rtree_header header;
+        if (!detail::parse_packed_rtree_header(data, size, header))
+        {
+            throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        }
+        detail::packed_rtree_memory_source source(data, size);
+        query_impl(filter, header, source, results);
+    }
+
+    template <typename InputStream>
+    static void query(Filter const& filter, InputStream & in, std::vector<Value> & results)
+    {
+        std::vector<char> buffer(packed_rtree_page_size);
+        in.seekg(0, std::ios::beg);
+        in.read(buffer.data(), buffer.size());
+        detail::packed_rtree_header header;
+        if (!in || !detail::parse_packed_rtree_header(buffer.data(), buffer.size(), header))
+        {
+            throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        }
+        detail::packed_rtree_stream_source<InputStream> source(in);
+        query_impl(filter, header, source, results);
+    }
+
+    static box2d<float> bounding_box(char const* data, std::size_t size)
+    {
+        detail::packed_rtree_header header;
+        if (!detail::parse_packed_rtree_header(data, size, header))
+        {
+            throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        }
+        return header.extent;
+    }
+
+private:
+    template <typename Source>
+    static void query_impl(Filter const& filter, detail::packed_rtree_header const& header,
+                           Source & source, std::vector<Value> & results)
+    {
+        if (header.levels.empty() || header.num_items == 0) return;
+        if (header.value_size != sizeof(Value))
+        {
+            throw std::runtime_error("Invalid index file (regenerate with shapeindex)");
+        }
+        using value_type = typename Filter::value_type;
+        std::size_t const fanout = header.fanout;
+        std::size_t const leaf_entry_size = 16 + sizeof(Value);
+        std::vector<std::uint64_t> nodes(1, 0);
+        std::vector<std::uint64_t> next;
+        for (std::size_t l = 0; l < header.levels.size(); ++l)
+        {
+            auto const& level = header.levels[l];
+            bool leaf = (l + 1 == header.levels.size());
+            std::size_t entry_size = leaf ? leaf_entry_size : 16;
+            next.clear();
+            for (auto node : nodes)
+            {
+                std::uint64_t begin = node * fanout;
+                if (begin >= level.count) continue;
+                std::uint64_t end = std::min<std::uint64_t>(begin + fanout, level.count);
+                char const* p = source.read(level.offset + begin * entry_size,
+                                            static_cast<std::size_t>((end - begin) * entry_size));
+                for (std::uint64_t i = begin; i < end; ++i, p += entry_size)
+                {
+                    box2d<float> box = detail::read_box(p);
+                    if (!filter.pass(box2d<value_type>(box.minx(), box.miny(), box.maxx(), box.maxy()))) continue;
+                    if (leaf)
+                    {
+                        Value item;
+                        std::memcpy(&item, p + 16, sizeof(Value));
+                        results.push_back(std::move(item));
+                    }
+                    else
+                    {
+                        next.push_back(i);
+                    }
+                }
+            }
+            nodes.swap(next);
+        }
+    }
+};
+
+}}
+
+#endif // MAPNIK_UTIL_PACKED_RTREE_HPP
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_UTIL_PARALLEL_FOR_HPP
+#define MAPNIK_UTIL_PARALLEL_FOR_HPP
+
+// stl
+#include <algorithm>
+#include <cstddef>
+#ifdef MAPNIK_THREADSAFE
+#include <exception>
+#include <future>
+#include <thread>
+#include <vector>
+#endif
+
+namespace mapnik { namespace util {
+
+// Number of threads parallel_for() may use
+inline std::size_t parallel_concurrency()
+{
+#ifdef MAPNIK_THREADSAFE
+    return std::max(1u, std::thread::hardware_concurrency());
+#else
+    return 1;
+#endif
+}
+
+// Calls `f(first, last)` on consecutive sub-ranges of [0, count) covering
+// it exactly once. Sub-ranges are processed on worker threads (one of them
+// on the calling thread) when built with MAPNIK_THREADSAFE and each would
+// get at least `min_chunk` items, otherwise `f(0, count)` is called
+// directly. The first exception thrown by `f` is rethrown once all
+// sub-ranges have finished.
+template <typename F>
+void parallel_for(std::size_t count, std::size_t min_chunk, F && f)
+{
+    if (count == 0) return;
+#ifdef MAPNIK_THREADSAFE
+    std::size_t chunks = std::min(parallel_concurrency(), count / std::max<std::size_t>(1, min_chunk));
+    if (chunks > 1)
+    {
+        std::size_t chunk = (count + chunks - 1) / chunks;
+        std::vector<std::future<void>> workers;
+        for (std::size_t first = chunk; first < count; first += chunk)
+        {
+            std::size_t last = std::min(count, first + chunk);
+            workers.push_back(std::async(std::launch::async, [&f, first, last]() { f(first, last); }));
+        }
+        std::exception_ptr error;
+        try
+        {
+            f(0, chunk);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        for (auto & worker : workers)
+        {
+            try
+            {
+                worker.get();
+            }
+            catch (...)
+            {
+                if (!error) error = std::current_exception();
+            }
+        }
+        if (error) std::rethrow_exception(error);
+        return;
+    }
+#endif
+    f(0, count);
+}
+
+}}
+
+#endif // MAPNIK_UTIL_PARALLEL_FOR_HPP
@@ -38,6 +38,9 @@
 #include <mapnik/symbolizer.hpp>
 #include <mapnik/extend_converter.hpp>
 #include <mapnik/adaptive_smooth.hpp>
+#if defined(MAPNIK_POLYGON_CLIPPER)
+#include <mapnik/polygon_clipper.hpp>
+#endif
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -201,7 +204,12 @@ template <typename T>
 struct converter_traits<T,mapnik::clip_poly_tag>
 {
     using geometry_type = T;
+#if defined(MAPNIK_POLYGON_CLIPPER)
+    // opt-in (POLYGON_CLIPPER=True): output differs from agg along the clip box
+    using conv_type = polygon_clipper<geometry_type>;
+#else
     using conv_type = typename agg::conv_clip_polygon<geometry_type>;
+#endif
     template <typename Args>
     static void setup(geometry_type & geom, Args const& args)
     {
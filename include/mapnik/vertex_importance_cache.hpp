@@ -0,0 +1,76 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_VERTEX_IMPORTANCE_CACHE_HPP
+#define MAPNIK_VERTEX_IMPORTANCE_CACHE_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/geometry/vertex_importance.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <deque>
+#include <utility>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
+
+namespace mapnik {
+
+// Vertex importance of the features of a static source, in the order they
+// were added, together with the thinned copies already handed out.
+// Thresholds are rounded down to a power of two (a zoom band), so all
+// queries within a band share one copy of a feature and never lose a
+// vertex they would have kept. A feature losing no vertex at a given
+// threshold is returned as is, without any copy.
+class MAPNIK_DECL vertex_importance_cache : private util::noncopyable
+{
+public:
+    void push_back(geometry::geometry<double> const& geom);
+    std::size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    void clear();
+    // `feature`, added at position `index`, without the vertices whose
+    // effective area is below `min_area`
+    feature_ptr filtered(feature_ptr const& feature, std::size_t index, double min_area) const;
+
+private:
+    struct entry
+    {
+        geometry::vertex_importance importance;
+        // smallest finite effective area, nothing is dropped below it
+        double min_area;
+        // (band, thinned feature), a handful at most
+        mutable std::vector<std::pair<int, feature_ptr>> bands;
+    };
+    std::deque<entry> entries_;
+#ifdef MAPNIK_THREADSAFE
+    mutable std::mutex mutex_;
+#endif
+};
+
+}
+
+#endif // MAPNIK_VERTEX_IMPORTANCE_CACHE_HPP
@@ -47,7 +47,8 @@ enum wkbFormat : std::uint8_t
 {
     wkbAuto=1,
     wkbGeneric=2,
-    wkbSpatiaLite=3
+    wkbSpatiaLite=3,
+    wkbGeoPackage=4
 };
 
 enum wkbByteOrder : std::uint8_t
@@ -56,6 +57,10 @@ enum wkbByteOrder : std::uint8_t
     wkbNDR=1
 };
 
+// Size of the GeoPackage binary header (magic, flags, srs_id and optional
+// envelope) in front of the WKB, or 0 when the blob has no valid header.
+MAPNIK_DECL std::size_t geopackage_header_size(char const* data, std::size_t size);
+
 class MAPNIK_DECL geometry_utils : private util::noncopyable
 {
 public:
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_WKB_VIEW_HPP
+#define MAPNIK_WKB_VIEW_HPP
+
+// mapnik
+#include <mapnik/config.hpp>
+#include <mapnik/wkb.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/geometry/geometry_types.hpp>
+
+// stl
+#include <cstddef>
+#include <cstdint>
+
+namespace mapnik {
+
+// Lightweight, non-owning view over a WKB (SpatiaLite or GeoPackage) blob.
+// Nothing is decoded up front: the envelope and the vertices are
+// read straight from the source bytes when asked for, so the buffer
+// (e.g. a database row) must outlive the view.
+class MAPNIK_DECL wkb_view
+{
+public:
+    wkb_view(char const* wkb, std::size_t size, wkbFormat format = wkbGeneric);
+
+    // pointer/size of the complete blob, including any SpatiaLite/GeoPackage header
+    char const* data() const { return wkb_; }
+    std::size_t size() const { return size_; }
+    // byte offset of the top-level geometry type word
+    std::size_t offset() const { return offset_; }
+    wkbFormat format() const { return format_; }
+    bool need_swap() const { return need_swap_; }
+    bool valid() const { return offset_ + 4 <= size_; }
+
+    geometry::geometry_types type() const;
+    // true when there is not a single vertex to render
+    bool is_empty() const;
+    // Scans coordinates without materialising the geometry.
+    // SpatiaLite and GeoPackage blobs usually carry their MBR in the header so no
+    // coordinates are read at all.
+    box2d<double> envelope() const;
+    // Fully decodes the geometry (equivalent to geometry_utils::from_wkb)
+    geometry::geometry<double> to_geometry() const;
+
+private:
+    char const* wkb_;
+    std::size_t size_;
+    std::size_t offset_;
+    wkbFormat format_;
+    bool need_swap_;
+};
+
+namespace geometry {
+
+// Vertex source decoding coordinates on the fly from a wkb_view.
+// Emits the same command sequence as the point/line_string/polygon
+// vertex adapters so it can be plugged into vertex_converter directly.
+// Nested multi-geometries and collections are flattened.
+// NOTE: unlike geometry_utils::from_wkb, ring orientation is not corrected.
+class MAPNIK_DECL wkb_vertex_adapter
+{
+public:
+    using coordinate_type = double;
+    explicit wkb_vertex_adapter(wkb_view const& view);
+    unsigned vertex(coordinate_type * x, coordinate_type * y) const;
+    void rewind(unsigned) const;
+    geometry_types type() const;
+private:
+    bool next_geometry() const;
+    void read_xy(coordinate_type * x, coordinate_type * y) const;
+    std::uint32_t read_uint32() const;
+
+    wkb_view view_; // held by value: only a pointer and a size
+    geometry_types type_;
+    mutable std::size_t pos_;
+    mutable std::size_t pending_;       // geometries still to be visited
+    mutable std::size_t rings_left_;    // rings left in the current polygon
+    mutable std::size_t points_left_;   // points left in the current part
+    mutable std::size_t stride_;        // bytes per coordinate tuple
+    mutable geometry_types current_;    // type of the current leaf geometry
+    mutable bool start_part_;
+};
+
+} // namespace geometry
+} // namespace mapnik
+
+#endif // MAPNIK_WKB_VIEW_HPP
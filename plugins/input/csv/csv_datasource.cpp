@@ -113,12 +113,29 @@ csv_datasource::csv_datasource(parameters const& params)
             filename_ = *file;
 
         has_disk_index_ = mapnik::util::exists(filename_ + ".index");
+        // the cache holds every valid row of the file: it can neither stop
+        // at row_limit nor fail on the bad rows strict mode rejects
+        if (row_limit_ <= 0 && !strict_)
+        {
+            cache_ = mapnik::feature_cache::open(filename_, params);
+        }
     }
     if (!inline_string_.empty())
     {
         std::istringstream in(inline_string_);
         parse_csv(in);
     }
+    else if (cache_)
+    {
+        // features were decoded by `mapnik-index --cache`
+        if (!extent_initialized_) extent_ = cache_->envelope();
+        cache_->describe(desc_);
+        // only the described columns are known, for validating queries
+        for (auto const& attr : desc_.get_descriptors())
+        {
+            headers_.push_back(attr.get_name());
+        }
+    }
     else
     {
 #if defined (MAPNIK_MEMORY_MAPPED_FILE)
@@ -366,6 +383,7 @@ csv_datasource::get_geometry_type_impl(std::istream & stream) const
 
 boost::optional<mapnik::datasource_geometry_t> csv_datasource::get_geometry_type() const
 {
+    if (cache_) return cache_->geometry_type();
     if (inline_string_.empty())
     {
 #if defined (_WINDOWS)
@@ -407,6 +425,7 @@ mapnik::featureset_ptr csv_datasource::features(mapnik::query const& q) const
             throw mapnik::datasource_exception(s.str());
         }
     }
+    if (cache_) return cache_->features(q);
 
     mapnik::box2d<double> const& box = q.get_bbox();
     if (extent_.intersects(box))
@@ -31,6 +31,7 @@
 #include <mapnik/geometry/box2d.hpp>
 #include <mapnik/coord.hpp>
 #include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/feature_cache.hpp>
 #include <mapnik/value/types.hpp>
 #include "csv_utils.hpp"
 
@@ -96,6 +97,7 @@ private:
     std::string inline_string_;
     mapnik::context_ptr ctx_;
     std::unique_ptr<spatial_index_type> tree_;
+    std::shared_ptr<mapnik::feature_cache const> cache_; // <file>.fcache
 };
 
 #endif // MAPNIK_CSV_DATASOURCE_HPP
@@ -0,0 +1,180 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_CSV_SCANNER_HPP
+#define MAPNIK_CSV_SCANNER_HPP
+
+#include <mapnik/csv/csv_types.hpp>
+
+#ifdef SSE_MATH
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace csv_utils {
+
+namespace detail {
+
+inline unsigned count_trailing_zeros(std::uint64_t v)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return static_cast<unsigned>(index);
+#else
+    unsigned n = 0;
+    while ((v & 1) == 0)
+    {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+#ifndef SSE_MATH
+// high bit set in every byte of `v` that is zero (lowest one is exact)
+inline std::uint64_t zero_bytes(std::uint64_t v)
+{
+    return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+}
+
+inline bool little_endian()
+{
+    std::uint16_t v = 1;
+    char c;
+    std::memcpy(&c, &v, 1);
+    return c == 1;
+}
+#endif
+
+inline char const* skip_spaces(char const* first, char const* last)
+{
+    while (first != last && *first == ' ') ++first;
+    return first;
+}
+
+} // namespace detail
+
+// Structural character scanner: returns the first position in [first, last)
+// holding `a` or `b`, or `last`. Classifies 16 bytes per step with SSE2
+// compare/movemask when available and 8 bytes per step (SWAR) otherwise.
+inline char const* find_either(char const* first, char const* last, char a, char b)
+{
+#ifdef SSE_MATH
+    __m128i const va = _mm_set1_epi8(a);
+    __m128i const vb = _mm_set1_epi8(b);
+    while (last - first >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (mask != 0) return first + detail::count_trailing_zeros(static_cast<std::uint64_t>(mask));
+        first += 16;
+    }
+#else
+    static bool const little_endian = detail::little_endian();
+    if (little_endian)
+    {
+        std::uint64_t const ones = 0x0101010101010101ULL;
+        std::uint64_t const pa = ones * static_cast<unsigned char>(a);
+        std::uint64_t const pb = ones * static_cast<unsigned char>(b);
+        while (last - first >= 8)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, first, 8);
+            std::uint64_t mask = detail::zero_bytes(v ^ pa) | detail::zero_bytes(v ^ pb);
+            if (mask != 0) return first + detail::count_trailing_zeros(mask) / 8;
+            first += 8;
+        }
+    }
+#endif
+    for (; first != last; ++first)
+    {
+        if (*first == a || *first == b) break;
+    }
+    return first;
+}
+
+// Finds the end of the row starting at `first` (the first unquoted
+// `newline`), same semantics as getline_csv. `quoted` carries the quote
+// state in and out, so a row can be scanned across several buffers.
+// Returns `last` if the row doesn't end within [first, last).
+inline char const* find_row_end(char const* first, char const* last, char newline, char quote, bool & quoted)
+{
+    while (first != last)
+    {
+        first = quoted ? find_either(first, last, quote, quote)
+            : find_either(first, last, quote, newline);
+        if (first == last) break;
+        if (*first == quote)
+        {
+            quoted = !quoted;
+        }
+        else
+        {
+            return first;
+        }
+        ++first;
+    }
+    return last;
+}
+
+// Splits a row with no quoted fields into `values`, yielding exactly what
+// the CSV grammar would: the optional leading newline and leading blanks
+// of every field are skipped, everything else up to the separator is kept.
+// Returns false, leaving `values` empty, if the row contains a quote and
+// needs the full grammar.
+inline bool split_unquoted_row(char const* first, char const* last, char separator, char quote,
+                               mapnik::csv_line & values)
+{
+    values.clear();
+    if (separator == ' ' || quote == ' ') return false;
+    first = detail::skip_spaces(first, last);
+    if (first != last && *first == '\r') ++first;
+    first = detail::skip_spaces(first, last);
+    if (first != last && *first == '\n') ++first;
+    for (;;)
+    {
+        first = detail::skip_spaces(first, last);
+        char const* field_end = find_either(first, last, separator, quote);
+        if (field_end != last && *field_end == quote)
+        {
+            values.clear();
+            return false;
+        }
+        values.emplace_back(first, field_end);
+        if (field_end == last) return true;
+        first = field_end + 1;
+    }
+}
+
+} // namespace csv_utils
+
+#endif // MAPNIK_CSV_SCANNER_HPP
@@ -29,10 +29,12 @@
 #include <mapnik/util/conversions.hpp>
 #include <mapnik/util/trim.hpp>
 #include <mapnik/datasource.hpp>
+#include <mapnik/util/parallel_for.hpp>
 // csv grammar
 #include <mapnik/csv/csv_grammar_x3_def.hpp>
 //
 #include "csv_getline.hpp"
+#include "csv_scanner.hpp"
 #include "csv_utils.hpp"
 
 #include <fstream>
@@ -43,6 +45,13 @@
 namespace csv_utils {
 namespace detail {
 
+#ifdef MAPNIK_THREADSAFE
+// files with less data than this are parsed on the calling thread
+static constexpr std::size_t parallel_parsing_threshold = 1 << 22;
+static constexpr std::size_t parallel_parsing_block_size = 1 << 24;
+static constexpr std::size_t parallel_parsing_min_rows = 256;
+#endif
+
 std::size_t file_length(std::istream & stream)
 {
     stream.seekg(0, std::ios::end);
@@ -202,6 +211,7 @@ mapnik::csv_line parse_line(char const* start, char const* end, char separator,
 
     mapnik::csv_line values;
     if (num_columns > 0) values.reserve(num_columns);
+    if (split_unquoted_row(start, end, separator, quote, values)) return values;
     if (!x3::phrase_parse(start, end, parser, mapnik::csv_white_space, values))
     {
         throw mapnik::datasource_exception("Failed to parse CSV line:\n" + std::string(start, end));
@@ -268,7 +278,7 @@ void csv_file_parser::parse_csv_and_boxes(std::istream & csv_file, T & boxes)
     std::string csv_line;
     csv_utils::getline_csv(csv_file, csv_line, newline, quote_);
     csv_file.seekg(0, std::ios::beg);
-    int line_number = 0;
+    mapnik::value_integer line_number = 0;
     if (!manual_headers_.empty())
     {
         std::size_t index = 0;
@@ -348,7 +358,45 @@ void csv_file_parser::parse_csv_and_boxes(std::istream & csv_file, T & boxes)
     }
 
     mapnik::value_integer feature_count = 0;
+    auto add_row = [&](csv_row & row, std::uint64_t record_offset, std::uint64_t record_size,
+                       mapnik::value_integer row_line_number)
+    {
+        switch (row.status)
+        {
+        case csv_row::skipped:
+            MAPNIK_LOG_DEBUG(csv) << "csv_datasource: empty row encountered at line: " << row_line_number;
+            break;
+        case csv_row::feature:
+            if (!extent_initialized_)
+            {
+                if (extent_.valid())
+                    extent_.expand_to_include(row.box);
+                else
+                    extent_ = row.box;
+            }
+            boxes.emplace_back(box_type(row.box), std::make_pair(record_offset, record_size));
+            add_feature(++feature_count, row.values);
+            break;
+        case csv_row::datasource_error:
+            if (strict_) throw mapnik::datasource_exception(row.message);
+            MAPNIK_LOG_ERROR(csv) << row.message << " at line: " << row_line_number;
+            break;
+        case csv_row::error:
+            if (strict_) throw mapnik::datasource_exception(row.message);
+            MAPNIK_LOG_ERROR(csv) << row.message;
+            break;
+        }
+    };
+
     auto pos = csv_file.tellg();
+#ifdef MAPNIK_THREADSAFE
+    if (has_newline && !has_disk_index_ && mapnik::util::parallel_concurrency() > 1 && pos >= 0
+        && file_length - static_cast<std::size_t>(pos) > detail::parallel_parsing_threshold)
+    {
+        parse_rows_parallel(csv_file, static_cast<std::uint64_t>(pos), newline, line_number, add_row);
+        return;
+    }
+#endif
     // handle rare case of a single line of data and user-provided headers
     // where a lack of a newline will mean that csv_utils::getline_csv returns false
     bool is_first_row = false;
@@ -363,6 +411,7 @@ void csv_file_parser::parse_csv_and_boxes(std::istream & csv_file, T & boxes)
         }
     }
 
+    csv_row row;
     while (is_first_row || csv_utils::getline_csv(csv_file, csv_line, newline, quote_))
     {
         ++line_number;
@@ -376,92 +425,155 @@ void csv_file_parser::parse_csv_and_boxes(std::istream & csv_file, T & boxes)
         pos = csv_file.tellg();
         is_first_row = false;
 
-        // skip blank lines
-        if (record_size <= 10)
+        parse_row(csv_line.data(), csv_line.data() + record_size, line_number, row);
+        add_row(row, static_cast<std::uint64_t>(record_offset), record_size, line_number);
+        // return early if *.index is present
+        if (has_disk_index_ && row.status != csv_row::skipped) return;
+    }
+}
+
+#ifdef MAPNIK_THREADSAFE
+template <typename AddRow>
+void csv_file_parser::parse_rows_parallel(std::istream & csv_file, std::uint64_t pos, char newline,
+                                          mapnik::value_integer line_number, AddRow && add_row)
+{
+    // Rows are split serially, which only needs to track quotes, and then
+    // parsed by worker threads one block at a time. Results are added in
+    // file order, so the outcome is identical to the sequential loop.
+    std::vector<char> buffer;
+    std::vector<std::pair<std::size_t, std::size_t>> records; // start, size within buffer
+    std::vector<csv_row> rows;
+    std::uint64_t buffer_offset = pos; // file offset of buffer[0]
+    std::size_t scan_pos = 0;
+    bool quoted = false;
+    bool done = false;
+    while (!done)
+    {
+        std::size_t carry = buffer.size();
+        buffer.resize(carry + detail::parallel_parsing_block_size);
+        csv_file.read(buffer.data() + carry, detail::parallel_parsing_block_size);
+        std::size_t count = static_cast<std::size_t>(csv_file.gcount());
+        buffer.resize(carry + count);
+        bool eof = (count < detail::parallel_parsing_block_size);
+
+        // split rows
+        records.clear();
+        std::size_t start = 0;
+        char const* data = buffer.data();
+        char const* data_end = data + buffer.size();
+        for (char const* itr = data + scan_pos; ; )
         {
-            std::string trimmed = csv_line;
-            boost::trim_if(trimmed, boost::algorithm::is_any_of("\",'\r\n "));
-            if (trimmed.empty())
-            {
-                MAPNIK_LOG_DEBUG(csv) << "csv_datasource: empty row encountered at line: " << line_number;
-                continue;
-            }
+            itr = find_row_end(itr, data_end, newline, quote_, quoted);
+            if (itr == data_end) break;
+            std::size_t i = static_cast<std::size_t>(itr - data);
+            records.emplace_back(start, i - start);
+            start = i + 1;
+            ++itr;
+        }
+        if (eof)
+        {
+            if (start < buffer.size()) records.emplace_back(start, buffer.size() - start);
+            start = buffer.size();
+            done = true;
+        }
+        if (row_limit_ > 0 && line_number + static_cast<mapnik::value_integer>(records.size()) > row_limit_)
+        {
+            records.resize(static_cast<std::size_t>(std::max<mapnik::value_integer>(0, row_limit_ - line_number)));
+            done = true;
         }
 
-        try
+        // parse
+        rows.resize(records.size());
+        mapnik::util::parallel_for(records.size(), detail::parallel_parsing_min_rows,
+                                   [&](std::size_t first, std::size_t last)
         {
-            auto const* line_start = csv_line.data();
-            auto const* line_end = line_start + csv_line.size();
-            auto values = csv_utils::parse_line(line_start, line_end, separator_, quote_, num_headers);
-            unsigned num_fields = values.size();
-            if (num_fields != num_headers)
+            for (std::size_t i = first; i < last; ++i)
             {
-                std::ostringstream s;
-                s << "CSV Plugin: # of columns(" << num_fields << ")";
-                if (num_fields > num_headers)
-                {
-                    s << " > ";
-                }
-                else
-                {
-                    s << " < ";
-                }
-                s << "# of headers(" << num_headers << ") parsed";
-                throw mapnik::datasource_exception(s.str());
+                char const* begin = buffer.data() + records[i].first;
+                parse_row(begin, begin + records[i].second,
+                          line_number + static_cast<mapnik::value_integer>(i) + 1, rows[i]);
             }
+        });
 
-            auto geom = extract_geometry(values, locator_);
-            if (!geom.is<mapnik::geometry::geometry_empty>())
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            add_row(rows[i], buffer_offset + records[i].first, records[i].second, ++line_number);
+        }
+
+        // keep the incomplete trailing row for the next block
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(start));
+        buffer_offset += start;
+        scan_pos = buffer.size();
+    }
+}
+#endif
+
+void csv_file_parser::parse_row(char const* start, char const* end, mapnik::value_integer line_number, csv_row & row) const
+{
+    row.status = csv_row::skipped;
+    row.values.clear();
+    row.message.clear();
+
+    // skip blank lines
+    if (end - start <= 10)
+    {
+        std::string trimmed(start, end);
+        boost::trim_if(trimmed, boost::algorithm::is_any_of("\",'\r\n "));
+        if (trimmed.empty()) return;
+    }
+
+    std::size_t num_headers = headers_.size();
+    try
+    {
+        row.values = csv_utils::parse_line(start, end, separator_, quote_, num_headers);
+        unsigned num_fields = row.values.size();
+        if (num_fields != num_headers)
+        {
+            std::ostringstream s;
+            s << "CSV Plugin: # of columns(" << num_fields << ")";
+            if (num_fields > num_headers)
             {
-                auto box = mapnik::geometry::envelope(geom);
-                if (!extent_initialized_)
-                {
-                    if (extent_.valid())
-                        extent_.expand_to_include(box);
-                    else
-                        extent_ = box;
-                }
-                boxes.emplace_back(box_type(box), make_pair(record_offset, record_size));
-                add_feature(++feature_count, values);
+                s << " > ";
             }
             else
             {
-                std::ostringstream s;
-                s << "CSV Plugin: expected geometry column: could not parse row "
-                  << line_number << " "
-                  << values.at(locator_.index) << "'";
-                throw mapnik::datasource_exception(s.str());
+                s << " < ";
             }
+            s << "# of headers(" << num_headers << ") parsed";
+            throw mapnik::datasource_exception(s.str());
         }
-        catch (mapnik::datasource_exception const& ex )
+
+        auto geom = extract_geometry(row.values, locator_);
+        if (!geom.is<mapnik::geometry::geometry_empty>())
         {
-            if (strict_) throw ex;
-            else
-            {
-                MAPNIK_LOG_ERROR(csv) << ex.what() << " at line: " << line_number;
-            }
+            row.box = mapnik::geometry::envelope(geom);
+            row.status = csv_row::feature;
         }
-        catch (std::exception const& ex)
+        else
         {
             std::ostringstream s;
-            s << "CSV Plugin: unexpected error parsing line: " << line_number
-              << " - found " << headers_.size() << " with values like: " << csv_line << "\n"
-              << " and got error like: " << ex.what();
-            if (strict_)
-            {
-                throw mapnik::datasource_exception(s.str());
-            }
-            else
-            {
-                MAPNIK_LOG_ERROR(csv) << s.str();
-            }
+            s << "CSV Plugin: expected geometry column: could not parse row "
+              << line_number << " "
+              << row.values.at(locator_.index) << "'";
+            throw mapnik::datasource_exception(s.str());
         }
-        // return early if *.index is present
-        if (has_disk_index_) return;
+    }
+    catch (mapnik::datasource_exception const& ex )
+    {
+        row.status = csv_row::datasource_error;
+        row.message = ex.what();
+    }
+    catch (std::exception const& ex)
+    {
+        std::ostringstream s;
+        s << "CSV Plugin: unexpected error parsing line: " << line_number
+          << " - found " << headers_.size() << " with values like: " << std::string(start, end) << "\n"
+          << " and got error like: " << ex.what();
+        row.status = csv_row::error;
+        row.message = s.str();
     }
 }
 
-
 mapnik::geometry::geometry<double> extract_geometry(std::vector<std::string> const& row, geometry_column_locator const& locator)
 {
     mapnik::geometry::geometry<double> geom;
@@ -128,11 +128,28 @@ void process_properties(Feature & feature, Headers const& headers, Values const&
     }
 }
 
+// outcome of parsing one data row
+struct csv_row
+{
+    enum status_type { skipped, feature, datasource_error, error } status = skipped;
+    mapnik::box2d<double> box;
+    mapnik::csv_line values;
+    std::string message;
+};
+
 struct csv_file_parser
 {
     template <typename T>
     void parse_csv_and_boxes(std::istream & csv_file, T & boxes);
 
+    // parses a data row and extracts its geometry, safe to call concurrently
+    void parse_row(char const* start, char const* end, mapnik::value_integer line_number, csv_row & row) const;
+#ifdef MAPNIK_THREADSAFE
+    template <typename AddRow>
+    void parse_rows_parallel(std::istream & csv_file, std::uint64_t pos, char newline,
+                             mapnik::value_integer line_number, AddRow && add_row);
+#endif
+
     virtual void add_feature(mapnik::value_integer index, mapnik::csv_line const & values);
 
     std::vector<std::string> headers_;
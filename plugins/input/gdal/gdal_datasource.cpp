@@ -56,9 +56,74 @@ extern "C" MAPNIK_EXP void on_plugin_load()
     });
 }
 
+gdal_dataset_pool::gdal_dataset_pool(std::string const& name, bool shared)
+    : name_(name),
+      shared_(shared) {}
+
+gdal_dataset_pool::~gdal_dataset_pool()
+{
+    for (GDALDataset* dataset : handles_)
+    {
+        MAPNIK_LOG_DEBUG(gdal) << "gdal_featureset: Closing Dataset=" << dataset;
+        GDALClose(dataset);
+    }
+}
+
+std::shared_ptr<GDALDataset> gdal_dataset_pool::acquire()
+{
+#if GDAL_VERSION_NUM >= 1600
+    if (shared_)
+    {
+        // GDALOpenShared hands the same dataset to every caller on a
+        // thread, pooling it could pass one handle to two threads. Shared
+        // handles are reference counted by GDAL and closed on release.
+        GDALDataset* dataset = static_cast<GDALDataset*>(GDALOpenShared(name_.c_str(), GA_ReadOnly));
+        if (!dataset)
+        {
+            throw datasource_exception(CPLGetLastErrorMsg());
+        }
+        MAPNIK_LOG_DEBUG(gdal) << "gdal_featureset: opened shared Dataset=" << dataset;
+        return std::shared_ptr<GDALDataset>(dataset, [](GDALDataset* ds) {
+            MAPNIK_LOG_DEBUG(gdal) << "gdal_featureset: Closing shared Dataset=" << ds;
+            GDALClose(ds);
+        });
+    }
+#endif
+    GDALDataset* dataset = nullptr;
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        if (!handles_.empty())
+        {
+            dataset = handles_.back();
+            handles_.pop_back();
+        }
+    }
+    if (!dataset)
+    {
+        dataset = static_cast<GDALDataset*>(GDALOpen(name_.c_str(), GA_ReadOnly));
+        if (!dataset)
+        {
+            throw datasource_exception(CPLGetLastErrorMsg());
+        }
+        MAPNIK_LOG_DEBUG(gdal) << "gdal_featureset: opened Dataset=" << dataset;
+    }
+    auto self = shared_from_this();
+    return std::shared_ptr<GDALDataset>(dataset, [self](GDALDataset* ds) { self->release(ds); });
+}
+
+void gdal_dataset_pool::release(GDALDataset* dataset)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    handles_.push_back(dataset);
+}
+
 gdal_datasource::gdal_datasource(parameters const& params)
     : datasource(params),
-      dataset_(nullptr, &GDALClose),
+      pool_(),
       desc_(gdal_datasource::name(), "utf-8"),
       nodata_value_(params.get<double>("nodata")),
       nodata_tolerance_(*params.get<double>("nodata_tolerance",1e-12))
@@ -92,29 +157,23 @@ gdal_datasource::gdal_datasource(parameters const& params)
     // max_im_area based on 50 mb limit for RGBA
     max_image_area_ = *params.get<mapnik::value_integer>("max_image_area", (50*1024*1024) / 4);
 
-#if GDAL_VERSION_NUM >= 1600
-    if (shared_dataset_)
+    // GDAL's block cache is global: only ever grow it
+    boost::optional<mapnik::value_integer> block_cache_size = params.get<mapnik::value_integer>("block_cache_size");
+    if (block_cache_size && *block_cache_size > 0)
     {
-        auto ds = GDALOpenShared(dataset_name_.c_str(), GA_ReadOnly);
-        dataset_.reset(static_cast<GDALDataset*>(ds));
-    }
-    else
-#endif
-    {
-        auto ds = GDALOpen(dataset_name_.c_str(), GA_ReadOnly);
-        dataset_.reset(static_cast<GDALDataset*>(ds));
-    }
-
-    if (! dataset_)
-    {
-        throw datasource_exception(CPLGetLastErrorMsg());
+        GIntBig cache_bytes = static_cast<GIntBig>(*block_cache_size) * 1024 * 1024;
+        if (cache_bytes > GDALGetCacheMax64())
+        {
+            GDALSetCacheMax64(cache_bytes);
+        }
     }
 
-    MAPNIK_LOG_DEBUG(gdal) << "gdal_featureset: opened Dataset=" << dataset_.get();
+    pool_ = std::make_shared<gdal_dataset_pool>(dataset_name_, shared_dataset_);
+    std::shared_ptr<GDALDataset> dataset = pool_->acquire();
 
-    nbands_ = dataset_->GetRasterCount();
-    width_ = dataset_->GetRasterXSize();
-    height_ = dataset_->GetRasterYSize();
+    nbands_ = dataset->GetRasterCount();
+    width_ = dataset->GetRasterXSize();
+    height_ = dataset->GetRasterYSize();
     desc_.add_descriptor(mapnik::attribute_descriptor("nodata", mapnik::Double));
 
     double tr[6];
@@ -146,7 +205,7 @@ gdal_datasource::gdal_datasource(parameters const& params)
     }
     else
     {
-        if (dataset_->GetGeoTransform(tr) != CPLE_None)
+        if (dataset->GetGeoTransform(tr) != CPLE_None)
         {
             MAPNIK_LOG_DEBUG(gdal) << "gdal_datasource GetGeotransform failure gives="
                                    << tr[0] << "," << tr[1] << ","
@@ -200,7 +259,6 @@ gdal_datasource::gdal_datasource(parameters const& params)
 
 gdal_datasource::~gdal_datasource()
 {
-    MAPNIK_LOG_DEBUG(gdal) << "gdal_featureset: Closing Dataset=" << dataset_.get();
 }
 
 datasource::datasource_t gdal_datasource::type() const
@@ -234,7 +292,7 @@ featureset_ptr gdal_datasource::features(query const& q) const
     mapnik::progress_timer __stats__(std::clog, "gdal_datasource::features");
 #endif
 
-    return std::make_shared<gdal_featureset>(*dataset_,
+    return std::make_shared<gdal_featureset>(pool_->acquire(),
                                               band_,
                                               gdal_query(q),
                                               extent_,
@@ -254,7 +312,7 @@ featureset_ptr gdal_datasource::features_at_point(coord2d const& pt, double tol)
     mapnik::progress_timer __stats__(std::clog, "gdal_datasource::features_at_point");
 #endif
 
-    return std::make_shared<gdal_featureset>(*dataset_,
+    return std::make_shared<gdal_featureset>(pool_->acquire(),
                                               band_,
                                               gdal_query(pt),
                                               extent_,
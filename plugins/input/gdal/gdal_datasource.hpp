@@ -36,12 +36,36 @@
 #include <boost/optional.hpp>
 
 // stl
+#include <memory>
 #include <vector>
 #include <string>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
 
 // gdal
 #include <gdal_priv.h>
 
+// GDAL datasets can not be used by several threads at once, so each
+// featureset borrows a handle of its own. Released handles are kept open
+// for reuse, which also keeps their blocks in GDAL's block cache. With
+// shared=true handles come from GDALOpenShared and are not pooled.
+class gdal_dataset_pool : public std::enable_shared_from_this<gdal_dataset_pool>
+{
+public:
+    gdal_dataset_pool(std::string const& name, bool shared);
+    ~gdal_dataset_pool();
+    std::shared_ptr<GDALDataset> acquire();
+private:
+    void release(GDALDataset* dataset);
+    std::string name_;
+    bool shared_;
+    std::vector<GDALDataset*> handles_;
+#ifdef MAPNIK_THREADSAFE
+    std::mutex mutex_;
+#endif
+};
+
 class gdal_datasource : public mapnik::datasource
 {
 public:
@@ -55,7 +79,7 @@ public:
     boost::optional<mapnik::datasource_geometry_t> get_geometry_type() const;
     mapnik::layer_descriptor get_descriptor() const;
 private:
-    std::unique_ptr<GDALDataset, decltype(&GDALClose)> dataset_;
+    std::shared_ptr<gdal_dataset_pool> pool_;
     mapnik::box2d<double> extent_;
     std::string dataset_name_;
     int band_;
@@ -34,6 +34,7 @@
 #include <cmath>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include "gdal_featureset.hpp"
 #include <gdal_priv.h>
@@ -44,6 +45,44 @@ using mapnik::view_transform;
 using mapnik::datasource_exception;
 using mapnik::feature_factory;
 
+namespace {
+
+// RasterIO writes every pixel of the buffer, so the image is not
+// initialised beforehand
+template <typename Image>
+Image read_band(GDALRasterBand & band, GDALDataType type,
+                int x_off, int y_off, int width, int height,
+                int im_width, int im_height)
+{
+    Image image(im_width, im_height, false);
+    CPLErr raster_io_error = band.RasterIO(GF_Read, x_off, y_off, width, height,
+                                           image.data(), image.width(), image.height(),
+                                           type, 0, 0);
+    if (raster_io_error == CE_Failure)
+    {
+        throw datasource_exception(CPLGetLastErrorMsg());
+    }
+    return image;
+}
+
+// Reads the bands listed in `band_map` in one go, pixel interleaved
+// into the channels of an rgba8 image starting at channel 0
+void read_bands(GDALDataset & dataset, std::vector<int> & band_map,
+                int x_off, int y_off, int width, int height,
+                mapnik::image_rgba8 & image)
+{
+    CPLErr raster_io_error = dataset.RasterIO(GF_Read, x_off, y_off, width, height,
+                                              image.bytes(), image.width(), image.height(),
+                                              GDT_Byte, static_cast<int>(band_map.size()), band_map.data(),
+                                              4, 4 * image.width(), 1);
+    if (raster_io_error == CE_Failure)
+    {
+        throw datasource_exception(CPLGetLastErrorMsg());
+    }
+}
+
+} // anonymous ns
+
 #ifdef MAPNIK_LOG
 namespace {
 
@@ -79,7 +118,7 @@ void get_overview_meta(GDALRasterBand* band)
 }
 } // anonymous ns
 #endif
-gdal_featureset::gdal_featureset(GDALDataset& dataset,
+gdal_featureset::gdal_featureset(std::shared_ptr<GDALDataset> const& dataset,
                                  int band,
                                  gdal_query q,
                                  mapnik::box2d<double> extent,
@@ -91,7 +130,8 @@ gdal_featureset::gdal_featureset(GDALDataset& dataset,
                                  boost::optional<double> const& nodata,
                                  double nodata_tolerance,
                                  int64_t max_image_area)
-    : dataset_(dataset),
+    : handle_(dataset),
+      dataset_(*handle_),
       ctx_(std::make_shared<mapnik::context_type>()),
       band_(band),
       gquery_(q),
@@ -248,7 +288,7 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
         std::floor(raster_extent_.height() *
             height_res * filter_factor) + .5);
 
-    if (band_ > 0 && band_ < nbands_)
+    if (band_ > 0 && band_ <= nbands_)
     {
         find_best_overview(band_,
                            ideal_raster_width,
@@ -337,106 +377,52 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
                 throw datasource_exception(s.str());
             }
             GDALDataType band_type = band->GetRasterDataType();
+            raster_nodata = band->GetNoDataValue(&raster_has_nodata);
+            mapnik::raster_ptr raster;
             switch (band_type)
             {
             case GDT_Byte:
             {
-                mapnik::image_gray8 image(im_width, im_height);
-                image.set(std::numeric_limits<std::uint8_t>::max());
-                raster_nodata = band->GetNoDataValue(&raster_has_nodata);
-                raster_io_error = band->RasterIO(GF_Read, x_off, y_off, width, height,
-                                                 image.data(), image.width(), image.height(),
-                                                 GDT_Byte, 0, 0);
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-                mapnik::raster_ptr raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect, image, filter_factor);
-                // set nodata value to be used in raster colorizer
-                if (nodata_value_) raster->set_nodata(*nodata_value_);
-                else raster->set_nodata(raster_nodata);
-                feature->set_raster(raster);
+                raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect,
+                    read_band<mapnik::image_gray8>(*band, GDT_Byte, x_off, y_off, width, height, im_width, im_height),
+                    filter_factor);
                 break;
             }
             case GDT_Float64:
             case GDT_Float32:
             {
-                mapnik::image_gray32f image(im_width, im_height);
-                image.set(std::numeric_limits<float>::max());
-                raster_nodata = band->GetNoDataValue(&raster_has_nodata);
-                raster_io_error = band->RasterIO(GF_Read, x_off, y_off, width, height,
-                                                 image.data(), image.width(), image.height(),
-                                                 GDT_Float32, 0, 0);
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-                mapnik::raster_ptr raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect, image, filter_factor);
-                // set nodata value to be used in raster colorizer
-                if (nodata_value_) raster->set_nodata(*nodata_value_);
-                else raster->set_nodata(raster_nodata);
-                feature->set_raster(raster);
+                raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect,
+                    read_band<mapnik::image_gray32f>(*band, GDT_Float32, x_off, y_off, width, height, im_width, im_height),
+                    filter_factor);
                 break;
             }
             case GDT_UInt16:
             {
-                mapnik::image_gray16 image(im_width, im_height);
-                image.set(std::numeric_limits<std::uint16_t>::max());
-                raster_nodata = band->GetNoDataValue(&raster_has_nodata);
-                raster_io_error = band->RasterIO(GF_Read, x_off, y_off, width, height,
-                                                 image.data(), image.width(), image.height(),
-                                                 GDT_UInt16, 0, 0);
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-                mapnik::raster_ptr raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect, image, filter_factor);
-                // set nodata value to be used in raster colorizer
-                if (nodata_value_) raster->set_nodata(*nodata_value_);
-                else raster->set_nodata(raster_nodata);
-                feature->set_raster(raster);
+                raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect,
+                    read_band<mapnik::image_gray16>(*band, GDT_UInt16, x_off, y_off, width, height, im_width, im_height),
+                    filter_factor);
                 break;
             }
             case GDT_Int32:
             {
-                mapnik::image_gray32s image(im_width, im_height);
-                image.set(std::numeric_limits<std::int32_t>::max());
-                raster_nodata = band->GetNoDataValue(&raster_has_nodata);
-                raster_io_error = band->RasterIO(GF_Read, x_off, y_off, width, height,
-                                                 image.data(), image.width(), image.height(),
-                                                 GDT_Int32, 0, 0);
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-                mapnik::raster_ptr raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect, image, filter_factor);
-                // set nodata value to be used in raster colorizer
-                if (nodata_value_) raster->set_nodata(*nodata_value_);
-                else raster->set_nodata(raster_nodata);
-                feature->set_raster(raster);
+                raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect,
+                    read_band<mapnik::image_gray32s>(*band, GDT_Int32, x_off, y_off, width, height, im_width, im_height),
+                    filter_factor);
                 break;
             }
             default:
             case GDT_Int16:
             {
-                mapnik::image_gray16s image(im_width, im_height);
-                image.set(std::numeric_limits<std::int16_t>::max());
-                raster_nodata = band->GetNoDataValue(&raster_has_nodata);
-                raster_io_error = band->RasterIO(GF_Read, x_off, y_off, width, height,
-                                                 image.data(), image.width(), image.height(),
-                                                 GDT_Int16, 0, 0);
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-                mapnik::raster_ptr raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect, image, filter_factor);
-                // set nodata value to be used in raster colorizer
-                if (nodata_value_) raster->set_nodata(*nodata_value_);
-                else raster->set_nodata(raster_nodata);
-                feature->set_raster(raster);
+                raster = std::make_shared<mapnik::raster>(feature_raster_extent, intersect,
+                    read_band<mapnik::image_gray16s>(*band, GDT_Int16, x_off, y_off, width, height, im_width, im_height),
+                    filter_factor);
                 break;
             }
             }
+            // set nodata value to be used in raster colorizer
+            if (nodata_value_) raster->set_nodata(*nodata_value_);
+            else raster->set_nodata(raster_nodata);
+            feature->set_raster(raster);
         }
         else // working with all bands
         {
@@ -522,71 +508,16 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
                 GDALColorTable *color_table = red->GetColorTable();
                 bool has_nodata = nodata_value_ || raster_has_nodata;
 
-                // we can deduce the alpha channel from nodata in the Byte case
-                // by reusing the reading of R,G,B bands directly
-                if (has_nodata && !color_table && red->GetRasterDataType() == GDT_Byte)
+                // One dataset RasterIO reads all bands straight into the
+                // interleaved image, whatever their order in the dataset.
+                // With nodata, alpha is deduced from the red band below.
+                std::vector<int> band_map = { red->GetBand(), green->GetBand(), blue->GetBand() };
+                if (alpha && !raster_has_nodata)
                 {
-                    double apply_nodata = nodata_value_ ? *nodata_value_ : raster_nodata;
-                    // read the data in and create an alpha channel from the nodata values
-                    // TODO - we assume here the nodata value for the red band applies to all bands
-                    // more details about this at http://trac.osgeo.org/gdal/ticket/2734
-                    float* imageData = (float*)image.bytes();
-                    raster_io_error = red->RasterIO(GF_Read, x_off, y_off, width, height,
-                                                    imageData, image.width(), image.height(),
-                                                    GDT_Float32, 0, 0);
-                    if (raster_io_error == CE_Failure) {
-                        throw datasource_exception(CPLGetLastErrorMsg());
-                    }
-                    int len = image.width() * image.height();
-                    for (int i = 0; i < len; ++i)
-                    {
-                        if (std::fabs(apply_nodata - imageData[i]) < nodata_tolerance_)
-                        {
-                            *reinterpret_cast<unsigned *>(&imageData[i]) = 0;
-                        }
-                        else
-                        {
-                            *reinterpret_cast<unsigned *>(&imageData[i]) = 0xFFFFFFFF;
-                        }
-                    }
-                }
-
-                // Use dataset RasterIO in priority in 99.9% of the cases
-                if( red->GetBand() == 1 && green->GetBand() == 2 && blue->GetBand() == 3 )
-                {
-                    int nBandsToRead = 3;
-                    if( alpha != nullptr && alpha->GetBand() == 4 && !raster_has_nodata )
-                    {
-                        nBandsToRead = 4;
-                        alpha = nullptr; // to avoid reading it again afterwards
-                    }
-                    raster_io_error = dataset_.RasterIO(GF_Read, x_off, y_off, width, height,
-                                                        image.bytes(),
-                                                        image.width(), image.height(), GDT_Byte,
-                                                        nBandsToRead, nullptr,
-                                                        4, 4 * image.width(), 1);
-                    if (raster_io_error == CE_Failure) {
-                        throw datasource_exception(CPLGetLastErrorMsg());
-                    }
-                }
-                else
-                {
-                    raster_io_error = red->RasterIO(GF_Read, x_off, y_off, width, height, image.bytes() + 0,
-                                                    image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    if (raster_io_error == CE_Failure) {
-                        throw datasource_exception(CPLGetLastErrorMsg());
-                    }
-                    raster_io_error = green->RasterIO(GF_Read, x_off, y_off, width, height, image.bytes() + 1,
-                                                    image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    if (raster_io_error == CE_Failure) {
-                        throw datasource_exception(CPLGetLastErrorMsg());
-                    }
-                    raster_io_error = blue->RasterIO(GF_Read, x_off, y_off, width, height, image.bytes() + 2,
-                                                    image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                    if (raster_io_error == CE_Failure) {
-                        throw datasource_exception(CPLGetLastErrorMsg());
-                    }
+                    band_map.push_back(alpha->GetBand());
+                    alpha = nullptr; // to avoid reading it again afterwards
                 }
+                read_bands(dataset_, band_map, x_off, y_off, width, height, image);
 
                 // In the case we skipped initializing the alpha channel
                 if (has_nodata && !color_table && red->GetRasterDataType() == GDT_Byte)
@@ -641,27 +572,15 @@ feature_ptr gdal_featureset::get_feature(mapnik::query const& q)
                     }
                 }
 
-                raster_io_error = grey->RasterIO(GF_Read, x_off, y_off, width, height, image.bytes() + 0,
-                                                 image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-
-                raster_io_error = grey->RasterIO(GF_Read,x_off, y_off, width, height, image.bytes() + 1,
-                                                 image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-                if (raster_io_error == CE_Failure)
-                {
-                    throw datasource_exception(CPLGetLastErrorMsg());
-                }
-
-                raster_io_error = grey->RasterIO(GF_Read,x_off, y_off, width, height, image.bytes() + 2,
-                                                 image.width(), image.height(), GDT_Byte, 4, 4 * image.width());
-
-                if (raster_io_error == CE_Failure)
+                // grey into the three colour channels, plus alpha when it
+                // is not deduced from nodata, in a single dataset RasterIO
+                std::vector<int> band_map(3, grey->GetBand());
+                if (alpha && !raster_has_nodata && !color_table)
                 {
-                    throw datasource_exception(CPLGetLastErrorMsg());
+                    band_map.push_back(alpha->GetBand());
+                    alpha = nullptr; // to avoid reading it again afterwards
                 }
+                read_bands(dataset_, band_map, x_off, y_off, width, height, image);
 
                 if (color_table)
                 {
@@ -29,6 +29,8 @@
 #include <mapnik/util/variant.hpp>
 // boost
 #include <boost/optional.hpp>
+// stl
+#include <memory>
 
 class GDALDataset;
 class GDALRasterBand;
@@ -56,7 +58,7 @@ class gdal_featureset : public mapnik::Featureset
     };
 
 public:
-    gdal_featureset(GDALDataset& dataset,
+    gdal_featureset(std::shared_ptr<GDALDataset> const& dataset,
                     int band,
                     gdal_query q,
                     mapnik::box2d<double> extent,
@@ -80,6 +82,7 @@ private:
 
     mapnik::feature_ptr get_feature(mapnik::query const& q);
     mapnik::feature_ptr get_feature_at_point(mapnik::coord2d const& p);
+    std::shared_ptr<GDALDataset> handle_; // borrowed for the featureset lifetime
     GDALDataset & dataset_;
     mapnik::context_ptr ctx_;
     int band_;
@@ -28,6 +28,7 @@
 #include <mapnik/unicode.hpp>
 #include <mapnik/feature.hpp>
 #include <mapnik/feature_factory.hpp>
+#include <mapnik/geometry/box2d.hpp>
 #include <mapnik/util/noncopyable.hpp>
 #include <cmath>
 #include <cassert>
@@ -86,6 +87,7 @@ struct geobuf : util::noncopyable
     std::size_t lengths = 0;
     std::vector<std::string> keys_;
     std::vector<value_type> values_;
+    char const* data_;
     protozero::pbf_reader reader_;
     FeatureCallback & callback_;
     context_ptr ctx_;
@@ -93,7 +95,20 @@ struct geobuf : util::noncopyable
 public:
     //ctor
     geobuf (char const* buf, std::size_t size, FeatureCallback & callback)
-        : reader_(buf, size),
+        : data_(buf),
+          reader_(buf, size),
+          callback_(callback),
+          ctx_(std::make_shared<context_type>()),
+          tr_(new transcoder("utf8")) {}
+
+    // decoder of features previously located by `scan`
+    geobuf (char const* buf, std::size_t size, unsigned dimensions, double precision_,
+            std::vector<std::string> const& keys, FeatureCallback & callback)
+        : dim(dimensions),
+          precision(precision_),
+          keys_(keys),
+          data_(buf),
+          reader_(buf, size),
           callback_(callback),
           ctx_(std::make_shared<context_type>()),
           tr_(new transcoder("utf8")) {}
@@ -149,8 +164,87 @@ public:
         }
     }
 
+    // Single pass over the buffer which reads keys, dimensions and precision
+    // but does not decode features: the byte range of each Feature message
+    // (offset from the start of the buffer, size) and the bounding box of
+    // its geometry are passed to callback_(offset, size, box) instead.
+    // Returns false for a standalone Geometry, which has to be `read`.
+    bool scan()
+    {
+        while (reader_.next())
+        {
+            switch (reader_.tag())
+            {
+            case 1: // keys
+            {
+                keys_.push_back(reader_.get_string());
+                break;
+            }
+            case 2:
+            {
+                dim = reader_.get_uint32();
+                break;
+            }
+            case 3:
+            {
+                precision = std::pow(10,reader_.get_uint32());
+                break;
+            }
+            case 4:
+            {
+                auto feature_collection = reader_.get_message();
+                while (feature_collection.next())
+                {
+                    if (feature_collection.tag() == 1) scan_feature(feature_collection.get_view());
+                    else feature_collection.skip();
+                }
+                break;
+            }
+            case 5:
+            {
+                // standalone Feature
+                scan_feature(reader_.get_view());
+                break;
+            }
+            case 6:
+            {
+                // standalone Geometry
+                return false;
+            }
+            default:
+                MAPNIK_LOG_DEBUG(geobuf) << "Unsupported tag=" << reader_.tag();
+                reader_.skip();
+                break;
+            }
+        }
+        return true;
+    }
+
+    // decode the Feature message reported by `scan`
+    void read_feature_at(std::size_t offset, std::size_t size)
+    {
+        protozero::pbf_reader message(data_ + offset, size);
+        read_feature(message);
+    }
+
 private:
 
+    void scan_feature(protozero::data_view const& view)
+    {
+        box2d<double> box;
+        protozero::pbf_reader message(view);
+        while (message.next())
+        {
+            if (message.tag() == 1)
+            {
+                auto geometry = message.get_message();
+                read_envelope(geometry, box);
+            }
+            else message.skip();
+        }
+        callback_(static_cast<std::size_t>(view.data() - data_), static_cast<std::size_t>(view.size()), box);
+    }
+
     double transform(std::int64_t input)
     {
         return (transformed) ? (static_cast<double>(input)) : (input/precision);
@@ -513,6 +607,126 @@ private:
         return multi_poly;
     }
 
+    // bounding box straight from the packed coordinates, mirroring read_geometry
+    template <typename T>
+    void read_envelope(T & reader, box2d<double> & box)
+    {
+        geometry_type_e type = Unknown;
+        boost::optional<std::vector<std::uint32_t>> lengths;
+        while (reader.next())
+        {
+            switch (reader.tag())
+            {
+            case 1: // type
+            {
+                type = static_cast<geometry_type_e>(reader.get_uint32());
+                break;
+            }
+            case 2:
+            {
+                auto val = read_lengths(reader);
+                if (!val.empty()) lengths = std::move(val);
+                break;
+            }
+            case 3:
+            {
+                auto pi = reader.get_packed_sint64();
+                read_coords_envelope(pi.first, pi.second, type, lengths, box);
+                break;
+            }
+            case 4:
+            {
+                auto message = reader.get_message();
+                read_envelope(message, box);
+                break;
+            }
+            default:
+            {
+                reader.skip();
+                break;
+            }
+            }
+        }
+    }
+
+    template <typename Iterator>
+    void read_coords_envelope(Iterator begin, Iterator end, geometry_type_e type,
+                              boost::optional<std::vector<std::uint32_t>> const& lengths,
+                              box2d<double> & box)
+    {
+        switch (type)
+        {
+        case Point:
+        case MultiPoint:
+        case LineString:
+        {
+            read_ring_envelope(begin, end, box);
+            break;
+        }
+        case MultiLineString:
+        case Polygon:
+        {
+            if (!lengths)
+            {
+                read_ring_envelope(begin, end, box);
+            }
+            else
+            {
+                for (auto len : *lengths)
+                {
+                    auto next = std::next(begin, dim * len);
+                    read_ring_envelope(begin, next, box);
+                    begin = next;
+                }
+            }
+            break;
+        }
+        case MultiPolygon:
+        {
+            if (!lengths)
+            {
+                read_ring_envelope(begin, end, box);
+            }
+            else if ((*lengths).size() > 0)
+            {
+                std::size_t j = 1;
+                for (std::size_t i = 0; i < (*lengths)[0]; ++i)
+                {
+                    for (std::size_t k = 0; k < (*lengths)[j]; ++k)
+                    {
+                        auto next = std::next(begin, (*lengths)[j + k + 1] * dim);
+                        read_ring_envelope(begin, next, box);
+                        begin = next;
+                    }
+                    j += (*lengths)[j] + 1;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // coordinates are delta encoded from the start of each ring
+    template <typename Iterator>
+    void read_ring_envelope(Iterator begin, Iterator end, box2d<double> & box)
+    {
+        double x = 0.0;
+        double y = 0.0;
+        std::size_t count = 0;
+        for (auto it = begin; it != end; ++it, ++count)
+        {
+            auto d = count % dim;
+            if (d == 0) x += *it;
+            else if (d == 1)
+            {
+                y += *it;
+                box.expand_to_include(transform(x), transform(y));
+            }
+        }
+    }
+
     template <typename T>
     geometry::geometry<double> read_geometry(T & reader)
     {
@@ -22,6 +22,8 @@
 
 #include "geobuf_datasource.hpp"
 #include "geobuf_featureset.hpp"
+#include "geobuf_lazy_featureset.hpp"
+#include "geobuf_feature_store.hpp"
 #include "geobuf.hpp"
 
 #include <fstream>
@@ -45,6 +47,9 @@
 #include <mapnik/util/file_io.hpp>
 #include <mapnik/make_unique.hpp>
 #include <mapnik/geometry/boost_adapters.hpp>
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+#include <mapnik/mapped_memory_cache.hpp>
+#endif
 
 using mapnik::datasource;
 using mapnik::parameters;
@@ -97,7 +102,9 @@ geobuf_datasource::geobuf_datasource(parameters const& params)
       filename_(),
       extent_(),
       features_(),
-      tree_(nullptr)
+      tree_(nullptr),
+      store_(),
+      samples_()
 {
     boost::optional<std::string> file = params.get<std::string>("file");
     if (!file) throw mapnik::datasource_exception("Geobuf Plugin: missing <file> parameter");
@@ -109,15 +116,67 @@ geobuf_datasource::geobuf_datasource(parameters const& params)
         filename_ = *file;
 
 
-    mapnik::util::file in(filename_);
-    if (!in.is_open())
+    // keep the encoded features and decode them on demand
+    bool lazy_features = *params.get<mapnik::boolean_type>("lazy_features", false);
+    if (!lazy_features)
     {
-        throw mapnik::datasource_exception("Geobuf Plugin: could not open: '" + filename_ + "'");
+        mapnik::util::file in(filename_);
+        if (!in.is_open())
+        {
+            throw mapnik::datasource_exception("Geobuf Plugin: could not open: '" + filename_ + "'");
+        }
+        std::vector<char> geobuf;
+        geobuf.resize(in.size());
+        std::fread(geobuf.data(), in.size(), 1, in.get());
+        parse_geobuf(geobuf.data(), geobuf.size());
+    }
+    else
+    {
+#if !defined(MAPNIK_MEMORY_MAPPED_FILE)
+        mapnik::util::file in(filename_);
+        if (!in.is_open())
+        {
+            throw mapnik::datasource_exception("Geobuf Plugin: could not open: '" + filename_ + "'");
+        }
+        geobuf_feature_store::buffer_type buffer;
+        buffer.resize(in.size());
+        std::fread(&buffer[0], in.size(), 1, in.get());
+#else
+        boost::optional<mapnik::mapped_region_ptr> mapped_region =
+            mapnik::mapped_memory_cache::instance().find(filename_, false);
+        if (!mapped_region)
+        {
+            throw mapnik::datasource_exception("Geobuf Plugin: could not open: '" + filename_ + "'");
+        }
+        geobuf_feature_store::buffer_type buffer(std::move(*mapped_region));
+#endif
+        auto store = std::make_shared<geobuf_feature_store>(std::move(buffer));
+        // a standalone Geometry is always decoded up front
+        if (scan_geobuf(*store))
+        {
+            store_ = std::move(store);
+        }
+        else
+        {
+            parse_geobuf(store->data(), store->size());
+        }
+    }
+
+    vertex_importance_ = *params.get<mapnik::boolean_type>("vertex_importance", false);
+    vertex_importance_tolerance_ = *params.get<double>("vertex_importance_tolerance", 0.5);
+    if (vertex_importance_ && store_)
+    {
+        // importance is computed from decoded geometries, lazy features
+        // are only decoded when queried
+        MAPNIK_LOG_WARN(geobuf) << "geobuf_datasource: vertex_importance is ignored with lazy_features=true";
+    }
+    else if (vertex_importance_)
+    {
+        for (mapnik::feature_ptr const& f : features_)
+        {
+            importance_.push_back(f->get_geometry());
+        }
     }
-    std::vector<char> geobuf;
-    geobuf.resize(in.size());
-    std::fread(geobuf.data(), in.size(), 1, in.get());
-    parse_geobuf(geobuf.data(), geobuf.size());
 }
 
 namespace {
@@ -134,6 +193,49 @@ struct push_feature
     }
     features_container & features_;
 };
+
+// number of leading features inspected by get_geometry_type()
+constexpr std::size_t num_sample_features = 5;
+
+struct push_feature_range
+{
+    using values_container = std::vector<geobuf_datasource::item_type>;
+    using samples_container = std::vector<std::pair<std::size_t, std::size_t>>;
+    push_feature_range(values_container & values, samples_container & samples)
+        : values_(values),
+          samples_(samples) {}
+
+    void operator() (std::size_t offset, std::size_t size, mapnik::box2d<double> const& box)
+    {
+        if (samples_.size() < num_sample_features) samples_.emplace_back(offset, size);
+        if (box.valid()) values_.emplace_back(box, std::make_pair(offset, size));
+    }
+    values_container & values_;
+    samples_container & samples_;
+};
+
+template <typename Features>
+boost::optional<mapnik::datasource_geometry_t> geometry_type(Features const& features)
+{
+    boost::optional<mapnik::datasource_geometry_t> result;
+    int multi_type = 0;
+    std::size_t num_features = features.size();
+    for (std::size_t i = 0; i < num_features && i < num_sample_features; ++i)
+    {
+        result = mapnik::util::to_ds_type(features[i]->get_geometry());
+        if (result)
+        {
+            int type = static_cast<int>(*result);
+            if (multi_type > 0 && multi_type != type)
+            {
+                result.reset(mapnik::datasource_geometry_t::Collection);
+                return result;
+            }
+            multi_type = type;
+        }
+    }
+    return result;
+}
 }
 
 
@@ -175,6 +277,44 @@ void geobuf_datasource::parse_geobuf(char const* data, std::size_t size)
     tree_ = std::make_unique<spatial_index_type>(values);
 }
 
+bool geobuf_datasource::scan_geobuf(geobuf_feature_store & store)
+{
+    using values_container = push_feature_range::values_container;
+    values_container values;
+    push_feature_range callback(values, samples_);
+    mapnik::util::geobuf<push_feature_range> buf(store.data(), store.size(), callback);
+    if (!buf.scan())
+    {
+        samples_.clear();
+        return false;
+    }
+    store.keys = std::move(buf.keys_);
+    store.dim = buf.dim;
+    store.precision = buf.precision;
+    if (!values.empty())
+    {
+        // attributes are described after the first feature, as in parse_geobuf
+        geobuf_feature_decoder decode(store);
+        auto const& first = values.front().second;
+        mapnik::feature_ptr feature = decode(first.first, first.second);
+        for ( auto const& kv : *feature)
+        {
+            desc_.add_descriptor(mapnik::attribute_descriptor(std::get<0>(kv),
+                                                              mapnik::util::apply_visitor(attr_value_converter(),
+                                                                                          std::get<1>(kv))));
+        }
+        extent_ = values.front().first;
+        for (auto const& item : values)
+        {
+            extent_.expand_to_include(item.first);
+        }
+    }
+    MAPNIK_LOG_DEBUG(geobuf) << "geobuf_datasource: Scanned " << values.size() << " features";
+    // packing algorithm
+    tree_ = std::make_unique<spatial_index_type>(values);
+    return true;
+}
+
 geobuf_datasource::~geobuf_datasource() {}
 
 const char * geobuf_datasource::name()
@@ -184,24 +324,18 @@ const char * geobuf_datasource::name()
 
 boost::optional<mapnik::datasource_geometry_t> geobuf_datasource::get_geometry_type() const
 {
-    boost::optional<mapnik::datasource_geometry_t> result;
-    int multi_type = 0;
-    unsigned num_features = features_.size();
-    for (unsigned i = 0; i < num_features && i < 5; ++i)
+    if (store_)
     {
-        result = mapnik::util::to_ds_type(features_[i]->get_geometry());
-        if (result)
+        geobuf_feature_decoder decode(*store_);
+        std::vector<mapnik::feature_ptr> samples;
+        samples.reserve(samples_.size());
+        for (auto const& range : samples_)
         {
-            int type = static_cast<int>(*result);
-            if (multi_type > 0 && multi_type != type)
-            {
-                result.reset(mapnik::datasource_geometry_t::Collection);
-                return result;
-            }
-            multi_type = type;
+            samples.push_back(decode(range.first, range.second));
         }
+        return geometry_type(samples);
     }
-    return result;
+    return geometry_type(features_);
 }
 
 mapnik::datasource::datasource_t geobuf_datasource::type() const
@@ -229,7 +363,19 @@ mapnik::featureset_ptr geobuf_datasource::features(mapnik::query const& q) const
         if (tree_)
         {
             tree_->query(boost::geometry::index::intersects(box), std::back_inserter(index_array));
-            return std::make_shared<geobuf_featureset>(features_, std::move(index_array));
+            if (store_)
+            {
+                return std::make_shared<geobuf_lazy_featureset>(store_, std::move(index_array));
+            }
+            double min_importance = 0.0;
+            if (!importance_.empty())
+            {
+                auto const& res = q.resolution();
+                min_importance = mapnik::geometry::importance_threshold(std::get<0>(res), std::get<1>(res),
+                                                                        vertex_importance_tolerance_);
+            }
+            return std::make_shared<geobuf_featureset>(features_, std::move(index_array),
+                                                       importance_, min_importance);
         }
     }
     return mapnik::featureset_ptr();
@@ -32,6 +32,7 @@
 #include <mapnik/coord.hpp>
 #include <mapnik/feature_layer_desc.hpp>
 #include <mapnik/unicode.hpp>
+#include <mapnik/vertex_importance_cache.hpp>
 // boost
 #include <boost/optional.hpp>
 #include <mapnik/warning.hpp>
@@ -51,6 +52,8 @@ MAPNIK_DISABLE_WARNING_POP
 
 using mapnik::datasource;
 
+class geobuf_feature_store;
+
 template <std::size_t Max, std::size_t Min>
 struct geobuf_linear : boost::geometry::index::linear<Max,Min> {};
 
@@ -92,6 +95,7 @@ public:
     mapnik::layer_descriptor get_descriptor() const;
     boost::optional<mapnik::datasource_geometry_t> get_geometry_type() const;
     void parse_geobuf(char const* buffer, std::size_t size);
+    bool scan_geobuf(geobuf_feature_store & store);
 private:
     mapnik::datasource::datasource_t type_;
     mapnik::layer_descriptor desc_;
@@ -99,6 +103,11 @@ private:
     mapnik::box2d<double> extent_;
     std::vector<mapnik::feature_ptr> features_;
     std::unique_ptr<spatial_index_type> tree_;
+    mapnik::vertex_importance_cache importance_;
+    bool vertex_importance_ = false;
+    double vertex_importance_tolerance_ = 0.5;
+    std::shared_ptr<geobuf_feature_store const> store_; // lazy_features=true
+    std::vector<std::pair<std::size_t, std::size_t>> samples_; // leading features, lazy_features=true
 };
 
 
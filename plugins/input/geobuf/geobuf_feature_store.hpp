@@ -0,0 +1,87 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef GEOBUF_FEATURE_STORE_HPP
+#define GEOBUF_FEATURE_STORE_HPP
+
+// mapnik
+#include <mapnik/feature.hpp>
+#include <mapnik/util/noncopyable.hpp>
+#include <mapnik/util/file_buffer.hpp>
+
+#include "geobuf.hpp"
+
+// stl
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Encoded geobuf (`lazy_features=true`) together with the header fields
+// needed to decode the features located by `geobuf::scan`.
+class geobuf_feature_store : private mapnik::util::noncopyable
+{
+public:
+    using buffer_type = mapnik::util::file_buffer::buffer_type;
+
+    explicit geobuf_feature_store(buffer_type && buffer)
+        : buffer_(std::move(buffer)) {}
+
+    char const* data() const { return buffer_.data(); }
+    std::size_t size() const { return buffer_.size(); }
+
+    std::vector<std::string> keys;
+    unsigned dim = 2;
+    double precision = std::pow(10,6);
+
+private:
+    mapnik::util::file_buffer buffer_;
+};
+
+// Decodes features of a store one at a time. Not thread safe (features
+// share the decoder's context), so every featureset owns its own.
+class geobuf_feature_decoder : private mapnik::util::noncopyable
+{
+public:
+    explicit geobuf_feature_decoder(geobuf_feature_store const& store)
+        : callback_(),
+          decoder_(store.data(), store.size(), store.dim, store.precision, store.keys, callback_) {}
+
+    mapnik::feature_ptr operator() (std::size_t offset, std::size_t size)
+    {
+        decoder_.read_feature_at(offset, size);
+        return std::move(callback_.feature);
+    }
+
+private:
+    struct assign_feature
+    {
+        void operator() (mapnik::feature_ptr const& feature_)
+        {
+            feature = feature_;
+        }
+        mapnik::feature_ptr feature;
+    };
+    assign_feature callback_;
+    mapnik::util::geobuf<assign_feature> decoder_;
+};
+
+#endif // GEOBUF_FEATURE_STORE_HPP
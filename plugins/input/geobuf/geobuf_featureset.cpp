@@ -30,8 +30,13 @@
 
 #include "geobuf_featureset.hpp"
 
-geobuf_featureset::geobuf_featureset(std::vector<mapnik::feature_ptr> const& features,array_type && index_array)
+geobuf_featureset::geobuf_featureset(std::vector<mapnik::feature_ptr> const& features,
+                                     array_type && index_array,
+                                     mapnik::vertex_importance_cache const& importance,
+                                     double min_importance)
     : features_(features),
+      importance_(importance),
+      min_importance_(min_importance),
       index_array_(std::move(index_array)),
       index_itr_(index_array_.begin()),
       index_end_(index_array_.end()),
@@ -51,6 +56,11 @@ mapnik::feature_ptr geobuf_featureset::next()
 #endif
         if ( index < features_.size())
         {
+            if (min_importance_ > 0.0)
+            {
+                // drop vertices which are not significant at the query resolution
+                return importance_.filtered(features_[index], index, min_importance_);
+            }
             return features_.at(index);
         }
     }
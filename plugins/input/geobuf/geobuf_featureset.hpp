@@ -35,12 +35,16 @@ class geobuf_featureset : public mapnik::Featureset
 public:
     typedef std::deque<geobuf_datasource::item_type> array_type;
     geobuf_featureset(std::vector<mapnik::feature_ptr> const& features,
-                      array_type && index_array);
+                      array_type && index_array,
+                      mapnik::vertex_importance_cache const& importance,
+                      double min_importance);
     virtual ~geobuf_featureset();
     mapnik::feature_ptr next();
 
 private:
     std::vector<mapnik::feature_ptr> const& features_;
+    mapnik::vertex_importance_cache const& importance_;
+    double min_importance_;
     const array_type index_array_;
     array_type::const_iterator index_itr_;
     array_type::const_iterator index_end_;
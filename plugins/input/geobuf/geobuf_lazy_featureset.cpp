@@ -0,0 +1,47 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/feature.hpp>
+
+#include "geobuf_lazy_featureset.hpp"
+
+geobuf_lazy_featureset::geobuf_lazy_featureset(std::shared_ptr<geobuf_feature_store const> const& store,
+                                               array_type && index_array)
+    : store_(store),
+      index_array_(std::move(index_array)),
+      index_itr_(index_array_.begin()),
+      index_end_(index_array_.end()),
+      decode_(*store_) {}
+
+geobuf_lazy_featureset::~geobuf_lazy_featureset() {}
+
+mapnik::feature_ptr geobuf_lazy_featureset::next()
+{
+    if (index_itr_ != index_end_)
+    {
+        geobuf_datasource::item_type const& item = *index_itr_++;
+        // byte range of the Feature message recorded by the scan
+        return decode_(item.second.first, item.second.second);
+    }
+    return mapnik::feature_ptr();
+}
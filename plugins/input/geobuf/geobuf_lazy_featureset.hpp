@@ -0,0 +1,51 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef GEOBUF_LAZY_FEATURESET_HPP
+#define GEOBUF_LAZY_FEATURESET_HPP
+
+#include <mapnik/feature.hpp>
+#include "geobuf_datasource.hpp"
+#include "geobuf_feature_store.hpp"
+
+#include <deque>
+#include <memory>
+
+class geobuf_lazy_featureset : public mapnik::Featureset
+{
+public:
+    using array_type = std::deque<geobuf_datasource::item_type>;
+
+    geobuf_lazy_featureset(std::shared_ptr<geobuf_feature_store const> const& store,
+                           array_type && index_array);
+    virtual ~geobuf_lazy_featureset();
+    mapnik::feature_ptr next();
+
+private:
+    std::shared_ptr<geobuf_feature_store const> store_;
+    const array_type index_array_;
+    array_type::const_iterator index_itr_;
+    array_type::const_iterator index_end_;
+    geobuf_feature_decoder decode_;
+};
+
+#endif // GEOBUF_LAZY_FEATURESET_HPP
@@ -44,6 +44,8 @@ else:
       %(PLUGIN_NAME)s_featureset.cpp
       %(PLUGIN_NAME)s_index_featureset.cpp
       %(PLUGIN_NAME)s_memory_index_featureset.cpp
+      %(PLUGIN_NAME)s_lazy_featureset.cpp
+      %(PLUGIN_NAME)s_feature_store.cpp
 
       """ % locals()
     )
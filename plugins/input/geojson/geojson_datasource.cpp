@@ -24,6 +24,8 @@
 #include "geojson_featureset.hpp"
 #include "geojson_index_featureset.hpp"
 #include "geojson_memory_index_featureset.hpp"
+#include "geojson_lazy_featureset.hpp"
+#include "geojson_feature_store.hpp"
 #include <fstream>
 #include <algorithm>
 
@@ -52,6 +54,7 @@ MAPNIK_DISABLE_WARNING_POP
 #include <mapnik/geometry/boost_adapters.hpp>
 #include <mapnik/util/fs.hpp>
 #include <mapnik/util/spatial_index.hpp>
+#include <mapnik/util/parallel_for.hpp>
 #include <mapnik/geom_util.hpp>
 #include <mapnik/json/parse_feature.hpp>
 #include <mapnik/json/extract_bounding_boxes_x3.hpp>
@@ -132,6 +135,7 @@ geojson_datasource::geojson_datasource(parameters const& params)
         else
             filename_ = *file;
         has_disk_index_ = mapnik::util::exists(filename_ + ".index");
+        cache_ = mapnik::feature_cache::open(filename_, params);
     }
 
     if (inline_string)
@@ -141,6 +145,12 @@ geojson_datasource::geojson_datasource(parameters const& params)
         char const* end = start + inline_string->size();
         parse_geojson(start, end);
     }
+    else if (cache_)
+    {
+        // features were decoded by `mapnik-index --cache`
+        extent_ = cache_->envelope();
+        cache_->describe(desc_);
+    }
     else if (has_disk_index_)
     {
         initialise_disk_index(filename_);
@@ -148,6 +158,8 @@ geojson_datasource::geojson_datasource(parameters const& params)
     else
     {
         cache_features_ = *params.get<mapnik::boolean_type>("cache_features", true);
+        // keep the raw JSON in memory and parse features on demand
+        bool lazy_features = cache_features_ && *params.get<mapnik::boolean_type>("lazy_features", false);
 #if !defined(MAPNIK_MEMORY_MAPPED_FILE)
         mapnik::util::file file(filename_);
         if (!file)
@@ -171,7 +183,23 @@ geojson_datasource::geojson_datasource(parameters const& params)
         char const* start = reinterpret_cast<char const*>((*mapped_region)->get_address());
         char const* end = start + (*mapped_region)->get_size();
 #endif
-        if (cache_features_)
+        if (lazy_features)
+        {
+            std::vector<std::uint64_t> offsets;
+            cache_features_ = false;
+            initialise_index(start, end, &offsets);
+            if (!cache_features_) // not a single Feature or Geometry
+            {
+                std::size_t cache_size = static_cast<std::size_t>(
+                    std::max(mapnik::value_integer(0), *params.get<mapnik::value_integer>("feature_cache_size", 1024)));
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+                store_ = std::make_shared<geojson_feature_store>(std::move(*mapped_region), std::move(offsets), cache_size);
+#else
+                store_ = std::make_shared<geojson_feature_store>(std::move(file_buffer), std::move(offsets), cache_size);
+#endif
+            }
+        }
+        else if (cache_features_)
         {
             parse_geojson(start, end);
         }
@@ -180,6 +208,16 @@ geojson_datasource::geojson_datasource(parameters const& params)
             initialise_index(start, end);
         }
     }
+
+    vertex_importance_ = *params.get<mapnik::boolean_type>("vertex_importance", false);
+    vertex_importance_tolerance_ = *params.get<double>("vertex_importance_tolerance", 0.5);
+    if (cache_features_ && vertex_importance_)
+    {
+        for (mapnik::feature_ptr const& f : features_)
+        {
+            importance_.push_back(f->get_geometry());
+        }
+    }
 }
 
 namespace {
@@ -188,6 +226,8 @@ using box_type = box2d<double>;
 using boxes_type = std::vector<std::pair<box_type, std::pair<std::uint64_t, std::uint64_t>>>;
 using base_iterator_type = char const*;
 const mapnik::transcoder geojson_datasource_static_tr("utf8");
+// collections with fewer features per available thread are parsed serially
+constexpr std::size_t parallel_parsing_min_features = 1024;
 
 }
 
@@ -268,7 +308,7 @@ void parse_geometry_or_feature(Iterator& itr, Iterator const& end, feature_impl&
 
 
 template <typename Iterator>
-void geojson_datasource::initialise_index(Iterator start, Iterator end)
+void geojson_datasource::initialise_index(Iterator start, Iterator end, std::vector<std::uint64_t> * offsets)
 {
     boxes_type boxes;
     mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
@@ -279,6 +319,12 @@ void geojson_datasource::initialise_index(Iterator start, Iterator end)
         if (itr != end || boxes.empty()) throw std::exception();
         // bulk insert initialise r-tree
         tree_ = std::make_unique<spatial_index_type>(boxes);
+        if (offsets)
+        {
+            // feature offsets in input order, used to recover feature ids
+            offsets->reserve(boxes.size());
+            for (auto const& item : boxes) offsets->push_back(std::get<1>(item).first);
+        }
         // calculate total extent
         std::size_t feature_count = 0;
 
@@ -358,6 +404,46 @@ void geojson_datasource::initialise_index(Iterator start, Iterator end)
     desc_.order_by_name();
 }
 
+void geojson_datasource::bind_features_to_context(mapnik::context_ptr const& ctx)
+{
+    // contexts used by the features, in feature order (one per worker)
+    std::vector<mapnik::context_ptr> contexts;
+    for (mapnik::feature_ptr const& feature : features_)
+    {
+        if (contexts.empty() || feature->context() != contexts.back())
+        {
+            contexts.push_back(feature->context());
+        }
+    }
+    if (contexts.empty() || (contexts.size() == 1 && contexts.front() == ctx)) return;
+    // merging keys in feature order gives the same attribute order as
+    // parsing all features into `ctx` one after the other
+    for (mapnik::context_ptr const& local_ctx : contexts)
+    {
+        std::vector<std::pair<std::size_t, std::string>> keys;
+        for (auto const& kv : *local_ctx) keys.emplace_back(kv.second, kv.first);
+        std::sort(keys.begin(), keys.end());
+        for (auto const& key : keys) ctx->push(key.second);
+    }
+    // `ctx` is complete and only read from here on
+    mapnik::util::parallel_for(features_.size(), parallel_parsing_min_features,
+                               [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            mapnik::feature_ptr const& local_feature = features_[i];
+            if (local_feature->context() == ctx) continue;
+            mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, local_feature->id()));
+            for (auto const& kv : *local_feature)
+            {
+                feature->put(std::get<0>(kv), std::get<1>(kv));
+            }
+            feature->set_geometry(std::move(local_feature->get_geometry()));
+            features_[i] = std::move(feature);
+        }
+    });
+}
+
 template <typename Iterator>
 void geojson_datasource::parse_geojson(Iterator start, Iterator end)
 {
@@ -369,18 +455,34 @@ void geojson_datasource::parse_geojson(Iterator start, Iterator end)
         boxes_type boxes;
         mapnik::json::extract_bounding_boxes(itr, end, boxes);
         if (itr != end || boxes.empty()) throw std::exception(); //ensure we've consumed all input and we extracted at least one bbox;
-        for (auto const& item : boxes)
+        // features are independent once their extents are known, so large
+        // collections are parsed in parallel. Each worker uses its own context
+        // and transcoder, neither of which can be shared between threads;
+        // the contexts are merged afterwards (see bind_features_to_context).
+        features_.resize(boxes.size());
+        mapnik::util::parallel_for(boxes.size(), parallel_parsing_min_features,
+                                   [&](std::size_t first, std::size_t last)
         {
-            auto const& geometry_index = std::get<1>(item);
-            Iterator itr2 = start + geometry_index.first;
-            Iterator end2 = itr2 + geometry_index.second;
-            mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, start_id++));
-            mapnik::json::parse_feature(itr2, end2, *feature, geojson_datasource_static_tr);
-            features_.push_back(std::move(feature));
-        }
+            bool shared = (first == 0 && last == boxes.size());
+            mapnik::context_ptr local_ctx = shared ? ctx : std::make_shared<mapnik::context_type>();
+            std::unique_ptr<mapnik::transcoder> local_tr;
+            if (!shared) local_tr = std::make_unique<mapnik::transcoder>("utf8");
+            mapnik::transcoder const& tr = shared ? geojson_datasource_static_tr : *local_tr;
+            for (std::size_t i = first; i < last; ++i)
+            {
+                auto const& geometry_index = std::get<1>(boxes[i]);
+                Iterator itr2 = start + geometry_index.first;
+                Iterator end2 = itr2 + geometry_index.second;
+                mapnik::feature_ptr feature(mapnik::feature_factory::create(local_ctx, start_id + i));
+                mapnik::json::parse_feature(itr2, end2, *feature, tr);
+                features_[i] = std::move(feature);
+            }
+        });
+        bind_features_to_context(ctx);
     }
     catch (...)
     {
+        features_.clear();
         itr = start;
         // try parsing as single Feature or single Geometry JSON
         mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, start_id)); // single feature
@@ -450,6 +552,7 @@ mapnik::layer_descriptor geojson_datasource::get_descriptor() const
 
 boost::optional<mapnik::datasource_geometry_t> geojson_datasource::get_geometry_type() const
 {
+    if (cache_) return cache_->geometry_type();
     boost::optional<mapnik::datasource_geometry_t> result;
     int multi_type = 0;
     if (has_disk_index_)
@@ -568,6 +671,7 @@ boost::optional<mapnik::datasource_geometry_t> geojson_datasource::get_geometry_
 
 mapnik::featureset_ptr geojson_datasource::features(mapnik::query const& q) const
 {
+    if (cache_) return cache_->features(q);
     // if the query box intersects our world extent then query for features
     mapnik::box2d<double> const& box = q.get_bbox();
     if (extent_.intersects(box))
@@ -584,7 +688,19 @@ mapnik::featureset_ptr geojson_datasource::features(mapnik::query const& q) cons
                       });
             if (cache_features_)
             {
-                return std::make_shared<geojson_featureset>(features_, std::move(index_array));
+                double min_importance = 0.0;
+                if (!importance_.empty())
+                {
+                    auto const& res = q.resolution();
+                    min_importance = mapnik::geometry::importance_threshold(std::get<0>(res), std::get<1>(res),
+                                                                            vertex_importance_tolerance_);
+                }
+                return std::make_shared<geojson_featureset>(features_, std::move(index_array),
+                                                            importance_, min_importance);
+            }
+            else if (store_)
+            {
+                return std::make_shared<geojson_lazy_featureset>(store_, std::move(index_array));
             }
             else
             {
@@ -31,7 +31,9 @@
 #include <mapnik/geometry/box2d.hpp>
 #include <mapnik/coord.hpp>
 #include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/feature_cache.hpp>
 #include <mapnik/unicode.hpp>
+#include <mapnik/vertex_importance_cache.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -49,6 +51,8 @@ MAPNIK_DISABLE_WARNING_POP
 #include <deque>
 #include <functional>
 
+class geojson_feature_store;
+
 template <std::size_t Max, std::size_t Min>
 struct geojson_linear : boost::geometry::index::linear<Max,Min> {};
 
@@ -91,19 +95,25 @@ public:
     template <typename Iterator>
     void parse_geojson(Iterator start, Iterator end);
     template <typename Iterator>
-    void initialise_index(Iterator start, Iterator end);
+    void initialise_index(Iterator start, Iterator end, std::vector<std::uint64_t> * offsets = nullptr);
     void initialise_disk_index(std::string const& filename);
 private:
     void initialise_descriptor(mapnik::feature_ptr const&);
+    void bind_features_to_context(mapnik::context_ptr const& ctx);
     mapnik::datasource::datasource_t type_;
     mapnik::layer_descriptor desc_;
     std::string filename_;
     bool from_inline_string_;
     mapnik::box2d<double> extent_;
     std::vector<mapnik::feature_ptr> features_;
+    mapnik::vertex_importance_cache importance_;
     std::unique_ptr<spatial_index_type> tree_;
+    std::shared_ptr<geojson_feature_store const> store_; // lazy_features=true
+    std::shared_ptr<mapnik::feature_cache const> cache_; // <file>.fcache
     bool cache_features_ = true;
     bool has_disk_index_ = false;
+    bool vertex_importance_ = false;
+    double vertex_importance_tolerance_ = 0.5;
     const std::size_t num_features_to_query_;
 };
 
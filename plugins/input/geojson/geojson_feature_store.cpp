@@ -0,0 +1,80 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "geojson_feature_store.hpp"
+
+// stl
+#include <algorithm>
+
+geojson_feature_store::geojson_feature_store(buffer_type && buffer,
+                                             std::vector<std::uint64_t> && offsets,
+                                             std::size_t capacity)
+    : buffer_(std::move(buffer)),
+      offsets_(std::move(offsets)),
+      capacity_(capacity) {}
+
+mapnik::value_integer geojson_feature_store::feature_id(std::uint64_t offset) const
+{
+    auto itr = std::lower_bound(offsets_.begin(), offsets_.end(), offset);
+    return static_cast<mapnik::value_integer>(std::distance(offsets_.begin(), itr)) + 1;
+}
+
+mapnik::feature_ptr geojson_feature_store::find(mapnik::value_integer id) const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    auto itr = index_.find(id);
+    if (itr == index_.end()) return mapnik::feature_ptr();
+    lru_.splice(lru_.begin(), lru_, itr->second);
+    return itr->second->second;
+}
+
+void geojson_feature_store::insert(mapnik::value_integer id, mapnik::feature_ptr const& feature) const
+{
+    if (capacity_ == 0) return;
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    auto itr = index_.find(id);
+    if (itr != index_.end())
+    {
+        // parsed concurrently by another query
+        lru_.splice(lru_.begin(), lru_, itr->second);
+        return;
+    }
+    lru_.emplace_front(id, feature);
+    index_.emplace(id, lru_.begin());
+    if (lru_.size() > capacity_)
+    {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+std::size_t geojson_feature_store::cached() const
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    return lru_.size();
+}
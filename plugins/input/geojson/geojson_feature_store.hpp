@@ -0,0 +1,72 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef GEOJSON_FEATURE_STORE_HPP
+#define GEOJSON_FEATURE_STORE_HPP
+
+// mapnik
+#include <mapnik/feature.hpp>
+#include <mapnik/value/types.hpp>
+#include <mapnik/util/file_buffer.hpp>
+
+// stl
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
+
+// Raw GeoJSON text of a FeatureCollection (`lazy_features=true`) plus an
+// LRU of recently parsed features shared by all queries. Features are
+// identified by their position in the collection, starting from 1, which
+// matches the ids assigned when every feature is parsed up front.
+class geojson_feature_store
+{
+public:
+    using buffer_type = mapnik::util::file_buffer::buffer_type;
+    geojson_feature_store(buffer_type && buffer,
+                          std::vector<std::uint64_t> && offsets,
+                          std::size_t capacity);
+    char const* data() const { return buffer_.data(); }
+    // id of the feature starting at `offset`
+    mapnik::value_integer feature_id(std::uint64_t offset) const;
+    mapnik::feature_ptr find(mapnik::value_integer id) const;
+    void insert(mapnik::value_integer id, mapnik::feature_ptr const& feature) const;
+    std::size_t cached() const;
+
+private:
+    using lru_type = std::list<std::pair<mapnik::value_integer, mapnik::feature_ptr>>;
+    mapnik::util::file_buffer buffer_;
+    std::vector<std::uint64_t> const offsets_; // sorted feature offsets
+    std::size_t const capacity_;
+    mutable lru_type lru_; // most recently used first
+    mutable std::unordered_map<mapnik::value_integer, lru_type::iterator> index_;
+#ifdef MAPNIK_THREADSAFE
+    mutable std::mutex mutex_;
+#endif
+};
+
+#endif // GEOJSON_FEATURE_STORE_HPP
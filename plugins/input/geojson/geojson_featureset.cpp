@@ -30,8 +30,12 @@
 #include "geojson_featureset.hpp"
 
 geojson_featureset::geojson_featureset(std::vector<mapnik::feature_ptr> const& features,
-                                       array_type && index_array)
+                                       array_type && index_array,
+                                       mapnik::vertex_importance_cache const& importance,
+                                       double min_importance)
     : features_(features),
+      importance_(importance),
+      min_importance_(min_importance),
       index_array_(std::move(index_array)),
       index_itr_(index_array_.begin()),
       index_end_(index_array_.end()) {}
@@ -46,7 +50,13 @@ mapnik::feature_ptr geojson_featureset::next()
         std::size_t index = item.second.first;
         if ( index < features_.size())
         {
-            return features_.at(index);
+            mapnik::feature_ptr const& feature = features_[index];
+            if (min_importance_ > 0.0)
+            {
+                // drop vertices which are not significant at the query resolution
+                return importance_.filtered(feature, index, min_importance_);
+            }
+            return feature;
         }
     }
     return mapnik::feature_ptr();
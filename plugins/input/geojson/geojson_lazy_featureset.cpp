@@ -0,0 +1,64 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include "geojson_lazy_featureset.hpp"
+
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/geometry/is_empty.hpp>
+#include <mapnik/json/parse_feature.hpp>
+
+geojson_lazy_featureset::geojson_lazy_featureset(std::shared_ptr<geojson_feature_store const> const& store,
+                                                 array_type && index_array)
+    : store_(store),
+      index_array_(std::move(index_array)),
+      index_itr_(index_array_.begin()),
+      index_end_(index_array_.end()),
+      ctx_(std::make_shared<mapnik::context_type>()),
+      tr_("utf8") {}
+
+geojson_lazy_featureset::~geojson_lazy_featureset() {}
+
+mapnik::feature_ptr geojson_lazy_featureset::next()
+{
+    while (index_itr_ != index_end_)
+    {
+        geojson_datasource::item_type const& item = *index_itr_++;
+        std::uint64_t offset = item.second.first;
+        mapnik::value_integer id = store_->feature_id(offset);
+        mapnik::feature_ptr feature = store_->find(id);
+        if (!feature)
+        {
+            char const* start = store_->data() + offset;
+            char const* end = start + item.second.second;
+            feature = mapnik::feature_factory::create(ctx_, id);
+            mapnik::json::parse_feature(start, end, *feature, tr_); // throw on failure
+            store_->insert(id, feature);
+        }
+        // skip empty geometries
+        if (mapnik::geometry::is_empty(feature->get_geometry()))
+            continue;
+        return feature;
+    }
+    return mapnik::feature_ptr();
+}
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef GEOJSON_LAZY_FEATURESET_HPP
+#define GEOJSON_LAZY_FEATURESET_HPP
+
+#include <mapnik/feature.hpp>
+#include <mapnik/unicode.hpp>
+#include "geojson_datasource.hpp"
+#include "geojson_feature_store.hpp"
+
+#include <deque>
+#include <memory>
+
+class geojson_lazy_featureset : public mapnik::Featureset
+{
+public:
+    using array_type = std::deque<geojson_datasource::item_type>;
+
+    geojson_lazy_featureset(std::shared_ptr<geojson_feature_store const> const& store,
+                            array_type && index_array);
+    virtual ~geojson_lazy_featureset();
+    mapnik::feature_ptr next();
+
+private:
+    std::shared_ptr<geojson_feature_store const> store_;
+    const array_type index_array_;
+    array_type::const_iterator index_itr_;
+    array_type::const_iterator index_end_;
+    mapnik::context_ptr ctx_;
+    mapnik::transcoder tr_;
+};
+
+#endif // GEOJSON_LAZY_FEATURESET_HPP
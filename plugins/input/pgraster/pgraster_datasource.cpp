@@ -78,6 +78,7 @@ pgraster_datasource::pgraster_datasource(parameters const& params)
       prescale_rasters_(*params.get<mapnik::boolean_type>("prescale_rasters", false)),
       use_overviews_(*params.get<mapnik::boolean_type>("use_overviews", false)),
       clip_rasters_(*params.get<mapnik::boolean_type>("clip_rasters", false)),
+      raster_cache_(),
       desc_(*params.get<std::string>("type"), "utf-8"),
       creator_(params),
       re_tokens_("!(@?\\w+)!"), // matches  !mapnik_var!  or  !@user_var!
@@ -105,6 +106,18 @@ pgraster_datasource::pgraster_datasource(parameters const& params)
         extent_initialized_ = extent_.from_string(*ext);
     }
 
+    // overviews are used by default whenever they can be looked up,
+    // i.e. unless the table is a subquery or the lookup fails
+    boost::optional<mapnik::boolean_type> use_overviews = params.get<mapnik::boolean_type>("use_overviews");
+    bool const auto_overviews = !use_overviews;
+    if (auto_overviews) use_overviews_ = true;
+
+    value_integer raster_cache_size = *params.get<value_integer>("raster_cache_size", 0);
+    if (raster_cache_size > 0)
+    {
+        raster_cache_ = std::make_shared<pgraster_raster_cache>(raster_cache_size);
+    }
+
     // NOTE: In multithread environment, pool_max_size_ should be
     // max_async_connections_ * num_threads
     if(max_async_connections_ > 1)
@@ -144,14 +157,14 @@ pgraster_datasource::pgraster_datasource(parameters const& params)
             auto nsp = table_.find_first_not_of(" \t\r\n");
             if (nsp != std::string::npos && table_[nsp] == '(')
             {
-                if ( use_overviews_ )
+                if ( use_overviews_ && !auto_overviews )
                 {
                     std::ostringstream err;
                     err << "Pgraster Plugin: overviews cannot be used "
                            "with non-trivial subqueries";
                     MAPNIK_LOG_WARN(pgraster) << err.str();
-                    use_overviews_ = false;
                 }
+                use_overviews_ = false;
                 if ( ! extent_from_subquery_ ) {
                     std::ostringstream err;
                     err << "Pgraster Plugin: extent can only be computed "
@@ -290,6 +303,13 @@ pgraster_datasource::pgraster_datasource(parameters const& params)
 
         // If overviews were requested, take note of the max scale
         // of each available overview, sorted by scale descending
+        if ( use_overviews_ && auto_overviews &&
+             (parsed_schema_.empty() || geometryColumn_.empty()) )
+        {
+            MAPNIK_LOG_DEBUG(pgraster) << "pgraster_datasource: not using overviews, table "
+              << parsed_table_ << " is not registered in " << RASTER_COLUMNS;
+            use_overviews_ = false;
+        }
         if ( use_overviews_ )
         {
             std::ostringstream err;
@@ -324,29 +344,39 @@ pgraster_datasource::pgraster_datasource(parameters const& params)
                  " and r.r_raster_column = o.o_raster_column"
                  " ORDER BY scl ASC";
             MAPNIK_LOG_DEBUG(pgraster) << "pgraster_datasource: running query " << s.str();
-            shared_ptr<ResultSet> rs = conn->executeQuery(s.str());
-            while (rs->next())
+            try
             {
-                pgraster_overview ov = pgraster_overview();
+                shared_ptr<ResultSet> rs = conn->executeQuery(s.str());
+                while (rs->next())
+                {
+                    pgraster_overview ov = pgraster_overview();
 
-                ov.schema = rs->getValue("sch");
-                ov.table = rs->getValue("tab");
-                ov.column = rs->getValue("col");
-                ov.scale = atof(rs->getValue("scl"));
+                    ov.schema = rs->getValue("sch");
+                    ov.table = rs->getValue("tab");
+                    ov.column = rs->getValue("col");
+                    ov.scale = atof(rs->getValue("scl"));
 
-                if(ov.scale == 0.0f)
-                {
-                    MAPNIK_LOG_WARN(pgraster) << "pgraster_datasource: found invalid overview "
-                      << ov.schema << "." << ov.table << "." << ov.column << " with scale " << ov.scale;
-                    continue;
-                }
+                    if(ov.scale == 0.0f)
+                    {
+                        MAPNIK_LOG_WARN(pgraster) << "pgraster_datasource: found invalid overview "
+                          << ov.schema << "." << ov.table << "." << ov.column << " with scale " << ov.scale;
+                        continue;
+                    }
 
-                overviews_.push_back(ov);
+                    overviews_.push_back(ov);
 
-                MAPNIK_LOG_DEBUG(pgraster) << "pgraster_datasource: found overview "
-                  << ov.schema << "." << ov.table << "." << ov.column << " with scale " << ov.scale;
+                    MAPNIK_LOG_DEBUG(pgraster) << "pgraster_datasource: found overview "
+                      << ov.schema << "." << ov.table << "." << ov.column << " with scale " << ov.scale;
+                }
+                rs->close();
+            }
+            catch (mapnik::datasource_exception const& ex)
+            {
+                // a missing raster_overviews view only matters if overviews were asked for
+                if (!auto_overviews) throw;
+                MAPNIK_LOG_WARN(pgraster) << "pgraster_datasource: overviews lookup failed: " << ex.what();
+                overviews_.clear();
             }
-            rs->close();
             if ( overviews_.empty() ) {
                 MAPNIK_LOG_DEBUG(pgraster) << "pgraster_datasource: no overview found for "
                   << parsed_schema_ << "." << parsed_table_ << "." << geometryColumn_;
@@ -693,7 +723,8 @@ std::string pgraster_datasource::populate_tokens(std::string const& sql,
 }
 
 
-std::shared_ptr<IResultSet> pgraster_datasource::get_resultset(std::shared_ptr<Connection> &conn, std::string const& sql, CnxPool_ptr const& pool, processor_context_ptr ctx) const
+std::shared_ptr<IResultSet> pgraster_datasource::get_resultset(std::shared_ptr<Connection> &conn, std::string const& sql, CnxPool_ptr const& pool, processor_context_ptr ctx,
+                                                               std::vector<std::string> const& params) const
 {
 
     if (!ctx)
@@ -707,7 +738,7 @@ std::shared_ptr<IResultSet> pgraster_datasource::get_resultset(std::shared_ptr<C
 
             csql << "DECLARE " << cursor_name << " BINARY INSENSITIVE NO SCROLL CURSOR WITH HOLD FOR " << sql << " FOR READ ONLY";
 
-            if (! conn->execute(csql.str()))
+            if (! conn->execute(csql.str(), params))
             {
                 // TODO - better error
                 throw mapnik::datasource_exception("Pgraster Plugin: error creating cursor for data select." );
@@ -719,7 +750,7 @@ std::shared_ptr<IResultSet> pgraster_datasource::get_resultset(std::shared_ptr<C
         else
         {
             // no cursor
-            return conn->executeQuery(sql, 1);
+            return conn->executeQuery(sql, 1, params);
         }
     }
     else
@@ -729,13 +760,13 @@ std::shared_ptr<IResultSet> pgraster_datasource::get_resultset(std::shared_ptr<C
         if (conn)
         {
             // lauch async req & create asyncresult with conn
-            conn->executeAsyncQuery(sql, 1);
-            return std::make_shared<AsyncResultSet>(pgis_ctxt, pool, conn, sql);
+            conn->executeAsyncQuery(sql, 1, params);
+            return std::make_shared<AsyncResultSet>(pgis_ctxt, pool, conn, sql, false, params);
         }
         else
         {
             // create asyncresult  with  null connection
-            std::shared_ptr<AsyncResultSet> res = std::make_shared<AsyncResultSet>(pgis_ctxt, pool,  conn, sql);
+            std::shared_ptr<AsyncResultSet> res = std::make_shared<AsyncResultSet>(pgis_ctxt, pool,  conn, sql, false, params);
             pgis_ctxt->add_request(res);
             return res;
         }
@@ -844,10 +875,15 @@ featureset_ptr pgraster_datasource::features_with_context(query const& q,process
         std::string col = geometryColumn_;
         table_with_bbox = table_; // possibly a subquery
 
+        // table the rasters are actually read from, keys the raster cache
+        std::string source_table = parsed_schema_.empty() ? parsed_table_ : parsed_schema_ + "." + parsed_table_;
+
         if ( use_overviews_ && !overviews_.empty()) {
-          std::string sch = overviews_[0].schema;
-          std::string tab = overviews_[0].table;
-          col = overviews_[0].column;
+          // fall back to the base table when the output resolution is
+          // finer than that of every overview
+          std::string sch = parsed_schema_;
+          std::string tab = parsed_table_;
+          col = geometryColumn_;
           const double scale = std::min(px_gw, px_gh);
           std::vector<pgraster_overview>::const_reverse_iterator i;
           for (i=overviews_.rbegin(); i!=overviews_.rend(); ++i) {
@@ -870,16 +906,52 @@ featureset_ptr pgraster_datasource::features_with_context(query const& q,process
                 << " not good for min out scale " << scale;
             }
           }
-          boost::algorithm::replace_all(table_with_bbox, parsed_table_, tab);
-          boost::algorithm::replace_all(table_with_bbox, parsed_schema_, sch);
-          boost::algorithm::replace_all(table_with_bbox, geometryColumn_, col);
+          if (tab != parsed_table_ || sch != parsed_schema_)
+          {
+            boost::algorithm::replace_all(table_with_bbox, parsed_table_, tab);
+            boost::algorithm::replace_all(table_with_bbox, parsed_schema_, sch);
+            boost::algorithm::replace_all(table_with_bbox, geometryColumn_, col);
+            source_table = sch + "." + tab;
+          }
         }
         table_with_bbox = populate_tokens(table_with_bbox, scale_denom, box,
                                           px_gw, px_gh, q.variables());
 
+        // Decoded rasters only depend on the row when they are neither
+        // clipped nor resized to the query, and can only be told apart
+        // with a key field. Rasters already cached are not transferred:
+        // the query returns a null raster for them instead.
+        std::shared_ptr<pgraster_raster_cache> cache;
+        pgraster_raster_cache::snapshot_type cached;
+        if (raster_cache_ && !key_field_.empty() && !clip_rasters_ && !prescale_rasters_)
+        {
+            cache = raster_cache_;
+            cached = cache->find(source_table, box);
+        }
+
         std::ostringstream s;
 
-        s << "SELECT ST_AsBinary(";
+        s << "SELECT ";
+
+        // the cached ids are sent as one array parameter
+        std::vector<std::string> params;
+        if (!cached.empty())
+        {
+            std::ostringstream ids;
+            ids << '{';
+            bool first = true;
+            for (auto const& kv : cached)
+            {
+                if (!first) ids << ',';
+                ids << kv.first;
+                first = false;
+            }
+            ids << '}';
+            params.push_back(ids.str());
+            s << "CASE WHEN " << identifier(key_field_) << " = ANY($1::int8[]) THEN NULL ELSE ";
+        }
+
+        s << "ST_AsBinary(";
 
         if (band_) s << "ST_Band(";
 
@@ -908,7 +980,11 @@ featureset_ptr pgraster_datasource::features_with_context(query const& q,process
 
         if (band_) s << ", " << band_ << ")";
 
-        s << ") AS geom";
+        s << ")";
+
+        if (!cached.empty()) s << " END";
+
+        s << " AS geom";
 
         mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
         std::set<std::string> const& props = q.property_names();
@@ -948,12 +1024,13 @@ featureset_ptr pgraster_datasource::features_with_context(query const& q,process
         MAPNIK_LOG_DEBUG(pgraster) << "pgraster_datasource: "
           "features query: " << s.str();
 
-        std::shared_ptr<IResultSet> rs = get_resultset(conn, s.str(), pool, proc_ctx);
+        std::shared_ptr<IResultSet> rs = get_resultset(conn, s.str(), pool, proc_ctx, params);
         return std::make_shared<pgraster_featureset>(rs, ctx,
                   desc_.get_encoding(), !key_field_.empty(),
-                  band_ ? 1 : 0 // whatever band number is given we'd have
-                                // extracted with ST_Band above so it becomes
-                                // band number 1
+                  band_ ? 1 : 0, // whatever band number is given we'd have
+                                 // extracted with ST_Band above so it becomes
+                                 // band number 1
+                  cache, source_table, std::move(cached)
                );
 
     }
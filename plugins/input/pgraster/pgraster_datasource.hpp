@@ -50,6 +50,7 @@
 #include "../postgis/connection_manager.hpp"
 #include "../postgis/resultset.hpp"
 #include "../postgis/cursorresultset.hpp"
+#include "pgraster_raster_cache.hpp"
 
 using mapnik::transcoder;
 using mapnik::datasource;
@@ -97,7 +98,8 @@ private:
                                 mapnik::attributes const& vars,
                                 bool intersect = true) const;
     std::string populate_tokens(std::string const& sql) const;
-    std::shared_ptr<IResultSet> get_resultset(std::shared_ptr<Connection> &conn, std::string const& sql, CnxPool_ptr const& pool, processor_context_ptr ctx= processor_context_ptr()) const;
+    std::shared_ptr<IResultSet> get_resultset(std::shared_ptr<Connection> &conn, std::string const& sql, CnxPool_ptr const& pool, processor_context_ptr ctx= processor_context_ptr(),
+                                              std::vector<std::string> const& params = std::vector<std::string>()) const;
     static const std::string RASTER_COLUMNS;
     static const std::string RASTER_OVERVIEWS;
     static const std::string SPATIAL_REF_SYS;
@@ -130,6 +132,8 @@ private:
     bool prescale_rasters_;
     bool use_overviews_;
     bool clip_rasters_;
+    // decoded rasters, shared by all queries against this datasource
+    std::shared_ptr<pgraster_raster_cache> raster_cache_;
     layer_descriptor desc_;
     ConnectionCreator<Connection> creator_;
     std::regex re_tokens_;
@@ -53,13 +53,19 @@ using mapnik::context_ptr;
 pgraster_featureset::pgraster_featureset(std::shared_ptr<IResultSet> const& rs,
                                        context_ptr const& ctx,
                                        std::string const& encoding,
-                                       bool key_field, int bandno)
+                                       bool key_field, int bandno,
+                                       std::shared_ptr<pgraster_raster_cache> const& cache,
+                                       std::string const& cache_table,
+                                       pgraster_raster_cache::snapshot_type && cached)
     : rs_(rs),
       ctx_(ctx),
       tr_(new transcoder(encoding)),
       feature_id_(1),
       key_field_(key_field),
-      band_(bandno)
+      band_(bandno),
+      cache_(key_field ? cache : nullptr),
+      cache_table_(cache_table),
+      cached_(std::move(cached))
 {
 }
 
@@ -70,6 +76,7 @@ feature_ptr pgraster_featureset::next()
         // new feature
         unsigned pos = 1;
         feature_ptr feature;
+        mapnik::value_integer key = 0;
 
         if (key_field_)
         {
@@ -103,6 +110,7 @@ feature_ptr pgraster_featureset::next()
 
             MAPNIK_LOG_WARN(pgraster) << "pgraster_featureset: feature key: " << val;
 
+            key = val;
             feature = feature_factory::create(ctx_, val);
             // TODO - extend feature class to know
             // that its id is also an attribute to avoid
@@ -119,23 +127,34 @@ feature_ptr pgraster_featureset::next()
             ++feature_id_;
         }
 
-        // null geometry is not acceptable
+        mapnik::raster_ptr raster;
         if (rs_->isNull(0))
         {
-            MAPNIK_LOG_WARN(pgraster) << "pgraster_featureset: null value encountered for raster";
-            continue;
+            // the query skips rasters we already hold a decoded copy of
+            auto itr = cached_.find(key);
+            if (!cache_ || itr == cached_.end())
+            {
+                // null geometry is not acceptable
+                MAPNIK_LOG_WARN(pgraster) << "pgraster_featureset: null value encountered for raster";
+                continue;
+            }
+            raster = pgraster_raster_cache::clone(*itr->second);
+            cached_.erase(itr);
         }
-
-        // parse geometry
-        int size = rs_->getFieldLength(0);
-        const uint8_t *data = (const uint8_t*)rs_->getValue(0);
-
-        mapnik::raster_ptr raster = pgraster_wkb_reader::read(data, size, band_);
-        if (!raster)
+        else
         {
-            MAPNIK_LOG_WARN(pgraster) << "pgraster_featureset: could not parse raster wkb";
-            // TODO: throw an exception ?
-            continue;
+            // parse geometry
+            int size = rs_->getFieldLength(0);
+            const uint8_t *data = (const uint8_t*)rs_->getValue(0);
+
+            raster = pgraster_wkb_reader::read(data, size, band_);
+            if (!raster)
+            {
+                MAPNIK_LOG_WARN(pgraster) << "pgraster_featureset: could not parse raster wkb";
+                // TODO: throw an exception ?
+                continue;
+            }
+            if (cache_) cache_->insert(cache_table_, key, *raster);
         }
         MAPNIK_LOG_WARN(pgraster) << "pgraster_featureset: raster of " << raster->data_.width() << "x" << raster->data_.height() << " pixels covering extent " << raster->ext_;
         feature->set_raster(raster);
@@ -33,8 +33,11 @@
 #include <mapnik/feature.hpp>
 #include <mapnik/unicode.hpp>
 
+#include "pgraster_raster_cache.hpp"
+
 // stl
 #include <memory>
+#include <string>
 
 using mapnik::Featureset;
 using mapnik::box2d;
@@ -51,11 +54,18 @@ public:
     /// @param bandno band number (1-based). 0 (default) reads all bands.
     ///               Anything else forces interpretation of colors off
     ///               (values copied verbatim)
+    /// @param cache  decoded raster cache (requires key_field), or null
+    /// @param cache_table table the rasters are read from, used as cache key
+    /// @param cached rasters for which the query returned a null raster
+    ///               because a decoded copy was already cached
     pgraster_featureset(std::shared_ptr<IResultSet> const& rs,
                        context_ptr const& ctx,
                        std::string const& encoding,
                        bool key_field = false,
-                       int bandno = 0);
+                       int bandno = 0,
+                       std::shared_ptr<pgraster_raster_cache> const& cache = nullptr,
+                       std::string const& cache_table = "",
+                       pgraster_raster_cache::snapshot_type && cached = pgraster_raster_cache::snapshot_type());
     feature_ptr next();
     ~pgraster_featureset();
 
@@ -66,6 +76,9 @@ private:
     mapnik::value_integer feature_id_;
     bool key_field_;
     int band_;
+    std::shared_ptr<pgraster_raster_cache> cache_;
+    std::string cache_table_;
+    pgraster_raster_cache::snapshot_type cached_;
 };
 
 #endif // PGRASTER_FEATURESET_HPP
@@ -0,0 +1,151 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef PGRASTER_RASTER_CACHE_HPP
+#define PGRASTER_RASTER_CACHE_HPP
+
+// mapnik
+#include <mapnik/feature.hpp>
+#include <mapnik/raster.hpp>
+#include <mapnik/image_any.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/value/types.hpp>
+#include <mapnik/util/noncopyable.hpp>
+
+// stl
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
+
+// LRU cache of decoded rasters keyed by (table, key_field value). The
+// table is the one actually queried, so each overview level gets its
+// own entries. Cached rasters are immutable and shared with lookups;
+// renderers are allowed to modify the raster of a feature (e.g.
+// premultiplying alpha), so a feature gets its own copy via clone().
+class pgraster_raster_cache : private mapnik::util::noncopyable
+{
+public:
+    using raster_cptr = std::shared_ptr<const mapnik::raster>;
+    using snapshot_type = std::map<mapnik::value_integer, raster_cptr>;
+
+    explicit pgraster_raster_cache(std::size_t capacity)
+        : capacity_(capacity) {}
+
+    std::size_t capacity() const { return capacity_; }
+
+    std::size_t size() const
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        return entries_.size();
+    }
+
+    void insert(std::string const& table, mapnik::value_integer id, mapnik::raster const& r)
+    {
+        if (capacity_ == 0) return;
+        raster_cptr copy = clone(r);
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        auto & rows = tables_[table];
+        auto itr = rows.find(id);
+        if (itr != rows.end())
+        {
+            itr->second->raster = std::move(copy);
+            entries_.splice(entries_.begin(), entries_, itr->second);
+            return;
+        }
+        entries_.push_front(entry_type{table, id, std::move(copy)});
+        rows.emplace(id, entries_.begin());
+        while (entries_.size() > capacity_)
+        {
+            entry_type const& last = entries_.back();
+            auto t = tables_.find(last.table);
+            t->second.erase(last.id);
+            if (t->second.empty()) tables_.erase(t);
+            entries_.pop_back();
+        }
+    }
+
+    // Cached rasters of `table` whose extent intersects `box`, only the
+    // entries of that table are visited.
+    snapshot_type find(std::string const& table, mapnik::box2d<double> const& box)
+    {
+        snapshot_type result;
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        auto t = tables_.find(table);
+        if (t == tables_.end()) return result;
+        for (auto const& row : t->second)
+        {
+            if (row.second->raster->ext_.intersects(box))
+            {
+                result.emplace(row.first, row.second->raster);
+                entries_.splice(entries_.begin(), entries_, row.second);
+            }
+        }
+        return result;
+    }
+
+    void clear()
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        tables_.clear();
+        entries_.clear();
+    }
+
+    static mapnik::raster_ptr clone(mapnik::raster const& r)
+    {
+        mapnik::raster_ptr copy = std::make_shared<mapnik::raster>(r.ext_, r.query_ext_,
+                                                                   mapnik::image_any(r.data_),
+                                                                   r.filter_factor_);
+        if (r.nodata_) copy->set_nodata(*r.nodata_);
+        return copy;
+    }
+
+private:
+    struct entry_type
+    {
+        std::string table;
+        mapnik::value_integer id;
+        raster_cptr raster;
+    };
+    using entry_list = std::list<entry_type>;
+    std::size_t capacity_;
+    entry_list entries_;
+    std::unordered_map<std::string, std::unordered_map<mapnik::value_integer, entry_list::iterator>> tables_;
+#ifdef MAPNIK_THREADSAFE
+    mutable std::mutex mutex_;
+#endif
+};
+
+#endif // PGRASTER_RASTER_CACHE_HPP
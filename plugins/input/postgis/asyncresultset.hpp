@@ -20,6 +20,7 @@
  *
  *****************************************************************************/
 
+
 #ifndef POSTGIS_ASYNCRESULTSET_HPP
 #define POSTGIS_ASYNCRESULTSET_HPP
 
@@ -29,7 +30,16 @@
 #include "connection_manager.hpp"
 #include "resultset.hpp"
 #include <queue>
+#include <deque>
 #include <memory>
+#include <string>
+#include <vector>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <exception>
+#endif
 
 class postgis_processor_context;
 using postgis_processor_context_ptr = std::shared_ptr<postgis_processor_context>;
@@ -39,12 +49,20 @@ class AsyncResultSet : public IResultSet, private mapnik::util::noncopyable
 public:
     AsyncResultSet(postgis_processor_context_ptr const& ctx,
                      std::shared_ptr< Pool<Connection,ConnectionCreator> > const& pool,
-                     std::shared_ptr<Connection> const& conn, std::string const& sql )
+                     std::shared_ptr<Connection> const& conn, std::string const& sql,
+                     bool prefetch = false,
+                     std::vector<std::string> const& params = std::vector<std::string>())
         : ctx_(ctx),
           pool_(pool),
           conn_(conn),
           sql_(sql),
-          is_closed_(false)
+          params_(params),
+          is_closed_(false),
+#ifdef MAPNIK_THREADSAFE
+          prefetch_(prefetch)
+#else
+          prefetch_(false)
+#endif
     {
     }
 
@@ -69,6 +87,36 @@ public:
 
     virtual void close()
     {
+#ifdef MAPNIK_THREADSAFE
+        if (prefetch_)
+        {
+            std::future<result_list> pending;
+            std::shared_ptr<inflight_query> inflight;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (is_closed_) return;
+                is_closed_ = true;
+                pending = std::move(prefetched_);
+                inflight = std::move(inflight_);
+            }
+            if (inflight)
+            {
+                // results nobody reads are not worth downloading; the worker
+                // gets an error back and closes the connection
+                std::lock_guard<std::mutex> lock(inflight->mutex);
+                if (inflight->cancel)
+                {
+                    MAPNIK_LOG_DEBUG(postgis) << "AsyncResultSet: cancelling prefetched query";
+                    char errbuf[256];
+                    PQcancel(inflight->cancel.get(), errbuf, sizeof(errbuf));
+                }
+            }
+            if (pending.valid()) pending.wait();
+            rs_.reset();
+            results_.clear();
+            return;
+        }
+#endif
         if (!is_closed_)
         {
             rs_.reset();
@@ -84,6 +132,20 @@ public:
         }
     }
 
+    // Sends the query and receives its results on a worker thread so that
+    // the transfer overlaps with rendering of the preceding layers. The
+    // connection goes back to the pool, and the next queued query is sent,
+    // as soon as the results are in.
+    void start_prefetch()
+    {
+#ifdef MAPNIK_THREADSAFE
+        if (!send())
+        {
+            prefetch_next(ctx_);
+        }
+#endif
+    }
+
     virtual int getNumFields() const
     {
         return rs_->getNumFields();
@@ -91,33 +153,21 @@ public:
 
     virtual bool next()
     {
-        bool next_res = false;
         if (!rs_)
         {
-            // Ensure connection is valid
-            if (conn_ && conn_->isOK())
-            {
-                rs_ = conn_->getAsyncResult();
-            }
-            else
-            {
-                throw mapnik::datasource_exception("invalid connection in AsyncResultSet::next");
-            }
+            rs_ = first_result();
         }
-
-        next_res = rs_->next();
-        if (!next_res)
+        while (!rs_->next())
         {
-            rs_.reset();
-            rs_ = conn_->getNextAsyncResult();
-            if (rs_ && rs_->next())
+            rs_ = next_result();
+            if (!rs_)
             {
-                return true;
+                close();
+                if (!prefetch_) prepare_next();
+                return false;
             }
-            close();
-            prepare_next();
         }
-        return next_res;
+        return true;
     }
 
     virtual const char* getFieldName(int index) const
@@ -161,19 +211,145 @@ public:
     }
 
 private:
+    using result_list = std::deque<std::shared_ptr<ResultSet>>;
+
     postgis_processor_context_ptr ctx_;
     std::shared_ptr< Pool<Connection,ConnectionCreator> > pool_;
     std::shared_ptr<Connection> conn_;
     std::string sql_;
+    std::vector<std::string> params_;
     std::shared_ptr<ResultSet> rs_;
     bool is_closed_;
+    bool prefetch_;
+    result_list results_;
+#ifdef MAPNIK_THREADSAFE
+    // guards the hand over of a queued request to the worker which sends it
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::future<result_list> prefetched_;
+    std::exception_ptr error_;
+    // lets close() cancel the query while the worker receives its results,
+    // the worker drops the handle before the connection returns to the pool
+    struct inflight_query
+    {
+        std::mutex mutex;
+        std::shared_ptr<PGcancel> cancel;
+    };
+    std::shared_ptr<inflight_query> inflight_;
+#endif
+
+#ifdef MAPNIK_THREADSAFE
+    // a failure is reported from next()
+    bool send()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (is_closed_) return false;
+        try
+        {
+            prepare();
+            prefetched_ = fetch_async();
+            ready_.notify_all();
+            return true;
+        }
+        catch (...)
+        {
+            MAPNIK_LOG_ERROR(postgis) << "AsyncResultSet: failed to send query";
+            conn_.reset();
+            error_ = std::current_exception();
+            ready_.notify_all();
+        }
+        return false;
+    }
+
+    std::future<result_list> fetch_async()
+    {
+        std::shared_ptr<Connection> conn = std::move(conn_);
+        postgis_processor_context_ptr ctx = ctx_;
+        std::shared_ptr<inflight_query> inflight = std::make_shared<inflight_query>();
+        inflight->cancel = conn->cancelHandle();
+        inflight_ = inflight;
+        return std::async(std::launch::async, [conn, ctx, inflight]() mutable
+        {
+            auto done = [&conn, &inflight]()
+            {
+                std::lock_guard<std::mutex> lock(inflight->mutex);
+                inflight->cancel.reset();
+                conn.reset();
+            };
+            result_list results;
+            try
+            {
+                results.push_back(conn->getAsyncResult());
+                while (conn->isPending())
+                {
+                    results.push_back(conn->getNextAsyncResult());
+                }
+            }
+            catch (...)
+            {
+                done();
+                prefetch_next(ctx);
+                throw;
+            }
+            done();
+            prefetch_next(ctx);
+            return results;
+        });
+    }
+#endif
+
+    std::shared_ptr<ResultSet> first_result()
+    {
+#ifdef MAPNIK_THREADSAFE
+        if (prefetch_)
+        {
+            // a queued request is sent by whichever worker frees a connection first
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return prefetched_.valid() || error_ || is_closed_; });
+            if (error_) std::rethrow_exception(error_);
+            if (is_closed_)
+            {
+                throw mapnik::datasource_exception("invalid connection in AsyncResultSet::next");
+            }
+            std::future<result_list> f = std::move(prefetched_);
+            lock.unlock();
+            results_ = f.get();
+            return next_result();
+        }
+#endif
+        // Ensure connection is valid
+        if (conn_ && conn_->isOK())
+        {
+            return conn_->getAsyncResult();
+        }
+        throw mapnik::datasource_exception("invalid connection in AsyncResultSet::next");
+    }
+
+    std::shared_ptr<ResultSet> next_result()
+    {
+        if (prefetch_)
+        {
+            std::shared_ptr<ResultSet> rs;
+            if (!results_.empty())
+            {
+                rs = std::move(results_.front());
+                results_.pop_front();
+            }
+            return rs;
+        }
+        if (conn_ && conn_->isPending())
+        {
+            return conn_->getNextAsyncResult();
+        }
+        return std::shared_ptr<ResultSet>();
+    }
 
     void prepare()
     {
         conn_ = pool_->borrowObject();
         if (conn_ && conn_->isOK())
         {
-            conn_->executeAsyncQuery(sql_, 1);
+            conn_->executeAsyncQuery(sql_, 1, params_);
         }
         else
         {
@@ -182,6 +358,7 @@ private:
     }
 
     void prepare_next();
+    static void prefetch_next(postgis_processor_context_ptr const& ctx);
 
 };
 
@@ -195,17 +372,60 @@ public:
 
     void add_request(std::shared_ptr<AsyncResultSet> const& req)
     {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
         q_.push(req);
     }
 
     std::shared_ptr<AsyncResultSet> pop_next_request()
     {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        std::shared_ptr<AsyncResultSet> r;
+        if (!q_.empty())
+        {
+            r = q_.front();
+            q_.pop();
+        }
+        return r;
+    }
+
+    // prefetching requests give their slot back once their results are
+    // received, so the count tracks queries in flight. Returns false when
+    // all slots are taken, the request is then queued.
+    bool acquire_request(int max_requests, std::shared_ptr<AsyncResultSet> const& req)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        if (num_async_requests_ < max_requests)
+        {
+            ++num_async_requests_;
+            return true;
+        }
+        q_.push(req);
+        return false;
+    }
+
+    // hands the slot of a completed request over to the next queued one,
+    // or releases it when nothing is waiting
+    std::shared_ptr<AsyncResultSet> release_request()
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
         std::shared_ptr<AsyncResultSet> r;
         if (!q_.empty())
         {
             r = q_.front();
             q_.pop();
         }
+        else
+        {
+            --num_async_requests_;
+        }
         return r;
     }
 
@@ -214,6 +434,9 @@ public:
 private:
     using async_queue = std::queue<std::shared_ptr<AsyncResultSet> >;
     async_queue q_;
+#ifdef MAPNIK_THREADSAFE
+    std::mutex mutex_;
+#endif
 
 };
 
@@ -227,4 +450,16 @@ inline void AsyncResultSet::prepare_next()
     }
 }
 
+inline void AsyncResultSet::prefetch_next(postgis_processor_context_ptr const& ctx)
+{
+#ifdef MAPNIK_THREADSAFE
+    std::shared_ptr<AsyncResultSet> next = ctx->release_request();
+    // a request which could not be sent passes its slot on
+    while (next && !next->send())
+    {
+        next = ctx->release_request();
+    }
+#endif
+}
+
 #endif // POSTGIS_ASYNCRESULTSET_HPP
@@ -32,6 +32,8 @@
 #include <memory>
 #include <sstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include "libpq-fe.h"
@@ -89,13 +91,13 @@ public:
         }
     }
 
-    bool execute(std::string const& sql)
+    bool execute(std::string const& sql, std::vector<std::string> const& params = std::vector<std::string>())
     {
 #ifdef MAPNIK_STATS
         mapnik::progress_timer __stats__(std::clog, std::string("postgis_connection::execute ") + sql);
 #endif
 
-        if ( ! executeAsyncQuery(sql) ) return false;
+        if ( ! executeAsyncQuery(sql, 0, params) ) return false;
         PGresult *result = 0;
         // fetch multiple times until NULL is returned,
         // to handle multi-statement queries
@@ -108,13 +110,14 @@ public:
         return ok;
     }
 
-    std::shared_ptr<ResultSet> executeQuery(std::string const& sql, int type = 0)
+    std::shared_ptr<ResultSet> executeQuery(std::string const& sql, int type = 0,
+                                            std::vector<std::string> const& params = std::vector<std::string>())
     {
 #ifdef MAPNIK_STATS
         mapnik::progress_timer __stats__(std::clog, std::string("postgis_connection::execute_query ") + sql);
 #endif
         PGresult* result = 0;
-        if ( executeAsyncQuery(sql, type) ) {
+        if ( executeAsyncQuery(sql, type, params) ) {
           // fetch multiple times until NULL is returned,
           // to handle multi-statement queries
           while ( PGresult *tmp = getResult() ) {
@@ -159,10 +162,20 @@ public:
         return status;
     }
 
-    bool executeAsyncQuery(std::string const& sql, int type = 0)
+    // params are sent as text and referenced as $1, $2, ... in sql
+    bool executeAsyncQuery(std::string const& sql, int type = 0,
+                           std::vector<std::string> const& params = std::vector<std::string>())
     {
         int result = 0;
-        if (type == 1)
+        if (!params.empty())
+        {
+            std::vector<const char*> values;
+            values.reserve(params.size());
+            for (auto const& param : params) values.push_back(param.c_str());
+            result = PQsendQueryParams(conn_, sql.c_str(), static_cast<int>(values.size()),
+                                       0, values.data(), 0, 0, type == 1 ? 1 : 0);
+        }
+        else if (type == 1)
         {
             result = PQsendQueryParams(conn_,sql.c_str(), 0, 0, 0, 0, 0, 1);
         }
@@ -188,6 +201,8 @@ public:
     PGresult* getResult()
     {
         PGresult *result = PQgetResult(conn_);
+        // all results of the last query have been received
+        if (!result) pending_ = false;
         return result;
     }
 
@@ -235,6 +250,13 @@ public:
         return (!closed_) && (PQstatus(conn_) != CONNECTION_BAD);
     }
 
+    // PQcancel may be called on the handle from another thread while this
+    // one waits for results
+    std::shared_ptr<PGcancel> cancelHandle() const
+    {
+        return std::shared_ptr<PGcancel>(PQgetCancel(conn_), [](PGcancel* c) { if (c) PQfreeCancel(c); });
+    }
+
     bool isPending() const
     {
         return pending_;
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <memory>
 #include <algorithm>
+#include <cstdint>
 
 static inline std::string numeric2string(const char* buf)
 {
@@ -141,4 +142,35 @@ static inline std::string numeric2string(const char* buf)
     return ss.str();
 }
 
+// Converts a binary NUMERIC straight to double when the conversion is exact:
+// at most 2^53 as an integer mantissa scaled by at most 10^22, i.e. a single
+// correctly rounded operation. Returns false for other values (and NaN),
+// which must then go through numeric2string.
+static inline bool numeric2double(const char* buf, double & val)
+{
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    constexpr std::uint64_t max_mantissa = std::uint64_t(1) << 53;
+    std::int16_t ndigits = int2net(buf);
+    std::int16_t weight  = int2net(buf+2);
+    std::uint16_t sign   = static_cast<std::uint16_t>(int2net(buf+4));
+    if (sign != 0x0000 && sign != 0x4000) return false;
+    std::uint64_t mantissa = 0;
+    for (int n = 0; n < ndigits; ++n)
+    {
+        if (mantissa > max_mantissa / 10000) return false;
+        mantissa = mantissa * 10000 + static_cast<std::uint16_t>(int2net(buf+8+n*2));
+    }
+    if (mantissa > max_mantissa) return false;
+    // each NUMERIC digit holds four decimal digits
+    int exponent = 4 * (weight - ndigits + 1);
+    if (mantissa == 0) val = 0.0;
+    else if (exponent >= 0 && exponent <= 22) val = static_cast<double>(mantissa) * pow10[exponent];
+    else if (exponent < 0 && exponent >= -22) val = static_cast<double>(mantissa) / pow10[-exponent];
+    else return false;
+    if (sign == 0x4000) val = -val;
+    return true;
+}
+
 #endif
@@ -78,6 +78,7 @@ postgis_datasource::postgis_datasource(parameters const& params)
       extent_from_subquery_(*params.get<mapnik::boolean_type>("extent_from_subquery", false)),
       max_async_connections_(*params_.get<mapnik::value_integer>("max_async_connection", 1)),
       asynchronous_request_(false),
+      async_prefetch_(*params_.get<mapnik::boolean_type>("async_prefetch", false)),
       twkb_encoding_(false),
       twkb_rounding_adjustment_(*params_.get<mapnik::value_double>("twkb_rounding_adjustment", 0.0)),
       simplify_snap_ratio_(*params_.get<mapnik::value_double>("simplify_snap_ratio", 1.0/40.0)),
@@ -89,6 +90,9 @@ postgis_datasource::postgis_datasource(parameters const& params)
       simplify_prefilter_(*params_.get<mapnik::value_double>("simplify_prefilter", 0.0)),
       simplify_dp_preserve_(false),
       simplify_clip_resolution_(*params_.get<mapnik::value_double>("simplify_clip_resolution", 0.0)),
+      clip_geometries_(false),
+      // in pixels, wide enough to keep clip edges out of sight under strokes
+      clip_buffer_(*params_.get<mapnik::value_double>("clip_buffer", 8.0)),
       re_tokens_("!(@?\\w+)!"), // matches  !mapnik_var!  or  !@user_var!
       // params below are for testing purposes only and may be removed at any time
       intersect_min_scale_(*params.get<mapnik::value_integer>("intersect_min_scale", 0)),
@@ -123,6 +127,15 @@ postgis_datasource::postgis_datasource(parameters const& params)
         asynchronous_request_ = true;
     }
 
+#ifndef MAPNIK_THREADSAFE
+    if (async_prefetch_)
+    {
+        // results are received on worker threads
+        MAPNIK_LOG_WARN(postgis) << "postgis_datasource: async_prefetch requires a thread safe build, ignored";
+        async_prefetch_ = false;
+    }
+#endif
+
     boost::optional<mapnik::value_integer> initial_size = params.get<mapnik::value_integer>("initial_size", 1);
     boost::optional<mapnik::boolean_type> autodetect_key_field = params.get<mapnik::boolean_type>("autodetect_key_field", false);
     boost::optional<mapnik::boolean_type> estimate_extent = params.get<mapnik::boolean_type>("estimate_extent", false);
@@ -133,6 +146,9 @@ postgis_datasource::postgis_datasource(parameters const& params)
     boost::optional<mapnik::boolean_type> twkb_opt = params.get<mapnik::boolean_type>("twkb_encoding", false);
     twkb_encoding_ = twkb_opt && *twkb_opt;
 
+    boost::optional<mapnik::boolean_type> clip_opt = params.get<mapnik::boolean_type>("clip_geometries", false);
+    clip_geometries_ = clip_opt && *clip_opt;
+
     boost::optional<mapnik::boolean_type> simplify_preserve_opt = params.get<mapnik::boolean_type>("simplify_dp_preserve", false);
     simplify_dp_preserve_ = simplify_preserve_opt && *simplify_preserve_opt;
 
@@ -656,7 +672,18 @@ std::shared_ptr<IResultSet> postgis_datasource::get_resultset(std::shared_ptr<Co
     {   // asynchronous requests
 
         std::shared_ptr<postgis_processor_context> pgis_ctxt = std::static_pointer_cast<postgis_processor_context>(ctx);
-        if (conn)
+        if (async_prefetch_)
+        {
+            // sent right away when a slot is free, otherwise by the first
+            // request to finish receiving its results
+            std::shared_ptr<AsyncResultSet> res = std::make_shared<AsyncResultSet>(pgis_ctxt, pool, conn, sql, true);
+            if (pgis_ctxt->acquire_request(max_async_connections_, res))
+            {
+                res->start_prefetch();
+            }
+            return res;
+        }
+        else if (conn)
         {
             // lauch async req & create asyncresult with conn
             conn->executeAsyncQuery(sql, 1);
@@ -724,8 +751,9 @@ featureset_ptr postgis_datasource::features_with_context(query const& q,processo
         if ( asynchronous_request_ )
         {
             // limit use to num_async_request_ => if reached don't borrow the last connexion object
+            // prefetching requests borrow their connection when they are sent
             std::shared_ptr<postgis_processor_context> pgis_ctxt = std::static_pointer_cast<postgis_processor_context>(proc_ctx);
-            if ( pgis_ctxt->num_async_requests_ < max_async_connections_ )
+            if ( !async_prefetch_ && pgis_ctxt->num_async_requests_ < max_async_connections_ )
             {
                 conn = pool->borrowObject();
                 pgis_ctxt->num_async_requests_++;
@@ -761,6 +789,17 @@ featureset_ptr postgis_datasource::features_with_context(query const& q,processo
         const double px_gh = 1.0 / std::get<1>(q.resolution());
         const double px_sz = std::min(px_gw, px_gh);
 
+        // clip_geometries cuts features to the query extent plus a margin and
+        // snaps them to a fraction of the pixel grid on the server, so large
+        // geometries which only touch the extent are not transferred in full
+        const bool clip = clip_geometries_ ||
+            (simplify_clip_resolution_ > 0.0 && simplify_clip_resolution_ > px_sz);
+        box2d<double> clip_box(box);
+        if (clip_geometries_)
+        {
+            clip_box.pad(clip_buffer_ * px_sz);
+        }
+
         if (twkb_encoding_)
         {
             // This will only work against PostGIS 2.2, or a back-patched version
@@ -777,16 +816,16 @@ featureset_ptr postgis_datasource::features_with_context(query const& q,processo
             s << "ST_Simplify(";
             s << "ST_RemoveRepeatedPoints(";
 
-            if (simplify_clip_resolution_ > 0.0 && simplify_clip_resolution_ > px_sz)
+            if (clip)
             {
                 s << "ST_ClipByBox2D(";
             }
             s << identifier(geometryColumn_);
 
             // ! ST_ClipByBox2D()
-            if (simplify_clip_resolution_ > 0.0 && simplify_clip_resolution_ > px_sz)
+            if (clip)
             {
-                s << "," << sql_bbox(box) << ")";
+                s << "," << sql_bbox(clip_box) << ")";
             }
 
             // ! ST_RemoveRepeatedPoints()
@@ -798,16 +837,17 @@ featureset_ptr postgis_datasource::features_with_context(query const& q,processo
         }
         else
         {
+            const bool snap = (simplify_geometries_ || clip_geometries_) && simplify_snap_ratio_ > 0.0;
             s << "SELECT ST_AsBinary(";
             if (simplify_geometries_)
             {
                 s << "ST_Simplify(";
             }
-            if (simplify_clip_resolution_ > 0.0 && simplify_clip_resolution_ > px_sz)
+            if (clip)
             {
                 s << "ST_ClipByBox2D(";
             }
-            if (simplify_geometries_ && simplify_snap_ratio_ > 0.0)
+            if (snap)
             {
                 s<< "ST_SnapToGrid(";
             }
@@ -816,16 +856,16 @@ featureset_ptr postgis_datasource::features_with_context(query const& q,processo
             s << identifier(geometryColumn_);
 
             // ! ST_SnapToGrid()
-            if (simplify_geometries_ && simplify_snap_ratio_ > 0.0)
+            if (snap)
             {
                 const double tolerance = px_sz * simplify_snap_ratio_;
                 s << "," << tolerance << ")";
             }
 
             // ! ST_ClipByBox2D()
-            if (simplify_clip_resolution_ > 0.0 && simplify_clip_resolution_ > px_sz)
+            if (clip)
             {
-                s << "," << sql_bbox(box) << ")";
+                s << "," << sql_bbox(clip_box) << ")";
             }
 
             // ! ST_Simplify()
@@ -117,6 +117,7 @@ private:
     bool estimate_extent_;
     int max_async_connections_;
     bool asynchronous_request_;
+    bool async_prefetch_;
     bool twkb_encoding_;
     mapnik::value_double twkb_rounding_adjustment_;
     mapnik::value_double simplify_snap_ratio_;
@@ -124,6 +125,8 @@ private:
     mapnik::value_double simplify_prefilter_;
     bool simplify_dp_preserve_;
     mapnik::value_double simplify_clip_resolution_;
+    bool clip_geometries_;
+    mapnik::value_double clip_buffer_;
     std::regex re_tokens_;
     int intersect_min_scale_;
     int intersect_max_scale_;
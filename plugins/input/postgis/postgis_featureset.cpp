@@ -23,7 +23,7 @@
 #include "postgis_featureset.hpp"
 #include "resultset.hpp"
 #include "cursorresultset.hpp"
- #include "numeric2string.hpp"
+#include "numeric2string.hpp"
 
 // mapnik
 #include <mapnik/global.hpp>
@@ -40,11 +40,102 @@
 #include <sstream>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <stdexcept>
 
 using mapnik::geometry_utils;
 using mapnik::feature_factory;
 using mapnik::context_ptr;
 
+namespace {
+
+bool decode_bool(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    val = (buf[0] != 0);
+    return true;
+}
+
+bool decode_int2(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    val = static_cast<mapnik::value_integer>(int2net(buf));
+    return true;
+}
+
+bool decode_int4(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    val = static_cast<mapnik::value_integer>(int4net(buf));
+    return true;
+}
+
+bool decode_int8(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    val = static_cast<mapnik::value_integer>(int8net(buf));
+    return true;
+}
+
+bool decode_float4(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    float f;
+    float4net(f, buf);
+    val = static_cast<double>(f);
+    return true;
+}
+
+bool decode_float8(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    double d;
+    float8net(d, buf);
+    val = d;
+    return true;
+}
+
+bool decode_text(const char* buf, int size, transcoder const& tr, mapnik::value & val)
+{
+    val = tr.transcode(buf, size);
+    return true;
+}
+
+bool decode_bpchar(const char* buf, int, transcoder const& tr, mapnik::value & val)
+{
+    std::string str = mapnik::util::trim_copy(buf);
+    val = tr.transcode(str.c_str(), static_cast<std::int32_t>(str.size()));
+    return true;
+}
+
+bool decode_numeric(const char* buf, int, transcoder const&, mapnik::value & val)
+{
+    double d;
+    // exact binary conversion for the common case, the string round trip
+    // is kept for values which don't fit a double mantissa
+    if (numeric2double(buf, d) || mapnik::util::string2double(numeric2string(buf), d))
+    {
+        val = d;
+        return true;
+    }
+    return false;
+}
+
+postgis_featureset::decode_fn select_decoder(int oid)
+{
+    switch (oid)
+    {
+    case 16:   return decode_bool;    // bool
+    case 21:   return decode_int2;    // int2
+    case 23:   return decode_int4;    // int4
+    case 20:   return decode_int8;    // int8/BigInt
+    case 700:  return decode_float4;  // float4
+    case 701:  return decode_float8;  // float8
+    case 25:                          // text
+    case 1043:                        // varchar
+    case 705:  return decode_text;    // literal
+    case 1042: return decode_bpchar;  // bpchar
+    case 1700: return decode_numeric; // numeric
+    default:   return nullptr;
+    }
+}
+
+} // anonymous namespace
+
 postgis_featureset::postgis_featureset(std::shared_ptr<IResultSet> const& rs,
                                        context_ptr const& ctx,
                                        std::string const& encoding,
@@ -58,40 +149,95 @@ postgis_featureset::postgis_featureset(std::shared_ptr<IResultSet> const& rs,
       feature_id_(1),
       key_field_(key_field),
       key_field_as_attribute_(key_field_as_attribute),
-      twkb_encoding_(twkb_encoding)
+      twkb_encoding_(twkb_encoding),
+      decoders_ready_(false),
+      key_field_oid_(0),
+      key_field_name_(),
+      decoders_()
+{
+}
+
+void postgis_featureset::build_decoders(unsigned first)
 {
+    auto in_context = [this](std::string const& name)
+    {
+        for (auto const& kv : *ctx_)
+        {
+            if (kv.first == name) return true;
+        }
+        return false;
+    };
+
+    if (key_field_)
+    {
+        key_field_oid_ = rs_->getTypeOID(1);
+        key_field_name_ = rs_->getFieldName(1);
+        if (key_field_as_attribute_ && !in_context(key_field_name_))
+        {
+            throw std::out_of_range("Key does not exist: '" + key_field_name_ + "'");
+        }
+    }
+
+    unsigned num_attrs = ctx_->size() + 1;
+    if (!key_field_as_attribute_)
+    {
+        num_attrs++;
+    }
+    num_attrs = std::min(num_attrs, static_cast<unsigned>(rs_->getNumFields()));
+
+    decoders_.clear();
+    for (unsigned pos = first; pos < num_attrs; ++pos)
+    {
+        std::string name = rs_->getFieldName(pos);
+        const int oid = rs_->getTypeOID(pos);
+        if (!in_context(name))
+        {
+            // same error as storing an unknown attribute into the feature
+            throw std::out_of_range("Key does not exist: '" + name + "'");
+        }
+        decode_fn decode = select_decoder(oid);
+        if (decode == nullptr)
+        {
+            MAPNIK_LOG_WARN(postgis) << "postgis_featureset: Unknown type_oid=" << oid << " for field=" << name;
+            continue;
+        }
+        decoders_.push_back(column_decoder{pos, std::move(name), decode});
+    }
+    decoders_ready_ = true;
 }
 
 feature_ptr postgis_featureset::next()
 {
     while (rs_->next())
     {
+        if (!decoders_ready_)
+        {
+            build_decoders(key_field_ ? 2 : 1);
+        }
+
         // new feature
-        unsigned pos = 1;
         feature_ptr feature;
 
         if (key_field_)
         {
-            std::string name = rs_->getFieldName(pos);
-
             // null feature id is not acceptable
-            if (rs_->isNull(pos))
+            if (rs_->isNull(1))
             {
-                MAPNIK_LOG_WARN(postgis) << "postgis_featureset: null value encountered for key_field: " << name;
+                MAPNIK_LOG_WARN(postgis) << "postgis_featureset: null value encountered for key_field: "
+                                         << rs_->getFieldName(1);
                 continue;
             }
             // create feature with user driven id from attribute
-            int oid = rs_->getTypeOID(pos);
-            const char* buf = rs_->getValue(pos);
+            const char* buf = rs_->getValue(1);
 
             // validation happens of this type at initialization
             mapnik::value_integer val;
 
-            if (oid == 20)
+            if (key_field_oid_ == 20)
             {
                 val = int8net(buf);
             }
-            else if (oid == 21)
+            else if (key_field_oid_ == 21)
             {
                 val = int2net(buf);
             }
@@ -103,9 +249,8 @@ feature_ptr postgis_featureset::next()
             feature = feature_factory::create(ctx_, val);
             if (key_field_as_attribute_)
             {
-                feature->put<mapnik::value_integer>(name,val);
+                feature->put(key_field_name_, val);
             }
-            ++pos;
         }
         else
         {
@@ -135,95 +280,16 @@ feature_ptr postgis_featureset::next()
         }
 
         totalGeomSize_ += size;
-        unsigned num_attrs = ctx_->size() + 1;
-        if (!key_field_as_attribute_)
-        {
-            num_attrs++;
-        }
-        for (; pos < num_attrs; ++pos)
+        for (auto const& column : decoders_)
         {
-            std::string name = rs_->getFieldName(pos);
-
             // NOTE: we intentionally do not store null here
             // since it is equivalent to the attribute not existing
-            if (!rs_->isNull(pos))
+            if (!rs_->isNull(column.pos))
             {
-                const char* buf = rs_->getValue(pos);
-                const int oid = rs_->getTypeOID(pos);
-                switch (oid)
+                mapnik::value val;
+                if (column.decode(rs_->getValue(column.pos), rs_->getFieldLength(column.pos), *tr_, val))
                 {
-                    case 16: //bool
-                    {
-                        feature->put(name, (buf[0] != 0));
-                        break;
-                    }
-
-                    case 23: //int4
-                    {
-                        feature->put<mapnik::value_integer>(name, int4net(buf));
-                        break;
-                    }
-
-                    case 21: //int2
-                    {
-                        feature->put<mapnik::value_integer>(name, int2net(buf));
-                        break;
-                    }
-
-                    case 20: //int8/BigInt
-                    {
-                        feature->put<mapnik::value_integer>(name, int8net(buf));
-                        break;
-                    }
-
-                    case 700: //float4
-                    {
-                        float val;
-                        float4net(val, buf);
-                        feature->put(name, static_cast<double>(val));
-                        break;
-                    }
-
-                    case 701: //float8
-                    {
-                        double val;
-                        float8net(val, buf);
-                        feature->put(name, val);
-                        break;
-                    }
-
-                    case 25:   //text
-                    case 1043: //varchar
-                    case 705:  //literal
-                    {
-                        feature->put(name, tr_->transcode(buf));
-                        break;
-                    }
-
-                    case 1042: //bpchar
-                    {
-                        std::string str = mapnik::util::trim_copy(buf);
-                        feature->put(name, tr_->transcode(str.c_str()));
-                        break;
-                    }
-
-                    case 1700: //numeric
-                    {
-                        double val;
-                        std::string str = numeric2string(buf);
-                        if (mapnik::util::string2double(str, val))
-                        {
-                            feature->put(name, val);
-                        }
-                        break;
-                    }
-
-                    default:
-                    {
-                        MAPNIK_LOG_WARN(postgis) << "postgis_featureset: Unknown type_oid=" << oid;
-
-                        break;
-                    }
+                    feature->put(column.name, std::move(val));
                 }
             }
         }
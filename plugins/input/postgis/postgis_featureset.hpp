@@ -29,6 +29,10 @@
 #include <mapnik/feature.hpp>
 #include <mapnik/unicode.hpp>
 
+// stl
+#include <string>
+#include <vector>
+
 using mapnik::Featureset;
 using mapnik::box2d;
 using mapnik::feature_ptr;
@@ -40,6 +44,10 @@ class IResultSet;
 class postgis_featureset : public mapnik::Featureset
 {
 public:
+    // converts a non-null binary field into a feature value, returning false
+    // when the field can not be represented
+    using decode_fn = bool (*)(const char* buf, int size, transcoder const& tr, mapnik::value & val);
+
     postgis_featureset(std::shared_ptr<IResultSet> const& rs,
                        context_ptr const& ctx,
                        std::string const& encoding,
@@ -50,6 +58,15 @@ public:
     ~postgis_featureset();
 
 private:
+    struct column_decoder
+    {
+        unsigned pos;
+        std::string name;
+        decode_fn decode;
+    };
+
+    void build_decoders(unsigned first);
+
     std::shared_ptr<IResultSet> rs_;
     context_ptr ctx_;
     const std::unique_ptr<mapnik::transcoder> tr_;
@@ -58,6 +75,12 @@ private:
     bool key_field_;
     bool key_field_as_attribute_;
     bool twkb_encoding_;
+    // resolved once from the first row, the column types of a query
+    // are fixed for its lifetime
+    bool decoders_ready_;
+    int key_field_oid_;
+    std::string key_field_name_;
+    std::vector<column_decoder> decoders_;
 };
 
 #endif // POSTGIS_FEATURESET_HPP
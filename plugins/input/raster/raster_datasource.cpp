@@ -65,6 +65,16 @@ raster_datasource::raster_datasource(parameters const& params)
     tile_size_ = *params.get<mapnik::value_integer>("tile_size", 1024);
     tile_stride_ = *params.get<mapnik::value_integer>("tile_stride", 1);
 
+    // Reduced resolution levels, one file (or tile directory tree in
+    // multi mode) per level: ${z} in <file> is replaced by the level
+    // number, 0 being the full resolution
+    std::string const file_pattern = filename_;
+    mapnik::value_integer const pyramid_levels = raster_pyramid_levels(params, file_pattern);
+    if (pyramid_levels > 0)
+    {
+        filename_ = raster_pyramid_file(file_pattern, 0);
+    }
+
     boost::optional<std::string> format_from_filename = mapnik::type_from_filename(*file);
     format_ = *params.get<std::string>("format",format_from_filename?(*format_from_filename) : "tiff");
 
@@ -86,8 +96,8 @@ raster_datasource::raster_datasource(parameters const& params)
     }
     else //bounding box from image_reader
     {
-        std::unique_ptr<image_reader> reader(mapnik::get_image_reader(*file));
-        if (!reader) throw datasource_exception("Raster Plugin: failed to create reader for " + *file);
+        std::unique_ptr<image_reader> reader(mapnik::get_image_reader(filename_));
+        if (!reader) throw datasource_exception("Raster Plugin: failed to create reader for " + filename_);
         auto bbox = reader->bounding_box();
         if (bbox)
         {
@@ -118,6 +128,21 @@ raster_datasource::raster_datasource(parameters const& params)
 
         width_ = x_width.get() * tile_size_;
         height_ = y_width.get() * tile_size_;
+
+        levels_.push_back(raster_pyramid_level{filename_, width_, height_});
+        if (pyramid_levels > 0)
+        {
+            // each level halves the tile grid, which must stay whole
+            mapnik::value_integer const factor = mapnik::value_integer(1) << pyramid_levels;
+            if (*x_width % factor != 0 || *y_width % factor != 0)
+            {
+                throw datasource_exception("Raster Plugin: x-width and y-width must be multiples of 2^pyramid_levels");
+            }
+            for (mapnik::value_integer level = 1; level <= pyramid_levels; ++level)
+            {
+                levels_.push_back(raster_pyramid_level{raster_pyramid_file(file_pattern, level), width_ >> level, height_ >> level});
+            }
+        }
     }
     else
     {
@@ -147,6 +172,26 @@ raster_datasource::raster_datasource(parameters const& params)
         {
             throw datasource_exception("Raster Plugin: image reader unknown exception caught");
         }
+
+        levels_.push_back(raster_pyramid_level{filename_, width_, height_});
+        for (mapnik::value_integer level = 1; level <= pyramid_levels; ++level)
+        {
+            std::string file = raster_pyramid_file(file_pattern, level);
+            std::unique_ptr<image_reader> reader;
+            try
+            {
+                reader.reset(mapnik::get_image_reader(file, format_));
+            }
+            catch (std::exception const& ex)
+            {
+                throw datasource_exception("Raster Plugin: " + std::string(ex.what()));
+            }
+            if (!reader)
+            {
+                throw datasource_exception("Raster Plugin: failed to create reader for " + file);
+            }
+            levels_.push_back(raster_pyramid_level{file, reader->width(), reader->height()});
+        }
     }
 
     MAPNIK_LOG_DEBUG(raster) << "raster_datasource: Raster size=" << width_ << "," << height_;
@@ -182,9 +227,17 @@ layer_descriptor raster_datasource::get_descriptor() const
     return desc_;
 }
 
+raster_pyramid_level const& raster_datasource::select_level(query const& q) const
+{
+    std::size_t const index = raster_pyramid_select(levels_, extent_, q);
+    MAPNIK_LOG_DEBUG(raster) << "raster_datasource: Pyramid level=" << index;
+    return levels_[index];
+}
+
 featureset_ptr raster_datasource::features(query const& q) const
 {
-    mapnik::view_transform t(width_, height_, extent_, 0, 0);
+    raster_pyramid_level const& level = select_level(q);
+    mapnik::view_transform t(level.width, level.height, extent_, 0, 0);
     mapnik::box2d<double> intersect = extent_.intersect(q.get_bbox());
     mapnik::box2d<double> ext = t.forward(intersect);
 
@@ -197,7 +250,7 @@ featureset_ptr raster_datasource::features(query const& q) const
     {
         MAPNIK_LOG_DEBUG(raster) << "raster_datasource: Multi-Tiled policy";
 
-        tiled_multi_file_policy policy(filename_, format_, tile_size_, extent_, q.get_bbox(), width_, height_, tile_stride_);
+        tiled_multi_file_policy policy(level.file, format_, tile_size_, extent_, q.get_bbox(), level.width, level.height, tile_stride_);
 
         return std::make_shared<raster_featureset<tiled_multi_file_policy> >(policy, extent_, q);
     }
@@ -205,7 +258,7 @@ featureset_ptr raster_datasource::features(query const& q) const
     {
         MAPNIK_LOG_DEBUG(raster) << "raster_datasource: Tiled policy";
 
-        tiled_file_policy policy(filename_, format_, tile_size_, extent_, q.get_bbox(), width_, height_);
+        tiled_file_policy policy(level.file, format_, tile_size_, extent_, q.get_bbox(), level.width, level.height);
 
         return std::make_shared<raster_featureset<tiled_file_policy> >(policy, extent_, q);
     }
@@ -213,7 +266,7 @@ featureset_ptr raster_datasource::features(query const& q) const
     {
         MAPNIK_LOG_DEBUG(raster) << "raster_datasource: Single file";
 
-        raster_info info(filename_, format_, extent_, width_, height_);
+        raster_info info(level.file, format_, extent_, level.width, level.height);
         single_file_policy policy(info);
 
         return std::make_shared<raster_featureset<single_file_policy> >(policy, extent_, q);
@@ -40,6 +40,7 @@
 #include <vector>
 #include <string>
 
+#include "raster_pyramid.hpp"
 
 class raster_datasource : public mapnik::datasource
 {
@@ -56,6 +57,8 @@ public:
     bool log_enabled() const;
 
 private:
+    raster_pyramid_level const& select_level(mapnik::query const& q) const;
+
     mapnik::layer_descriptor desc_;
     std::string filename_;
     std::string format_;
@@ -66,6 +69,7 @@ private:
     unsigned tile_stride_;
     unsigned width_;
     unsigned height_;
+    std::vector<raster_pyramid_level> levels_;
 };
 
 #endif // RASTER_DATASOURCE_HPP
@@ -0,0 +1,91 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef RASTER_PYRAMID_HPP
+#define RASTER_PYRAMID_HPP
+
+// mapnik
+#include <mapnik/datasource.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/query.hpp>
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/value/types.hpp>
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/algorithm/string/replace.hpp>
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <string>
+#include <tuple>
+#include <vector>
+
+// One level of a raster pyramid: level 0 is the full resolution data,
+// each next level halves the resolution
+struct raster_pyramid_level
+{
+    std::string file;
+    unsigned width;
+    unsigned height;
+};
+
+// file (or tile directory tree in multi mode) of a level: ${z} in the
+// <file> pattern is replaced by the level number
+inline std::string raster_pyramid_file(std::string const& pattern, mapnik::value_integer level)
+{
+    return boost::algorithm::replace_all_copy(pattern, "${z}", std::to_string(level));
+}
+
+// number of reduced levels given by <pyramid_levels>, 0 without a pyramid
+inline mapnik::value_integer raster_pyramid_levels(mapnik::parameters const& params, std::string const& pattern)
+{
+    mapnik::value_integer levels = *params.get<mapnik::value_integer>("pyramid_levels", 0);
+    if (levels < 0 || levels > 30)
+    {
+        throw mapnik::datasource_exception("Raster Plugin: invalid <pyramid_levels> parameter");
+    }
+    if (levels > 0 && pattern.find("${z}") == std::string::npos)
+    {
+        throw mapnik::datasource_exception("Raster Plugin: <file> must contain ${z} when <pyramid_levels> is set");
+    }
+    return levels;
+}
+
+// index of the most reduced level that is still at least as detailed as
+// the query output (times its filter factor)
+inline std::size_t raster_pyramid_select(std::vector<raster_pyramid_level> const& levels,
+                                         mapnik::box2d<double> const& extent,
+                                         mapnik::query const& q)
+{
+    double const ideal_width = extent.width() * std::get<0>(q.resolution()) * q.get_filter_factor();
+    double const ideal_height = extent.height() * std::get<1>(q.resolution()) * q.get_filter_factor();
+    std::size_t index = 0;
+    for (std::size_t i = 1; i < levels.size(); ++i)
+    {
+        if (levels[i].width < ideal_width || levels[i].height < ideal_height) break;
+        index = i;
+    }
+    return index;
+}
+
+#endif // RASTER_PYRAMID_HPP
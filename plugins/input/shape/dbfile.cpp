@@ -39,6 +39,8 @@ MAPNIK_DISABLE_WARNING_PUSH
 MAPNIK_DISABLE_WARNING_POP
 
 // stl
+#include <algorithm>
+#include <cctype>
 #include <cstdint>
 #include <string>
 #include <cstring>
@@ -138,79 +140,243 @@ const field_descriptor& dbf_file::descriptor(int col) const
 }
 
 
-void dbf_file::add_attribute(int col, mapnik::transcoder const& tr, mapnik::feature_impl & f) const
+namespace {
+
+namespace x3 = boost::spirit::x3;
+
+// fallback parsers for cells the fixed width parsers below don't handle
+bool parse_real_generic(char const* itr, char const* end, double & val)
 {
-    using namespace boost::spirit;
+    x3::ascii::space_type space;
+    static x3::double_type double_;
+    return x3::phrase_parse(itr, end, double_, space, val);
+}
 
-    if (col>=0 && col<num_fields_)
+bool parse_integer_generic(char const* itr, char const* end, mapnik::value_integer & val)
+{
+    x3::ascii::space_type space;
+    static x3::int_parser<mapnik::value_integer,10,1,-1> numeric_parser;
+    return x3::phrase_parse(itr, end, numeric_parser, space, val);
+}
+
+enum parse_result { no_value, parsed, use_generic };
+
+// Numeric cells are right aligned and padded with blanks: parse them in
+// place, deferring to the generic parsers for anything unusual.
+parse_result parse_integer(char const* itr, char const* end, mapnik::value_integer & val)
+{
+    while (itr != end && *itr == ' ') ++itr;
+    bool negative = false;
+    if (itr != end && (*itr == '-' || *itr == '+'))
+    {
+        negative = (*itr++ == '-');
+    }
+    char const* start = itr;
+    std::uint64_t result = 0;
+    while (itr != end && *itr >= '0' && *itr <= '9')
+    {
+        result = result * 10 + static_cast<std::uint64_t>(*itr++ - '0');
+    }
+    std::size_t digits = static_cast<std::size_t>(itr - start);
+    if (digits == 0)
+    {
+        return (start == end || *start == ' ') ? no_value : use_generic;
+    }
+    if (digits > 18) return use_generic; // may overflow
+    val = negative ? -static_cast<mapnik::value_integer>(result) : static_cast<mapnik::value_integer>(result);
+    return parsed;
+}
+
+parse_result parse_real(char const* itr, char const* end, double & val)
+{
+    // exact powers of ten: mantissa / pow10 is then correctly rounded
+    static double const pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+    while (itr != end && *itr == ' ') ++itr;
+    bool negative = false;
+    if (itr != end && (*itr == '-' || *itr == '+'))
+    {
+        negative = (*itr++ == '-');
+    }
+    char const* start = itr;
+    std::uint64_t mantissa = 0;
+    std::size_t digits = 0;
+    std::size_t decimals = 0;
+    while (itr != end && *itr >= '0' && *itr <= '9')
+    {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*itr++ - '0');
+        ++digits;
+    }
+    if (itr != end && *itr == '.')
+    {
+        ++itr;
+        while (itr != end && *itr >= '0' && *itr <= '9')
+        {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*itr++ - '0');
+            ++digits;
+            ++decimals;
+        }
+    }
+    if (digits == 0)
+    {
+        return (start == end || *start == ' ') ? no_value : use_generic;
+    }
+    if (digits > 15 || (itr != end && (*itr == 'e' || *itr == 'E'))) return use_generic;
+    double result = static_cast<double>(mantissa) / pow10[decimals];
+    val = negative ? -result : result;
+    return parsed;
+}
+
+bool ascii_compatible_encoding(std::string const& encoding)
+{
+    std::string name;
+    for (char c : encoding)
+    {
+        if (c == '-' || c == '_') continue;
+        name += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return name == "utf8" || name == "ascii" || name == "usascii" || name == "latin1"
+        || name.compare(0, 7, "iso8859") == 0
+        || name.compare(0, 5, "cp125") == 0
+        || name.compare(0, 10, "windows125") == 0;
+}
+
+dbf_column make_column(field_descriptor const& desc, bool ascii_compatible, bool & supported)
+{
+    dbf_column column;
+    column.name_ = desc.name_;
+    column.offset_ = static_cast<std::size_t>(desc.offset_);
+    column.length_ = static_cast<std::size_t>(desc.length_);
+    column.decoder_ = dbf_column::string_decoder;
+    supported = true;
+    // NOTE: ensure types handled here are matched in shape_datasource.cpp
+    switch (desc.type_)
     {
-        std::string const& name=fields_[col].name_;
+    case 'C':
+    case 'D':
+        column.decoder_ = ascii_compatible ? dbf_column::ascii_string_decoder : dbf_column::string_decoder;
+        break;
+    case 'L':
+        column.decoder_ = dbf_column::logical_decoder;
+        break;
+    case 'N': // numeric
+    case 'O': // double
+    case 'F': // float
+        column.decoder_ = desc.dec_ > 0 ? dbf_column::real_decoder : dbf_column::integer_decoder;
+        break;
+    default:
+        supported = false;
+        break;
+    }
+    return column;
+}
 
-        // NOTE: ensure types handled here are matched in shape_datasource.cpp
-        switch (fields_[col].type_)
+void decode(dbf_column const& column, char const* record, mapnik::transcoder const& tr, mapnik::feature_impl & f)
+{
+    char const* itr = record + column.offset_;
+    char const* end = itr + column.length_;
+    switch (column.decoder_)
+    {
+    case dbf_column::string_decoder:
+    case dbf_column::ascii_string_decoder:
+    {
+        // trim in place, and stop at the first NUL like a C string would
+        while (itr != end && !mapnik::util::not_whitespace(*itr)) ++itr;
+        while (end != itr && !mapnik::util::not_whitespace(*(end - 1))) --end;
+        end = std::find(itr, end, '\0');
+        std::int32_t length = static_cast<std::int32_t>(end - itr);
+        if (column.decoder_ == dbf_column::ascii_string_decoder
+            && std::all_of(itr, end, [](char c) { return (static_cast<unsigned char>(c) & 0x80) == 0; }))
         {
-        case 'C':
-        case 'D':
+            // ASCII is valid UTF-8, which ICU converts without a converter
+            f.put(column.name_, mapnik::value_unicode_string::fromUTF8(U_NAMESPACE_QUALIFIER StringPiece(itr, length)));
+        }
+        else
         {
-            // FIXME - avoid constructing std::string on stack
-            std::string str(record_+fields_[col].offset_,fields_[col].length_);
-            mapnik::util::trim(str);
-            f.put(name,tr.transcode(str.c_str()));
-            break;
+            f.put(column.name_, tr.transcode(itr, length));
         }
-        case 'L':
+        break;
+    }
+    case dbf_column::logical_decoder:
+    {
+        char ch = (itr != end) ? *itr : '?';
+        if ( ch == '1' || ch == 't' || ch == 'T' || ch == 'y' || ch == 'Y')
         {
-            char ch = record_[fields_[col].offset_];
-            if ( ch == '1' || ch == 't' || ch == 'T' || ch == 'y' || ch == 'Y')
-            {
-                f.put(name,true);
-            }
-            else
-            {
-                // NOTE: null logical fields use '?'
-                f.put(name,false);
-            }
-            break;
+            f.put(column.name_, true);
         }
-        case 'N': // numeric
-        case 'O': // double
-        case 'F': // float
+        else
         {
+            // NOTE: null logical fields use '?'
+            f.put(column.name_, false);
+        }
+        break;
+    }
+    case dbf_column::integer_decoder:
+    {
+        // NOTE: we intentionally do not store null ('*') here
+        // since it is equivalent to the attribute not existing
+        if (itr == end || *itr == '*') break;
+        mapnik::value_integer val = 0;
+        parse_result result = parse_integer(itr, end, val);
+        if (result == parsed || (result == use_generic && parse_integer_generic(itr, end, val)))
+        {
+            f.put(column.name_, val);
+        }
+        break;
+    }
+    case dbf_column::real_decoder:
+    {
+        if (itr == end || *itr == '*') break;
+        double val = 0.0;
+        parse_result result = parse_real(itr, end, val);
+        if (result == parsed || (result == use_generic && parse_real_generic(itr, end, val)))
+        {
+            f.put(column.name_, val);
+        }
+        break;
+    }
+    }
+}
+
+} // anonymous ns
 
-            if (record_[fields_[col].offset_] == '*')
-            {
-                // NOTE: we intentionally do not store null here
-                // since it is equivalent to the attribute not existing
-                break;
-            }
-            if ( fields_[col].dec_>0 )
-            {
-                double val = 0.0;
-                const char *itr = record_+fields_[col].offset_;
-                const char *end = itr + fields_[col].length_;
-                x3::ascii::space_type space;
-                static x3::double_type double_;
-                if (x3::phrase_parse(itr,end,double_,space,val))
-                {
-                    f.put(name,val);
-                }
-            }
-            else
-            {
-                mapnik::value_integer val = 0;
-                const char *itr = record_+fields_[col].offset_;
-                const char *end = itr + fields_[col].length_;
-                x3::ascii::space_type space;
-                static x3::int_parser<mapnik::value_integer,10,1,-1> numeric_parser;
-                if (x3::phrase_parse(itr, end, numeric_parser, space, val))
-                {
-                    f.put(name,val);
-                }
-            }
-            break;
+void dbf_file::add_attribute(int col, mapnik::transcoder const& tr, mapnik::feature_impl & f) const
+{
+    if (col>=0 && col<num_fields_)
+    {
+        bool supported;
+        dbf_column column = make_column(fields_[col], false, supported);
+        if (supported)
+        {
+            decode(column, record_, tr, f);
         }
+    }
+}
+
+std::vector<dbf_column> dbf_file::columns(std::vector<int> const& cols, std::string const& encoding) const
+{
+    bool ascii_compatible = ascii_compatible_encoding(encoding);
+    std::vector<dbf_column> result;
+    result.reserve(cols.size());
+    for (auto col : cols)
+    {
+        if (col < 0 || col >= num_fields_) continue;
+        bool supported;
+        dbf_column column = make_column(fields_[col], ascii_compatible, supported);
+        if (supported)
+        {
+            result.push_back(std::move(column));
         }
     }
+    return result;
+}
+
+void dbf_file::add_attributes(std::vector<dbf_column> const& columns, mapnik::transcoder const& tr, mapnik::feature_impl & f) const
+{
+    for (auto const& column : columns)
+    {
+        decode(column, record_, tr, f);
+    }
 }
 
 void dbf_file::read_header()
@@ -41,6 +41,7 @@ MAPNIK_DISABLE_WARNING_POP
 #include <vector>
 #include <string>
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 
 struct field_descriptor
@@ -53,6 +54,24 @@ struct field_descriptor
     std::streampos offset_;
 };
 
+// Decoder for one projected column, resolved once per query so that
+// per record decoding is a switch over a few plain offsets.
+struct dbf_column
+{
+    enum decoder_type : std::uint8_t
+    {
+        string_decoder,
+        ascii_string_decoder, // ASCII-compatible encoding, skip the converter for ASCII cells
+        logical_decoder,
+        integer_decoder,
+        real_decoder
+    };
+    std::string name_;
+    std::size_t offset_;
+    std::size_t length_;
+    decoder_type decoder_;
+};
+
 
 class dbf_file : private mapnik::util::noncopyable
 {
@@ -79,6 +98,9 @@ public:
     void move_to(int index);
     std::string string_value(int col) const;
     void add_attribute(int col, mapnik::transcoder const& tr, mapnik::feature_impl & f) const;
+    // decoders for the given fields; unsupported field types are skipped
+    std::vector<dbf_column> columns(std::vector<int> const& cols, std::string const& encoding) const;
+    void add_attributes(std::vector<dbf_column> const& columns, mapnik::transcoder const& tr, mapnik::feature_impl & f) const;
 private:
     void read_header();
     int read_short();
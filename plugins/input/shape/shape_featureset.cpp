@@ -50,7 +50,8 @@ shape_featureset<filterT>::shape_featureset(filterT const& filter,
       shx_file_length_(0),
       row_limit_(row_limit),
       count_(0),
-      ctx_(std::make_shared<mapnik::context_type>())
+      ctx_(std::make_shared<mapnik::context_type>()),
+      record_(0)
 {
     if (!shape_.shx().is_open())
     {
@@ -61,6 +62,7 @@ shape_featureset<filterT>::shape_featureset(filterT const& filter,
     shx_header.skip(6 * 4);
     shx_file_length_ = shx_header.read_xdr_integer();
     setup_attributes(ctx_, attribute_names, shape_name, shape_, attr_ids_);
+    columns_ = shape_.dbf().columns(attr_ids_, encoding);
 }
 
 template <typename filterT>
@@ -79,7 +81,8 @@ feature_ptr shape_featureset<filterT>::next()
         shape_.move_to(2 * offset);
         mapnik::value_integer feature_id = shape_.id();
         assert(record_length == shape_.reclength_);
-        shape_file::record_type record(record_length * 2);
+        shape_file::record_type & record = record_;
+        record.reset(record_length * 2);
         shape_.shp().read_record(record);
         int type = record.read_ndr_integer();
 
@@ -108,12 +111,7 @@ feature_ptr shape_featureset<filterT>::next()
             if (!filter_.pass(feature_bbox_)) continue;
             int num_points = record.read_ndr_integer();
             mapnik::geometry::multi_point<double> multi_point;
-            for (int i = 0; i < num_points; ++i)
-            {
-                double x = record.read_double();
-                double y = record.read_double();
-                multi_point.emplace_back(mapnik::geometry::point<double>(x, y));
-            }
+            if (num_points > 0) record.read_points(multi_point, num_points);
             feature->set_geometry(std::move(multi_point));
             break;
         }
@@ -141,15 +139,12 @@ feature_ptr shape_featureset<filterT>::next()
             return feature_ptr();
         }
 
-        if (attr_ids_.size())
+        if (!columns_.empty())
         {
             shape_.dbf().move_to(shape_.id_);
             try
             {
-                for (auto id : attr_ids_)
-                {
-                    shape_.dbf().add_attribute(id, *tr_, *feature); //TODO optimize!!!
-                }
+                shape_.dbf().add_attributes(columns_, *tr_, *feature);
             }
             catch (...)
             {
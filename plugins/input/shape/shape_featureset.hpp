@@ -62,9 +62,11 @@ private:
     const std::unique_ptr<transcoder> tr_;
     long shx_file_length_;
     std::vector<int> attr_ids_;
+    std::vector<dbf_column> columns_;
     mapnik::value_integer row_limit_;
     mutable int count_;
     context_ptr ctx_;
+    shape_file::record_type record_; // reused across features
 };
 
 #endif //SHAPE_FEATURESET_HPP
@@ -39,6 +39,7 @@ MAPNIK_DISABLE_WARNING_POP
 #include "shape_index_featureset.hpp"
 #include "shape_utils.hpp"
 #include <mapnik/util/spatial_index.hpp>
+#include <mapnik/util/packed_rtree.hpp>
 
 using mapnik::feature_factory;
 
@@ -56,15 +57,30 @@ shape_index_featureset<filterT>::shape_index_featureset(filterT const& filter,
       positions_(),
       itr_(),
       attr_ids_(),
+      columns_(),
       row_limit_(row_limit),
       count_(0),
-      feature_bbox_()
+      feature_bbox_(),
+      record_(0),
+      parts_()
 {
     shape_ptr_->shp().skip(100);
     setup_attributes(ctx_, attribute_names, shape_name, *shape_ptr_, attr_ids_);
+    columns_ = shape_ptr_->dbf().columns(attr_ids_, encoding);
 
     auto index = shape_ptr_->index();
-    if (index)
+    if (index && shape_ptr_->has_packed_index())
+    {
+        using packed_rtree = mapnik::util::packed_rtree<mapnik::detail::node, filterT>;
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        // query nodes in place, straight from the mapped index
+        auto buffer = index->file().buffer();
+        packed_rtree::query(filter, buffer.first, buffer.second, positions_);
+#else
+        packed_rtree::query(filter, index->file(), positions_);
+#endif
+    }
+    else if (index)
     {
 #if defined(MAPNIK_MEMORY_MAPPED_FILE)
         mapnik::util::spatial_index<mapnik::detail::node,
@@ -102,14 +118,15 @@ feature_ptr shape_index_featureset<filterT>::next()
     {
         std::uint64_t offset = itr_->offset;
         shape_ptr_->move_to(offset);
-        std::vector<std::pair<int,int>> parts;
+        parts_.clear();
         while (itr_ != positions_.end() && itr_->offset == offset)
         {
-            if (itr_->start!= -1) parts.emplace_back(itr_->start, itr_->end);
+            if (itr_->start!= -1) parts_.emplace_back(itr_->start, itr_->end);
             ++itr_;
         }
         mapnik::value_integer feature_id = shape_ptr_->id();
-        shape_file::record_type record(shape_ptr_->reclength_ * 2);
+        shape_file::record_type & record = record_;
+        record.reset(shape_ptr_->reclength_ * 2);
         shape_ptr_->shp().read_record(record);
         int type = record.read_ndr_integer();
         feature_ptr feature(feature_factory::create(ctx_, feature_id));
@@ -133,12 +150,7 @@ feature_ptr shape_index_featureset<filterT>::next()
             //if (!filter_.pass(feature_bbox_)) continue;
             int num_points = record.read_ndr_integer();
             mapnik::geometry::multi_point<double> multi_point;
-            for (int i = 0; i < num_points; ++i)
-            {
-                double x = record.read_double();
-                double y = record.read_double();
-                multi_point.emplace_back(mapnik::geometry::point<double>(x, y));
-            }
+            if (num_points > 0) record.read_points(multi_point, num_points);
             feature->set_geometry(std::move(multi_point));
             break;
         }
@@ -148,8 +160,8 @@ feature_ptr shape_index_featureset<filterT>::next()
         {
             shape_io::read_bbox(record, feature_bbox_);
             //if (!filter_.pass(feature_bbox_)) continue;
-            if (parts.size() < 2) feature->set_geometry(shape_io::read_polyline(record));
-            else feature->set_geometry(shape_io::read_polyline_parts(record, parts));
+            if (parts_.size() < 2) feature->set_geometry(shape_io::read_polyline(record));
+            else feature->set_geometry(shape_io::read_polyline_parts(record, parts_));
             break;
         }
         case shape_io::shape_polygon:
@@ -158,8 +170,8 @@ feature_ptr shape_index_featureset<filterT>::next()
         {
             shape_io::read_bbox(record, feature_bbox_);
             //if (!filter_.pass(feature_bbox_)) continue;
-            if (parts.size() < 2) feature->set_geometry(shape_io::read_polygon(record));
-            else feature->set_geometry(shape_io::read_polygon_parts(record, parts));
+            if (parts_.size() < 2) feature->set_geometry(shape_io::read_polygon(record));
+            else feature->set_geometry(shape_io::read_polygon_parts(record, parts_));
             break;
         }
         default :
@@ -167,15 +179,12 @@ feature_ptr shape_index_featureset<filterT>::next()
             return feature_ptr();
         }
 
-        if (attr_ids_.size())
+        if (!columns_.empty())
         {
             shape_ptr_->dbf().move_to(shape_ptr_->id_);
             try
             {
-                for (auto id : attr_ids_)
-                {
-                    shape_ptr_->dbf().add_attribute(id, *tr_, *feature);
-                }
+                shape_ptr_->dbf().add_attributes(columns_, *tr_, *feature);
             }
             catch (...)
             {
@@ -83,9 +83,14 @@ private:
     std::vector<mapnik::detail::node> positions_;
     std::vector<mapnik::detail::node>::iterator itr_;
     std::vector<int> attr_ids_;
+    std::vector<dbf_column> columns_;
     mapnik::value_integer row_limit_;
     mutable int count_;
     mutable box2d<double> feature_bbox_;
+    // reused across features: record storage (unused when memory mapped,
+    // the record then points into the mapped region) and index parts
+    shape_file::record_type record_;
+    std::vector<std::pair<int,int>> parts_;
 };
 
 #endif // SHAPE_INDEX_FEATURESET_HPP
@@ -108,44 +108,23 @@ mapnik::geometry::geometry<double> shape_io::read_polyline(shape_file::record_ty
     if (num_parts == 1)
     {
         mapnik::geometry::line_string<double> line;
-        line.reserve(num_points);
         record.skip(4);
-        for (int i = 0; i < num_points; ++i)
-        {
-            double x = record.read_double();
-            double y = record.read_double();
-            line.emplace_back(x, y);
-        }
+        record.read_points(line, num_points);
         geom = std::move(line);
     }
     else
     {
-        std::vector<int> parts;
-        parts.resize(num_parts);
-        std::for_each(parts.begin(), parts.end(), [&](int & part) { part = record.read_ndr_integer();});
-        int start, end;
+        // part offsets are read in place, coordinates follow them
+        std::size_t parts_pos = record.pos;
+        record.skip(4 * num_parts);
         mapnik::geometry::multi_line_string<double> multi_line;
         multi_line.reserve(num_parts);
         for (int k = 0; k < num_parts; ++k)
         {
-            start = parts[k];
-            if (k == num_parts - 1)
-            {
-                end = num_points;
-            }
-            else
-            {
-                end = parts[k + 1];
-            }
-
+            int start = record.read_ndr_integer_at(parts_pos + 4 * k);
+            int end = (k == num_parts - 1) ? num_points : record.read_ndr_integer_at(parts_pos + 4 * (k + 1));
             mapnik::geometry::line_string<double> line;
-            line.reserve(end - start);
-            for (int j = start; j < end; ++j)
-            {
-                double x = record.read_double();
-                double y = record.read_double();
-                line.emplace_back(x, y);
-            }
+            if (end > start) record.read_points(line, end - start);
             multi_line.push_back(std::move(line));
         }
         geom = std::move(multi_line);
@@ -168,13 +147,7 @@ mapnik::geometry::geometry<double> shape_io::read_polyline_parts(shape_file::rec
         record.set_pos(pos);
 
         mapnik::geometry::line_string<double> line;
-        line.reserve(end - start);
-        for (int j = start; j < end; ++j)
-        {
-            double x = record.read_double();
-            double y = record.read_double();
-            line.emplace_back(x, y);
-        }
+        if (end > start) record.read_points(line, end - start);
         multi_line.push_back(std::move(line));
     }
     geom = std::move(multi_line);
@@ -188,26 +161,18 @@ mapnik::geometry::geometry<double> shape_io::read_polygon(shape_file::record_typ
     int num_parts = record.read_ndr_integer();
     int num_points = record.read_ndr_integer();
 
-    std::vector<int> parts;
-    parts.resize(num_parts);
-    std::for_each(parts.begin(), parts.end(), [&](int & part) { part = record.read_ndr_integer();});
+    // part offsets are read in place, coordinates follow them
+    std::size_t parts_pos = record.pos;
+    record.skip(4 * num_parts);
     mapnik::geometry::polygon<double> poly;
     mapnik::geometry::multi_polygon<double> multi_poly;
     for (int k = 0; k < num_parts; ++k)
     {
-        int start = parts[k];
-        int end;
-        if (k == num_parts - 1) end = num_points;
-        else end = parts[k + 1];
+        int start = record.read_ndr_integer_at(parts_pos + 4 * k);
+        int end = (k == num_parts - 1) ? num_points : record.read_ndr_integer_at(parts_pos + 4 * (k + 1));
 
         mapnik::geometry::linear_ring<double> ring;
-        ring.reserve(end - start);
-        for (int j = start; j < end; ++j)
-        {
-            double x = record.read_double();
-            double y = record.read_double();
-            ring.emplace_back(x, y);
-        }
+        if (end > start) record.read_points(ring, end - start);
         if (k == 0)
         {
             poly.push_back(std::move(ring));
@@ -251,13 +216,7 @@ mapnik::geometry::geometry<double> shape_io::read_polygon_parts(shape_file::reco
         unsigned pos = 4 + 32 + 8 + 4 * total_num_parts + start * 16;
         record.set_pos(pos);
         mapnik::geometry::linear_ring<double> ring;
-        ring.reserve(end - start);
-        for (int j = start; j < end; ++j)
-        {
-            double x = record.read_double();
-            double y = record.read_double();
-            ring.emplace_back(x, y);
-        }
+        if (end > start) record.read_points(ring, end - start);
         if (k == 0)
         {
             poly.push_back(std::move(ring));
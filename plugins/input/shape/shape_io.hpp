@@ -30,6 +30,7 @@
 #include <mapnik/geometry/box2d.hpp>
 #include <mapnik/util/noncopyable.hpp>
 #include <mapnik/util/spatial_index.hpp>
+#include <mapnik/util/packed_rtree.hpp>
 // boost
 #include <boost/optional.hpp>
 //
@@ -76,6 +77,18 @@ public:
         {
             bool status = mapnik::util::check_spatial_index(index_->file());
             index_->seek(0);// rewind
+            return status || has_packed_index();
+        }
+        return false;
+    }
+
+    // index written by `shapeindex --packed`
+    inline bool has_packed_index() const
+    {
+        if (index_ && index_->is_open())
+        {
+            bool status = mapnik::util::check_packed_rtree(index_->file());
+            index_->seek(0);// rewind
             return status;
         }
         return false;
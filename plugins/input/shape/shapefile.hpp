@@ -78,19 +78,38 @@ struct shape_record
 {
     typename Tag::data_type data;
     std::size_t size;
+    std::size_t capacity;
     mutable std::size_t pos;
 
     explicit shape_record(size_t size_)
         : data(Tag::alloc(size_)),
           size(size_),
+          capacity(size_),
           pos(0)
     {}
 
+    shape_record(shape_record const&) = delete;
+    shape_record & operator=(shape_record const&) = delete;
+
     ~shape_record()
     {
         Tag::dealloc(data);
     }
 
+    // prepare for reading a record of size_ bytes, reusing the storage
+    // of the previous one if large enough
+    void reset(std::size_t size_)
+    {
+        if (size_ > capacity)
+        {
+            Tag::dealloc(data);
+            data = Tag::alloc(size_);
+            capacity = size_;
+        }
+        size = size_;
+        pos = 0;
+    }
+
     void set_data(typename Tag::data_type data_)
     {
         data = data_;
@@ -119,6 +138,14 @@ struct shape_record
         return val;
     }
 
+    // read NDR integer at byte offset without moving pos
+    int read_ndr_integer_at(std::size_t offset) const
+    {
+        std::int32_t val;
+        read_int32_ndr(&data[offset], val);
+        return val;
+    }
+
     int read_xdr_integer()
     {
         std::int32_t val;
@@ -135,6 +162,32 @@ struct shape_record
         return val;
     }
 
+    // append `count` x,y pairs straight from the record data
+    // (NDR doubles, same layout as geometry::point<double> on little
+    // endian hosts)
+    template <typename Points>
+    void read_points(Points & points, std::size_t count)
+    {
+        static_assert(sizeof(typename Points::value_type) == 2 * sizeof(double),
+                      "point must be two packed doubles");
+        long remaining = remains();
+        std::size_t available = remaining > 0 ? static_cast<std::size_t>(remaining) / 16 : 0;
+        if (count > available) count = available; // truncated record
+        if (count == 0) return;
+        std::size_t offset = points.size();
+        points.resize(offset + count);
+#ifndef MAPNIK_BIG_ENDIAN
+        std::memcpy(&points[offset], &data[pos], count * 16);
+        pos += count * 16;
+#else
+        for (std::size_t i = offset; i < offset + count; ++i)
+        {
+            points[i].x = read_double();
+            points[i].y = read_double();
+        }
+#endif
+    }
+
     long remains()
     {
         return (size - pos);
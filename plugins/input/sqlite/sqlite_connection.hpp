@@ -26,6 +26,10 @@
 // stl
 #include <string.h>
 #include <memory>
+#include <map>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#endif
 
 // mapnik
 #include <mapnik/datasource.hpp>
@@ -48,7 +52,7 @@ extern "C" {
 
 //==============================================================================
 
-class sqlite_connection
+class sqlite_connection : public std::enable_shared_from_this<sqlite_connection>
 {
 public:
 
@@ -102,6 +106,10 @@ public:
 
     virtual ~sqlite_connection ()
     {
+        for (auto const& item : statements_)
+        {
+            sqlite3_finalize(item.second);
+        }
         if (db_)
         {
             sqlite3_close (db_);
@@ -139,6 +147,41 @@ public:
         return std::make_shared<sqlite_resultset>(stmt);
     }
 
+    // Like execute_query, but reuses an idle statement prepared earlier from
+    // the same sql. Parameters are bound on the returned resultset, the
+    // statement goes back to the cache once the resultset is destroyed.
+    std::shared_ptr<sqlite_resultset> execute_cached_query(std::string const& sql)
+    {
+        sqlite3_stmt* stmt = 0;
+        {
+#ifdef MAPNIK_THREADSAFE
+            std::lock_guard<std::mutex> lock(statements_mutex_);
+#endif
+            auto itr = statements_.find(sql);
+            if (itr != statements_.end())
+            {
+                stmt = itr->second;
+                statements_.erase(itr);
+            }
+        }
+        if (!stmt)
+        {
+#ifdef MAPNIK_STATS
+            mapnik::progress_timer __stats__(std::clog, std::string("sqlite_resultset::execute_cached_query ") + sql);
+#endif
+            const int rc = sqlite3_prepare_v2 (db_, sql.c_str(), -1, &stmt, 0);
+            if (rc != SQLITE_OK)
+            {
+                throw_sqlite_error(sql);
+            }
+        }
+        std::shared_ptr<sqlite_connection> self = shared_from_this();
+        return std::make_shared<sqlite_resultset>(stmt, [self, sql](sqlite3_stmt* used)
+        {
+            self->release_statement(sql, used);
+        });
+    }
+
     void execute(std::string const& sql)
     {
 #ifdef MAPNIK_STATS
@@ -176,8 +219,32 @@ public:
 
 private:
 
+    // idle statements kept per connection, beyond that they are finalized
+    static constexpr std::size_t max_cached_statements = 32;
+
+    void release_statement(std::string const& sql, sqlite3_stmt* stmt)
+    {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(statements_mutex_);
+#endif
+        if (statements_.size() < max_cached_statements)
+        {
+            statements_.emplace(sql, stmt);
+        }
+        else
+        {
+            sqlite3_finalize(stmt);
+        }
+    }
+
     sqlite3* db_;
     std::string file_;
+    std::multimap<std::string, sqlite3_stmt*> statements_;
+#ifdef MAPNIK_THREADSAFE
+    std::mutex statements_mutex_;
+#endif
 };
 
 #endif // MAPNIK_SQLITE_CONNECTION_HPP
@@ -52,6 +52,19 @@ using mapnik::parameters;
 
 DATASOURCE_PLUGIN(sqlite_datasource)
 
+#ifdef MAPNIK_THREADSAFE
+namespace {
+
+// expires when the calling thread exits
+std::shared_ptr<char> const& thread_token()
+{
+    thread_local std::shared_ptr<char> token = std::make_shared<char>(0);
+    return token;
+}
+
+}
+#endif
+
 sqlite_datasource::sqlite_datasource(parameters const& params)
     : datasource(params),
       extent_(),
@@ -71,7 +84,9 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
       pixel_height_token_("!pixel_height!"),
       desc_(sqlite_datasource::name(), *params.get<std::string>("encoding", "utf-8")),
       format_(mapnik::wkbAuto),
-      twkb_encoding_(false)
+      twkb_encoding_(false),
+      geopackage_(false),
+      gpkg_index_(false)
 {
     /* TODO
        - throw if no primary key but spatial index is present?
@@ -116,6 +131,10 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
         {
             format_ = mapnik::wkbGeneric;
         }
+        else if (*wkb == "geopackage")
+        {
+            format_ = mapnik::wkbGeoPackage;
+        }
         else if (*wkb == "twkb")
         {
             format_ = mapnik::wkbGeneric;
@@ -148,6 +167,9 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
 
     // now actually create the connection and start executing setup sql
     dataset_ = std::make_shared<sqlite_connection>(dataset_name_);
+#ifdef MAPNIK_THREADSAFE
+    connections_.emplace(std::this_thread::get_id(), thread_connection{thread_token(), dataset_});
+#endif
 
     boost::optional<mapnik::value_integer> table_by_index = params.get<mapnik::value_integer>("table_by_index");
 
@@ -215,6 +237,24 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
         dataset_->execute(*iter);
     }
 
+    // GeoPackage feature tables register their geometry column, geometries
+    // are stored as GeoPackage blobs (header with envelope + WKB)
+    std::string gpkg_table(geometry_table_);
+    sqlite_utils::dequote(gpkg_table);
+    std::string gpkg_column;
+    if (sqlite_utils::gpkg_geometry_column(dataset_, gpkg_table, gpkg_column))
+    {
+        geopackage_ = true;
+        if (geometry_field_.empty())
+        {
+            geometry_field_ = gpkg_column;
+        }
+        if (!wkb)
+        {
+            format_ = mapnik::wkbGeoPackage;
+        }
+    }
+
     bool found_types_via_subquery = false;
     if (using_subquery_)
     {
@@ -239,7 +279,8 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
                                                 geometry_field_,
                                                 geometry_table_,
                                                 desc_,
-                                                dataset_);
+                                                dataset_,
+                                                geopackage_);
 
     if (! found_table)
     {
@@ -271,6 +312,17 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
         throw datasource_exception(s.str());
     }
 
+    // the native rtree of a GeoPackage is used as is
+    if (geopackage_ && use_spatial_index_ && index_table_.empty())
+    {
+        std::string gpkg_index = sqlite_utils::gpkg_index_for_table(geometry_table_, geometry_field_);
+        if (sqlite_utils::has_rtree(gpkg_index, dataset_, true))
+        {
+            index_table_ = gpkg_index;
+            gpkg_index_ = true;
+        }
+    }
+
     if (index_table_.empty())
     {
         // Generate implicit index_table name - need to do this after
@@ -280,17 +332,19 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
 
     std::string index_db = sqlite_utils::index_for_db(dataset_name_);
 
-    has_spatial_index_ = false;
-    if (use_spatial_index_)
+    has_spatial_index_ = gpkg_index_;
+    if (use_spatial_index_ && !gpkg_index_)
     {
 #ifdef MAPNIK_STATS
         mapnik::progress_timer __stats2__(std::clog, "sqlite_datasource::init(use_spatial_index)");
 #endif
 
         bool index_db_attached = false;
+        std::string const attach_index = "attach database '" + index_db + "' as " + index_table_;
         if (mapnik::util::exists(index_db))
         {
-            dataset_->execute("attach database '" + index_db + "' as " + index_table_);
+            dataset_->execute(attach_index);
+            init_statements_.push_back(attach_index);
             index_db_attached = true;
         }
         has_spatial_index_ = sqlite_utils::has_rtree(index_table_,dataset_);
@@ -317,7 +371,8 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
                     has_spatial_index_ = true;
                     if (!index_db_attached && mapnik::util::exists(index_db))
                     {
-                        dataset_->execute("attach database '" + index_db + "' as " + index_table_);
+                        dataset_->execute(attach_index);
+                        init_statements_.push_back(attach_index);
                     }
                 }
             }
@@ -335,6 +390,11 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
         }
     }
 
+    if (! extent_initialized_ && geopackage_ && metadata_.empty())
+    {
+        extent_initialized_ = sqlite_utils::gpkg_extent(dataset_, gpkg_table, index_table_, gpkg_index_, extent_);
+    }
+
     if (! extent_initialized_)
     {
 #ifdef MAPNIK_STATS
@@ -343,7 +403,7 @@ sqlite_datasource::sqlite_datasource(parameters const& params)
         // TODO - clean this up - reducing arguments
         std::string query = populate_tokens(table_, 0, 0);
         if (!sqlite_utils::detect_extent(dataset_,
-                                         has_spatial_index_,
+                                         has_spatial_index_ && !gpkg_index_,
                                          extent_,
                                          index_table_,
                                          metadata_,
@@ -387,6 +447,41 @@ std::string sqlite_datasource::populate_tokens(std::string const& sql, double pi
     return populated_sql;
 }
 
+std::shared_ptr<sqlite_connection> sqlite_datasource::connection() const
+{
+#ifdef MAPNIK_THREADSAFE
+    // sqlite connections are opened without a mutex, each rendering thread
+    // gets its own. In memory databases are private to their connection.
+    if (dataset_name_.compare(":memory:") == 0)
+    {
+        return dataset_;
+    }
+    std::shared_ptr<char> const& token = thread_token();
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto itr = connections_.find(std::this_thread::get_id());
+    // thread ids are reused, the token tells a new thread from the old one
+    if (itr != connections_.end() && itr->second.thread.lock() == token)
+    {
+        return itr->second.conn;
+    }
+    // connections of exited threads are closed once their last query is done
+    for (auto it = connections_.begin(); it != connections_.end();)
+    {
+        if (it->second.thread.expired()) it = connections_.erase(it);
+        else ++it;
+    }
+    auto conn = std::make_shared<sqlite_connection>(dataset_name_);
+    for (auto const& sql : init_statements_)
+    {
+        conn->execute(sql);
+    }
+    connections_[std::this_thread::get_id()] = thread_connection{token, conn};
+    return conn;
+#else
+    return dataset_;
+#endif
+}
+
 sqlite_datasource::~sqlite_datasource()
 {
 }
@@ -459,7 +554,7 @@ boost::optional<mapnik::datasource_geometry_t> sqlite_datasource::get_geometry_t
         {
             s << " LIMIT 5";
         }
-        std::shared_ptr<sqlite_resultset> rs = dataset_->execute_query(s.str());
+        std::shared_ptr<sqlite_resultset> rs = connection()->execute_query(s.str());
         int multi_type = 0;
         while (rs->is_valid() && rs->step_next())
         {
@@ -546,9 +641,14 @@ featureset_ptr sqlite_datasource::features(query const& q) const
                                                key_field_,
                                                index_table_,
                                                geometry_table_,
-                                               intersects_token_);
+                                               intersects_token_,
+                                               true,
+                                               gpkg_index_);
         }
 
+        // the extent is bound as parameters, so the statement only depends
+        // on the requested attributes and the resolution and is prepared
+        // once per connection and zoom level
         query = populate_tokens(query, px_gw, px_gh);
 
         s << query ;
@@ -565,7 +665,11 @@ featureset_ptr sqlite_datasource::features(query const& q) const
 
         MAPNIK_LOG_DEBUG(sqlite) << "sqlite_datasource: " << s.str();
 
-        std::shared_ptr<sqlite_resultset> rs(dataset_->execute_query(s.str()));
+        std::shared_ptr<sqlite_resultset> rs(connection()->execute_cached_query(s.str()));
+        rs->bind(":mapnik_minx", e.minx());
+        rs->bind(":mapnik_miny", e.miny());
+        rs->bind(":mapnik_maxx", e.maxx());
+        rs->bind(":mapnik_maxy", e.maxy());
 
         return std::make_shared<sqlite_featureset>(rs,
                                                      ctx,
@@ -625,7 +729,9 @@ featureset_ptr sqlite_datasource::features_at_point(coord2d const& pt, double to
                                                key_field_,
                                                index_table_,
                                                geometry_table_,
-                                               intersects_token_);
+                                               intersects_token_,
+                                               false,
+                                               gpkg_index_);
         }
 
         query = populate_tokens(query, 0, 0);
@@ -644,7 +750,7 @@ featureset_ptr sqlite_datasource::features_at_point(coord2d const& pt, double to
 
         MAPNIK_LOG_DEBUG(sqlite) << "sqlite_datasource: " << s.str();
 
-        std::shared_ptr<sqlite_resultset> rs(dataset_->execute_query(s.str()));
+        std::shared_ptr<sqlite_resultset> rs(connection()->execute_query(s.str()));
 
         return std::make_shared<sqlite_featureset>(rs,
                                                      ctx,
@@ -41,6 +41,11 @@
 // stl
 #include <vector>
 #include <string>
+#include <map>
+#ifdef MAPNIK_THREADSAFE
+#include <mutex>
+#include <thread>
+#endif
 
 // sqlite
 #include "sqlite_connection.hpp"
@@ -63,6 +68,8 @@ private:
     // needed to attach auxillary databases
     void parse_attachdb(std::string const& attachdb) const;
     std::string populate_tokens(std::string const& sql, double pixel_width, double pixel_height) const;
+    // connection owned by the calling thread
+    std::shared_ptr<sqlite_connection> connection() const;
 
     mapnik::box2d<double> extent_;
     bool extent_initialized_;
@@ -88,7 +95,20 @@ private:
     bool use_spatial_index_;
     bool has_spatial_index_;
     bool using_subquery_;
+    bool geopackage_;
+    bool gpkg_index_;
+    // run on every connection, i.e. once per rendering thread, so "initdb"
+    // has to be idempotent (e.g. CREATE TEMP TABLE IF NOT EXISTS)
     mutable std::vector<std::string> init_statements_;
+#ifdef MAPNIK_THREADSAFE
+    struct thread_connection
+    {
+        std::weak_ptr<char> thread;
+        std::shared_ptr<sqlite_connection> conn;
+    };
+    mutable std::map<std::thread::id, thread_connection> connections_;
+    mutable std::mutex connections_mutex_;
+#endif
 };
 
 #endif // MAPNIK_SQLITE_DATASOURCE_HPP
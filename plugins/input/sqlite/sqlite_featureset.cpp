@@ -27,6 +27,7 @@
 #include <mapnik/feature.hpp>
 #include <mapnik/feature_layer_desc.hpp>
 #include <mapnik/wkb.hpp>
+#include <mapnik/wkb_view.hpp>
 #include <mapnik/unicode.hpp>
 #include <mapnik/value/types.hpp>
 #include <mapnik/feature_factory.hpp>
@@ -82,22 +83,40 @@ feature_ptr sqlite_featureset::next()
             continue;
         }
 
-        feature_ptr feature = feature_factory::create(ctx_,rs_->column_integer64(1));
         mapnik::geometry::geometry<double> geom;
-        if (twkb_encoding_) geom = geometry_utils::from_twkb(data, size);
-        else geom = geometry_utils::from_wkb(data, size, format_);
-        if (mapnik::geometry::is_empty(geom))
+        if (twkb_encoding_)
         {
-            continue;
+            geom = geometry_utils::from_twkb(data, size);
+            if (mapnik::geometry::is_empty(geom))
+            {
+                continue;
+            }
+            if (!spatial_index_)
+            {
+                // we are not using r-tree index, check if feature intersects bounding box
+                box2d<double> bbox = mapnik::geometry::envelope(geom);
+                if (!bbox_.intersects(bbox))
+                    continue;
+            }
         }
-
-        if (!spatial_index_)
+        else
         {
-            // we are not using r-tree index, check if feature intersects bounding box
-            box2d<double> bbox = mapnik::geometry::envelope(geom);
-            if (!bbox_.intersects(bbox))
+            mapnik::wkb_view view(data, size, format_);
+            if (!spatial_index_)
+            {
+                // we are not using r-tree index, check if feature intersects bounding box
+                // before paying for decoding the whole geometry
+                box2d<double> bbox = view.envelope();
+                if (!bbox.valid() || !bbox_.intersects(bbox))
+                    continue;
+            }
+            geom = view.to_geometry();
+            if (mapnik::geometry::is_empty(geom))
+            {
                 continue;
+            }
         }
+        feature_ptr feature = feature_factory::create(ctx_,rs_->column_integer64(1));
         feature->set_geometry(std::move(geom));
 
         for (int i = 2; i < rs_->column_count(); ++i)
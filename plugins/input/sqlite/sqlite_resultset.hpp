@@ -30,6 +30,7 @@
 
 // stl
 #include <string.h>
+#include <functional>
 
 // sqlite
 extern "C" {
@@ -44,8 +45,19 @@ class sqlite_resultset
 {
 public:
 
+    using release_type = std::function<void(sqlite3_stmt*)>;
+
     sqlite_resultset (sqlite3_stmt* stmt)
-        : stmt_(stmt)
+        : stmt_(stmt),
+          release_()
+    {
+    }
+
+    // the statement is handed to release on destruction instead of being
+    // finalized, so it can be reused
+    sqlite_resultset (sqlite3_stmt* stmt, release_type && release)
+        : stmt_(stmt),
+          release_(std::move(release))
     {
     }
 
@@ -53,7 +65,21 @@ public:
     {
         if (stmt_)
         {
-            sqlite3_finalize (stmt_);
+            if (release_) release_(stmt_);
+            else sqlite3_finalize (stmt_);
+        }
+    }
+
+    // binds a named parameter, parameters missing from the statement are ignored
+    void bind (const char* name, double value)
+    {
+        const int index = sqlite3_bind_parameter_index (stmt_, name);
+        if (index > 0 && sqlite3_bind_double (stmt_, index, value) != SQLITE_OK)
+        {
+            std::ostringstream s;
+            s << "SQLite Plugin: binding parameter " << name << " failed: "
+              << sqlite3_errmsg(sqlite3_db_handle(stmt_));
+            throw mapnik::datasource_exception(s.str());
         }
     }
 
@@ -140,6 +166,7 @@ public:
 private:
 
     sqlite3_stmt* stmt_;
+    release_type release_;
 };
 
 #endif // MAPNIK_SQLITE_RESULTSET_HPP
@@ -34,6 +34,7 @@
 #include <mapnik/datasource.hpp>
 #include <mapnik/params.hpp>
 #include <mapnik/sql_utils.hpp>
+#include <mapnik/wkb_view.hpp>
 #include <mapnik/util/fs.hpp>
 #include <mapnik/geometry/is_empty.hpp>
 #include <mapnik/geometry/envelope.hpp>
@@ -100,6 +101,14 @@ public:
         return "\"idx_" + table_trimmed + "_" + field + "\"";
     }
 
+    // GeoPackage spatial index extension (id, minx, maxx, miny, maxy)
+    static std::string gpkg_index_for_table(std::string const& table, std::string const& field)
+    {
+        std::string table_trimmed = table;
+        dequote(table_trimmed);
+        return "\"rtree_" + table_trimmed + "_" + field + "\"";
+    }
+
     static std::string index_for_db(std::string const& file)
     {
         //std::size_t idx = file.find_last_of(".");
@@ -118,13 +127,29 @@ public:
                                      std::string const& key_field,
                                      std::string const& index_table,
                                      std::string const& geometry_table,
-                                     std::string const& intersects_token)
+                                     std::string const& intersects_token,
+                                     bool bind_bbox = false,
+                                     bool gpkg_index = false)
     {
+        char const* pkid = gpkg_index ? "id" : "pkid";
+        char const* xmin = gpkg_index ? "minx" : "xmin";
+        char const* xmax = gpkg_index ? "maxx" : "xmax";
+        char const* ymin = gpkg_index ? "miny" : "ymin";
+        char const* ymax = gpkg_index ? "maxy" : "ymax";
         std::ostringstream spatial_sql;
         spatial_sql << std::setprecision(16);
-        spatial_sql << key_field << " IN (SELECT pkid FROM " << index_table;
-        spatial_sql << " WHERE xmax>=" << e.minx() << " AND xmin<=" << e.maxx() ;
-        spatial_sql << " AND ymax>=" << e.miny() << " AND ymin<=" << e.maxy() << ")";
+        spatial_sql << key_field << " IN (SELECT " << pkid << " FROM " << index_table;
+        if (bind_bbox)
+        {
+            // named parameters, bound by the caller
+            spatial_sql << " WHERE " << xmax << ">=:mapnik_minx AND " << xmin << "<=:mapnik_maxx";
+            spatial_sql << " AND " << ymax << ">=:mapnik_miny AND " << ymin << "<=:mapnik_maxy)";
+        }
+        else
+        {
+            spatial_sql << " WHERE " << xmax << ">=" << e.minx() << " AND " << xmin << "<=" << e.maxx() ;
+            spatial_sql << " AND " << ymax << ">=" << e.miny() << " AND " << ymin << "<=" << e.maxy() << ")";
+        }
         if (boost::algorithm::ifind_first(query,  intersects_token))
         {
             boost::algorithm::ireplace_all(query, intersects_token, spatial_sql.str());
@@ -194,10 +219,10 @@ public:
             const char* data = static_cast<const char*>(rs->column_blob(0, size));
             if (data)
             {
-                mapnik::geometry::geometry<double> geom = mapnik::geometry_utils::from_wkb(data, size, mapnik::wkbAuto);
-                if (!mapnik::geometry::is_empty(geom))
+                mapnik::wkb_view geom(data, size, mapnik::wkbAuto);
+                if (!geom.is_empty())
                 {
-                    mapnik::box2d<double> bbox = mapnik::geometry::envelope(geom);
+                    mapnik::box2d<double> bbox = geom.envelope();
                     if (bbox.valid())
                     {
                         if (first)
@@ -278,10 +303,10 @@ public:
                 const char* data = (const char*) rs->column_blob(0, size);
                 if (data)
                 {
-                    mapnik::geometry::geometry<double> geom = mapnik::geometry_utils::from_wkb(data, size, mapnik::wkbAuto);
-                    if (!mapnik::geometry::is_empty(geom))
+                    mapnik::wkb_view geom(data, size, mapnik::wkbAuto);
+                    if (!geom.is_empty())
                     {
-                        mapnik::box2d<double> bbox = mapnik::geometry::envelope(geom);
+                        mapnik::box2d<double> bbox = geom.envelope();
                         if (bbox.valid())
                         {
                             ps.bind(bbox);
@@ -354,10 +379,10 @@ public:
             const char* data = static_cast<const char*>(rs->column_blob(0, size));
             if (data)
             {
-                mapnik::geometry::geometry<double> geom = mapnik::geometry_utils::from_wkb(data, size, mapnik::wkbAuto);
-                if (!mapnik::geometry::is_empty(geom))
+                mapnik::wkb_view geom(data, size, mapnik::wkbAuto);
+                if (!geom.is_empty())
                 {
-                    mapnik::box2d<double> bbox = mapnik::geometry::envelope(geom);
+                    mapnik::box2d<double> bbox = geom.envelope();
                     if (bbox.valid())
                     {
                         const int type_oid = rs->column_type(1);
@@ -531,12 +556,19 @@ public:
         return false;
     }
 
-    static bool has_rtree(std::string const& index_table,std::shared_ptr<sqlite_connection> ds)
+    static bool has_rtree(std::string const& index_table,std::shared_ptr<sqlite_connection> ds, bool gpkg_index = false)
     {
         try
         {
             std::ostringstream s;
-            s << "SELECT pkid,xmin,xmax,ymin,ymax FROM " << index_table << " LIMIT 1";
+            if (gpkg_index)
+            {
+                s << "SELECT id,minx,maxx,miny,maxy FROM " << index_table << " LIMIT 1";
+            }
+            else
+            {
+                s << "SELECT pkid,xmin,xmax,ymin,ymax FROM " << index_table << " LIMIT 1";
+            }
             std::shared_ptr<sqlite_resultset> rs = ds->execute_query(s.str());
             if (rs->is_valid() && rs->step_next())
             {
@@ -551,6 +583,63 @@ public:
         return false;
     }
 
+    // name of the geometry column of a GeoPackage feature table
+    static bool gpkg_geometry_column(std::shared_ptr<sqlite_connection> ds,
+                                     std::string const& table,
+                                     std::string & column)
+    {
+        try
+        {
+            std::ostringstream s;
+            s << "SELECT column_name FROM gpkg_geometry_columns"
+              << " WHERE LOWER(table_name) = LOWER('" << table << "')";
+            std::shared_ptr<sqlite_resultset> rs = ds->execute_query(s.str());
+            if (rs->is_valid() && rs->step_next())
+            {
+                const char* name = rs->column_text(0);
+                if (name)
+                {
+                    column = name;
+                    return true;
+                }
+            }
+        }
+        catch (std::exception const& ex)
+        {
+            MAPNIK_LOG_DEBUG(sqlite) << "gpkg_geometry_column returned:" << ex.what();
+        }
+        return false;
+    }
+
+    // GeoPackage extent, from the rtree when there is one, otherwise
+    // from the (informative) bounds in gpkg_contents
+    static bool gpkg_extent(std::shared_ptr<sqlite_connection> ds,
+                            std::string const& table,
+                            std::string const& index_table,
+                            bool gpkg_index,
+                            mapnik::box2d<double> & extent)
+    {
+        std::vector<std::string> queries;
+        if (gpkg_index)
+        {
+            queries.push_back("SELECT MIN(minx), MIN(miny), MAX(maxx), MAX(maxy) FROM " + index_table);
+        }
+        queries.push_back("SELECT min_x, min_y, max_x, max_y FROM gpkg_contents"
+                          " WHERE LOWER(table_name) = LOWER('" + table + "')");
+        for (auto const& sql : queries)
+        {
+            MAPNIK_LOG_DEBUG(sqlite) << "sqlite_datasource: executing: '" << sql << "'";
+            std::shared_ptr<sqlite_resultset> rs(ds->execute_query(sql));
+            if (rs->is_valid() && rs->step_next() && !rs->column_isnull(0) && !rs->column_isnull(3))
+            {
+                extent.init(rs->column_double(0), rs->column_double(1),
+                            rs->column_double(2), rs->column_double(3));
+                return true;
+            }
+        }
+        return false;
+    }
+
     static bool detect_types_from_subquery(std::string const& query,
                                            std::string & geometry_field,
                                            mapnik::layer_descriptor & desc,
@@ -612,7 +701,8 @@ public:
                            std::string & field,
                            std::string & table,
                            mapnik::layer_descriptor & desc,
-                           std::shared_ptr<sqlite_connection> ds)
+                           std::shared_ptr<sqlite_connection> ds,
+                           bool geopackage = false)
     {
 
         // http://www.sqlite.org/pragma.html#pragma_table_info
@@ -637,6 +727,11 @@ public:
                 key_field = fld_name;
                 found_pk = true;
             }
+            // the geometry column of a GeoPackage table is not an attribute
+            if (geopackage && field == fld_name)
+            {
+                continue;
+            }
             if (! detected_types)
             {
                 // see 2.1 "Column Affinity" at http://www.sqlite.org/datatype3.html
@@ -30,6 +30,8 @@
 #include <boost/algorithm/string.hpp>
 
 // mapnik
+#include <mapnik/debug.hpp>
+#include <mapnik/timer.hpp>
 #include <mapnik/unicode.hpp>
 #include <mapnik/value/types.hpp>
 #include <mapnik/geometry/box2d.hpp>
@@ -157,11 +159,18 @@ topojson_datasource::topojson_datasource(parameters const& params)
             filename_ = *base + "/" + *file;
         else
             filename_ = *file;
+        cache_ = mapnik::feature_cache::open(filename_, params);
     }
     if (!inline_string_.empty())
     {
         parse_topojson(inline_string_.c_str());
     }
+    else if (cache_)
+    {
+        // features were decoded by `mapnik-index --cache`
+        extent_ = cache_->envelope();
+        cache_->describe(desc_);
+    }
     else
     {
         mapnik::util::file file(filename_);
@@ -195,6 +204,17 @@ void topojson_datasource::parse_topojson(T const& buffer)
         throw mapnik::datasource_exception("topojson_datasource: Failed parse TopoJSON file '" + filename_ + "'");
     }
 
+    // decode shared arcs once rather than for every geometry using them
+    {
+#ifdef MAPNIK_STATS
+        mapnik::progress_timer __stats__(std::clog, "topojson_datasource::decode_arcs");
+#endif
+        mapnik::topojson::arc_stats stats = mapnik::topojson::decode_arcs(topo_);
+        MAPNIK_LOG_DEBUG(topojson) << "topojson_datasource: decoded " << stats.num_arcs << " arcs, "
+                                   << stats.num_coordinates << " coordinates, "
+                                   << stats.memory_usage << " bytes";
+    }
+
     using values_container = std::vector< std::pair<box_type, std::size_t> >;
     values_container values;
     values.reserve(topo_.geometries.size());
@@ -235,6 +255,7 @@ const char * topojson_datasource::name()
 
 boost::optional<mapnik::datasource_geometry_t> topojson_datasource::get_geometry_type() const
 {
+    if (cache_) return cache_->geometry_type();
     boost::optional<mapnik::datasource_geometry_t> result;
     int multi_type = 0;
     std::size_t num_features = topo_.geometries.size();
@@ -276,6 +297,7 @@ mapnik::layer_descriptor topojson_datasource::get_descriptor() const
 
 mapnik::featureset_ptr topojson_datasource::features(mapnik::query const& q) const
 {
+    if (cache_) return cache_->features(q);
     // if the query box intersects our world extent then query for features
     mapnik::box2d<double> const& box = q.get_bbox();
     if (extent_.intersects(box))
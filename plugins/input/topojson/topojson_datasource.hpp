@@ -31,6 +31,7 @@
 #include <mapnik/geometry/box2d.hpp>
 #include <mapnik/coord.hpp>
 #include <mapnik/feature_layer_desc.hpp>
+#include <mapnik/feature_cache.hpp>
 #include <mapnik/unicode.hpp>
 #include <mapnik/json/topology.hpp>
 
@@ -81,6 +82,7 @@ private:
     std::unique_ptr<mapnik::transcoder> tr_;
     mapnik::topojson::topology topo_;
     std::unique_ptr<spatial_index_type> tree_;
+    std::shared_ptr<mapnik::feature_cache const> cache_; // <file>.fcache
 };
 
 
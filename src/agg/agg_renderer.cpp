@@ -43,6 +43,7 @@
 #include <mapnik/image_filter.hpp>
 #include <mapnik/image_any.hpp>
 #include <mapnik/make_unique.hpp>
+#include <mapnik/renderer_common/transformed_geometry_cache.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -66,6 +67,7 @@ MAPNIK_DISABLE_WARNING_POP
 
 // stl
 #include <cmath>
+#include <algorithm>
 
 namespace mapnik
 {
@@ -159,6 +161,7 @@ template <typename T0, typename T1>
 void agg_renderer<T0,T1>::setup(Map const &m, buffer_type & pixmap)
 {
     buffers_.emplace(pixmap);
+    common_.geometry_cache_ = std::make_shared<transformed_geometry_cache>();
 
     mapnik::set_premultiplied_alpha(pixmap, true);
     boost::optional<color> const& bg = m.background();
@@ -561,6 +564,31 @@ void agg_renderer<T0,T1>::render_marker(pixel_position const& pos,
     util::apply_visitor(visitor, marker);
 }
 
+template <typename T0, typename T1>
+bool agg_renderer<T0,T1>::process(rule::symbolizers const& syms,
+                                  mapnik::feature_impl & feature,
+                                  proj_transform const& prj_trans)
+{
+    if (!common_.geometry_cache_) return false;
+    common_.geometry_cache_->start_rule();
+    // only line symbolizers share geometries: the clip box of a polygon
+    // symbolizer is never padded like the one of a line
+    std::size_t lines = std::count_if(syms.begin(), syms.end(),
+                                      [](symbolizer const& sym) { return sym.is<line_symbolizer>(); });
+    if (lines < 2) return false;
+    for (symbolizer const& sym : syms)
+    {
+        if (!sym.is<line_symbolizer>()) continue;
+        transformed_geometry_key key;
+        double padding;
+        if (line_geometry_key(sym.get<line_symbolizer>(), feature, prj_trans, key, padding))
+        {
+            common_.geometry_cache_->add_candidate(key, padding);
+        }
+    }
+    return false;
+}
+
 template <typename T0, typename T1>
 bool agg_renderer<T0,T1>::painted()
 {
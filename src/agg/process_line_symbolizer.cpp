@@ -31,6 +31,7 @@
 #include <mapnik/vertex_processor.hpp>
 #include <mapnik/renderer_common/clipping_extent.hpp>
 #include <mapnik/renderer_common/apply_vertex_converter.hpp>
+#include <mapnik/renderer_common/transformed_geometry_cache.hpp>
 #include <mapnik/geometry/geometry_type.hpp>
 
 #include <mapnik/warning.hpp>
@@ -90,6 +91,82 @@ void set_join_caps_aa(Symbolizer const& sym, Rasterizer & ras, Feature & feature
     }
 }
 
+namespace {
+
+// padding of the clip box of a line, in map units, so that its caps, joins
+// and offset just outside the view are still drawn
+inline double line_clip_padding(renderer_common const& common, double width, double offset)
+{
+    double pad_per_pixel = static_cast<double>(common.query_extent_.width()/common.width_);
+    double pixels = std::ceil(std::max(width / 2.0 + std::fabs(offset),
+                                      (std::fabs(offset) * offset_converter_default_threshold)));
+    return pad_per_pixel * pixels * common.scale_factor_;
+}
+
+inline transformed_geometry_key::clip_type line_clip_type(feature_impl const& feature)
+{
+    geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
+    if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
+        return transformed_geometry_key::clip_poly;
+    else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
+        return transformed_geometry_key::clip_line;
+    return transformed_geometry_key::no_clip;
+}
+
+} // anonymous namespace
+
+template <typename T0, typename T1>
+bool agg_renderer<T0,T1>::line_geometry_key(line_symbolizer const& sym,
+                                            mapnik::feature_impl & feature,
+                                            proj_transform const& prj_trans,
+                                            transformed_geometry_key & key,
+                                            double & padding) const
+{
+    // dashes, simplification and smoothing depend on where the clipped path
+    // starts, so these lines keep their own clip box and don't share a path
+    if (has_key(sym, keys::stroke_dasharray)) return false;
+    if (get<value_double, keys::simplify_tolerance>(sym, feature, common_.vars_) > 0.0) return false;
+    if (get<value_double, keys::smooth>(sym, feature, common_.vars_) > 0.0) return false;
+
+    agg::trans_affine tr;
+    auto transform = get_optional<transform_type>(sym, keys::geometry_transform);
+    if (transform) evaluate_transform(tr, feature, common_.vars_, *transform, common_.scale_factor_);
+
+    value_bool clip = get<value_bool, keys::clip>(sym, feature, common_.vars_);
+    value_double width = get<value_double, keys::stroke_width>(sym, feature, common_.vars_);
+    value_double offset = get<value_double, keys::offset>(sym, feature, common_.vars_);
+    padding = line_clip_padding(common_, width, offset);
+    key = transformed_geometry_config(sym, feature, common_.vars_, common_.t_, prj_trans, tr,
+                                      common_.scale_factor_,
+                                      clip ? line_clip_type(feature) : transformed_geometry_key::no_clip,
+                                      box2d<double>(), std::fabs(offset) > 0.0 ? offset : 0.0);
+    return true;
+}
+
+template <typename T0, typename T1>
+transformed_path const& agg_renderer<T0,T1>::transformed_geometry(line_symbolizer const& sym,
+                                                                  mapnik::feature_impl & feature,
+                                                                  proj_transform const& prj_trans,
+                                                                  agg::trans_affine const& tr,
+                                                                  transformed_geometry_key const& key)
+{
+    using vertex_converter_type = vertex_converter<clip_line_tag, clip_poly_tag, transform_tag,
+                                                   affine_transform_tag,
+                                                   simplify_tag, smooth_tag,
+                                                   offset_transform_tag>;
+    vertex_converter_type converter(key.clip_box,sym,common_.t_,prj_trans,tr,feature,common_.vars_,common_.scale_factor_);
+    if (key.clip == transformed_geometry_key::clip_poly)
+        converter.template set<clip_poly_tag>();
+    else if (key.clip == transformed_geometry_key::clip_line)
+        converter.template set<clip_line_tag>();
+    converter.set<transform_tag>(); // always transform
+    if (std::fabs(key.offset) > 0.0) converter.set<offset_transform_tag>(); // parallel offset
+    converter.set<affine_transform_tag>(); // optional affine transform
+    if (key.simplify_tolerance > 0.0) converter.set<simplify_tag>(); // optional simplify converter
+    if (key.smooth > 0.0) converter.set<smooth_tag>(); // optional smooth converter
+    return common_.geometry_cache_->get(feature, key, converter);
+}
+
 template <typename T0, typename T1>
 void agg_renderer<T0,T1>::process(line_symbolizer const& sym,
                               mapnik::feature_impl & feature,
@@ -139,15 +216,20 @@ void agg_renderer<T0,T1>::process(line_symbolizer const& sym,
     value_double simplify_tolerance = get<value_double, keys::simplify_tolerance>(sym, feature, common_.vars_);
     value_double smooth = get<value_double, keys::smooth>(sym, feature, common_.vars_);
     line_rasterizer_enum rasterizer_e = get<line_rasterizer_enum, keys::line_rasterizer>(sym, feature, common_.vars_);
+
+    // only record the transformed geometry if another symbolizer of the rule
+    // can reuse it; all of them then clip to the same, widest padded box
+    transformed_geometry_key key;
+    double padding = 0.0;
+    bool shared = common_.geometry_cache_ && common_.geometry_cache_->active() &&
+        line_geometry_key(sym, feature, prj_trans, key, padding) &&
+        common_.geometry_cache_->shared(key, padding);
     if (clip)
     {
-        double pad_per_pixel = static_cast<double>(common_.query_extent_.width()/common_.width_);
-        double pixels = std::ceil(std::max(width / 2.0 + std::fabs(offset),
-                                          (std::fabs(offset) * offset_converter_default_threshold)));
-        double padding = pad_per_pixel * pixels * common_.scale_factor_;
-
+        if (!shared) padding = line_clip_padding(common_, width, offset);
         clip_box.pad(padding);
     }
+    key.clip_box = clip_box;
 
     if (rasterizer_e == RASTERIZER_FAST)
     {
@@ -159,59 +241,80 @@ void agg_renderer<T0,T1>::process(line_symbolizer const& sym,
         rasterizer_type ras(ren);
         set_join_caps_aa(sym, ras, feature, common_.vars_);
 
-        using vertex_converter_type = vertex_converter<clip_line_tag, clip_poly_tag, transform_tag,
-                                                       affine_transform_tag,
-                                                       simplify_tag, smooth_tag,
-                                                       offset_transform_tag>;
-        vertex_converter_type converter(clip_box,sym,common_.t_,prj_trans,tr,feature,common_.vars_,common_.scale_factor_);
-        if (clip)
+        if (shared)
+        {
+            transformed_path_adapter path(transformed_geometry(sym, feature, prj_trans, tr, key));
+            ras.add_path(path);
+        }
+        else
         {
-            geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
-            if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
-                converter.template set<clip_poly_tag>();
-            else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
-                converter.template set<clip_line_tag>();
+            using vertex_converter_type = vertex_converter<clip_line_tag, clip_poly_tag, transform_tag,
+                                                           affine_transform_tag,
+                                                           simplify_tag, smooth_tag,
+                                                           offset_transform_tag>;
+            vertex_converter_type converter(clip_box,sym,common_.t_,prj_trans,tr,feature,common_.vars_,common_.scale_factor_);
+            if (clip)
+            {
+                geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
+                if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
+                    converter.template set<clip_poly_tag>();
+                else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
+                    converter.template set<clip_line_tag>();
+            }
+            converter.set<transform_tag>(); // always transform
+            if (std::fabs(offset) > 0.0) converter.set<offset_transform_tag>(); // parallel offset
+            converter.set<affine_transform_tag>(); // optional affine transform
+            if (simplify_tolerance > 0.0) converter.set<simplify_tag>(); // optional simplify converter
+            if (smooth > 0.0) converter.set<smooth_tag>(); // optional smooth converter
+
+            using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer_type>;
+            using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
+            apply_vertex_converter_type apply(converter, ras);
+            mapnik::util::apply_visitor(vertex_processor_type(apply),feature.get_geometry());
         }
-        converter.set<transform_tag>(); // always transform
-        if (std::fabs(offset) > 0.0) converter.set<offset_transform_tag>(); // parallel offset
-        converter.set<affine_transform_tag>(); // optional affine transform
-        if (simplify_tolerance > 0.0) converter.set<simplify_tag>(); // optional simplify converter
-        if (smooth > 0.0) converter.set<smooth_tag>(); // optional smooth converter
-
-        using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer_type>;
-        using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
-        apply_vertex_converter_type apply(converter, ras);
-        mapnik::util::apply_visitor(vertex_processor_type(apply),feature.get_geometry());
     }
     else
     {
-        using vertex_converter_type = vertex_converter<clip_line_tag, clip_poly_tag, transform_tag,
-                                                       affine_transform_tag,
-                                                       simplify_tag, smooth_tag,
-                                                       offset_transform_tag,
-                                                       dash_tag, stroke_tag>;
-        vertex_converter_type converter(clip_box, sym,common_.t_,prj_trans,tr,feature,common_.vars_,common_.scale_factor_);
-        if (clip)
+        if (shared)
+        {
+            transformed_path_adapter path(transformed_geometry(sym, feature, prj_trans, tr, key));
+            using vertex_converter_type = vertex_converter<dash_tag, stroke_tag>;
+            vertex_converter_type converter(clip_box, sym,common_.t_,prj_trans,tr,feature,common_.vars_,common_.scale_factor_);
+            if (has_key(sym, keys::stroke_dasharray))
+                converter.set<dash_tag>();
+            converter.set<stroke_tag>(); //always stroke
+            converter.apply(path, *ras_ptr);
+        }
+        else
         {
-            geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
-            if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
-                converter.template set<clip_poly_tag>();
-            else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
-                converter.template set<clip_line_tag>();
+            using vertex_converter_type = vertex_converter<clip_line_tag, clip_poly_tag, transform_tag,
+                                                           affine_transform_tag,
+                                                           simplify_tag, smooth_tag,
+                                                           offset_transform_tag,
+                                                           dash_tag, stroke_tag>;
+            vertex_converter_type converter(clip_box, sym,common_.t_,prj_trans,tr,feature,common_.vars_,common_.scale_factor_);
+            if (clip)
+            {
+                geometry::geometry_types type = geometry::geometry_type(feature.get_geometry());
+                if (type == geometry::geometry_types::Polygon || type == geometry::geometry_types::MultiPolygon)
+                    converter.template set<clip_poly_tag>();
+                else if (type == geometry::geometry_types::LineString || type == geometry::geometry_types::MultiLineString)
+                    converter.template set<clip_line_tag>();
+            }
+            converter.set<transform_tag>(); // always transform
+            if (std::fabs(offset) > 0.0) converter.set<offset_transform_tag>(); // parallel offset
+            converter.set<affine_transform_tag>(); // optional affine transform
+            if (simplify_tolerance > 0.0) converter.set<simplify_tag>(); // optional simplify converter
+            if (smooth > 0.0) converter.set<smooth_tag>(); // optional smooth converter
+            if (has_key(sym, keys::stroke_dasharray))
+                converter.set<dash_tag>();
+            converter.set<stroke_tag>(); //always stroke
+
+            using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer>;
+            using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
+            apply_vertex_converter_type apply(converter, *ras_ptr);
+            mapnik::util::apply_visitor(vertex_processor_type(apply),feature.get_geometry());
         }
-        converter.set<transform_tag>(); // always transform
-        if (std::fabs(offset) > 0.0) converter.set<offset_transform_tag>(); // parallel offset
-        converter.set<affine_transform_tag>(); // optional affine transform
-        if (simplify_tolerance > 0.0) converter.set<simplify_tag>(); // optional simplify converter
-        if (smooth > 0.0) converter.set<smooth_tag>(); // optional smooth converter
-        if (has_key(sym, keys::stroke_dasharray))
-            converter.set<dash_tag>();
-        converter.set<stroke_tag>(); //always stroke
-
-        using apply_vertex_converter_type = detail::apply_vertex_converter<vertex_converter_type, rasterizer>;
-        using vertex_processor_type = geometry::vertex_processor<apply_vertex_converter_type>;
-        apply_vertex_converter_type apply(converter, *ras_ptr);
-        mapnik::util::apply_visitor(vertex_processor_type(apply),feature.get_geometry());
 
         using renderer_type = agg::renderer_scanline_aa_solid<renderer_base>;
         renderer_type ren(renb);
@@ -226,5 +329,10 @@ void agg_renderer<T0,T1>::process(line_symbolizer const& sym,
 template void agg_renderer<image_rgba8>::process(line_symbolizer const&,
                                               mapnik::feature_impl &,
                                               proj_transform const&);
+template bool agg_renderer<image_rgba8>::line_geometry_key(line_symbolizer const&,
+                                                        mapnik::feature_impl &,
+                                                        proj_transform const&,
+                                                        transformed_geometry_key &,
+                                                        double &) const;
 
 }
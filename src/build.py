@@ -175,11 +175,13 @@ source = Split(
     geometry/envelope.cpp
     geometry/interior.cpp
     geometry/polylabel.cpp
+    geometry/vertex_importance.cpp
     expression_node.cpp
     expression_string.cpp
     expression.cpp
     transform_expression.cpp
     transform_expression_grammar_x3.cpp
+    feature_cache.cpp
     feature_kv_iterator.cpp
     feature_style_processor.cpp
     feature_type_style.cpp
@@ -211,6 +213,7 @@ source = Split(
     rule.cpp
     save_map.cpp
     wkb.cpp
+    wkb_view.cpp
     twkb.cpp
     projection.cpp
     proj_transform.cpp
@@ -236,6 +239,7 @@ source = Split(
     warp.cpp
     vertex_cache.cpp
     vertex_adapters.cpp
+    vertex_importance_cache.cpp
     text/font_library.cpp
     text/text_layout.cpp
     text/text_line.cpp
@@ -0,0 +1,498 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/debug.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_kv_iterator.hpp>
+#include <mapnik/geom_util.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/value.hpp>
+#include <mapnik/wkb.hpp>
+#include <mapnik/geometry/envelope.hpp>
+#include <mapnik/util/file_io.hpp>
+#include <mapnik/util/fs.hpp>
+#include <mapnik/util/geometry_to_wkb.hpp>
+#include <mapnik/util/packed_rtree.hpp>
+#include <mapnik/util/trim.hpp>
+#include <mapnik/util/utf_conv_win.hpp>
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+#include <mapnik/mapped_memory_cache.hpp>
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+MAPNIK_DISABLE_WARNING_POP
+#endif
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/filesystem/operations.hpp>
+MAPNIK_DISABLE_WARNING_POP
+
+// stl
+#include <algorithm>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace mapnik {
+
+namespace {
+
+constexpr char feature_cache_magic[16] = "mapnik-fcache";
+constexpr std::uint32_t feature_cache_version = 2;
+constexpr std::uint32_t feature_cache_byte_order = 0x01020304;
+constexpr std::size_t feature_cache_page_size = util::packed_rtree_page_size;
+constexpr std::size_t feature_cache_header_size = 144; // without the options
+// datasource parameters changing how a source file is parsed
+constexpr char const* feature_cache_options[] = {"separator", "quote", "headers"};
+
+enum value_tag : std::uint8_t
+{
+    tag_null = 0,
+    tag_bool = 1,
+    tag_integer = 2,
+    tag_double = 3,
+    tag_string = 4
+};
+
+template <typename T>
+void append(std::vector<char> & buffer, T val)
+{
+    char const* p = reinterpret_cast<char const*>(&val);
+    buffer.insert(buffer.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+T read_pod(char const* data)
+{
+    T val;
+    std::memcpy(&val, data, sizeof(T));
+    return val;
+}
+
+std::uint64_t page_align(std::uint64_t pos)
+{
+    return (pos + feature_cache_page_size - 1) / feature_cache_page_size * feature_cache_page_size;
+}
+
+std::int64_t last_write_time(std::string const& filename)
+{
+    boost::system::error_code ec;
+#ifdef _WINDOWS
+    std::time_t time = boost::filesystem::last_write_time(mapnik::utf8_to_utf16(filename), ec);
+#else
+    std::time_t time = boost::filesystem::last_write_time(filename, ec);
+#endif
+    return ec ? 0 : static_cast<std::int64_t>(time);
+}
+
+eAttributeType attribute_type(value const& val)
+{
+    if (val.is<value_bool>()) return Boolean;
+    if (val.is<value_integer>()) return Integer;
+    if (val.is<value_double>()) return Double;
+    return String;
+}
+
+class feature_cache_featureset : public Featureset
+{
+public:
+    feature_cache_featureset(std::shared_ptr<feature_cache const> const& cache,
+                             std::vector<feature_cache_entry> && entries)
+        : cache_(cache),
+          entries_(std::move(entries)),
+          itr_(entries_.begin()) {}
+
+    feature_ptr next()
+    {
+        if (itr_ != entries_.end()) return cache_->read(*itr_++);
+        return feature_ptr();
+    }
+
+private:
+    std::shared_ptr<feature_cache const> cache_;
+    std::vector<feature_cache_entry> entries_;
+    std::vector<feature_cache_entry>::const_iterator itr_;
+};
+
+} // anonymous ns
+
+feature_cache_writer::feature_cache_writer(layer_descriptor const& desc,
+                                           boost::optional<datasource_geometry_t> const& geometry_type)
+    : columns_(),
+      column_index_(),
+      num_described_(0),
+      geometry_type_(geometry_type ? static_cast<std::int32_t>(*geometry_type) : -1),
+      extent_(),
+      records_(),
+      entries_()
+{
+    for (auto const& attr : desc.get_descriptors())
+    {
+        if (column_index_.emplace(attr.get_name(), columns_.size()).second)
+        {
+            columns_.emplace_back(attr.get_name(), static_cast<eAttributeType>(attr.get_type()));
+        }
+    }
+    num_described_ = static_cast<std::uint32_t>(columns_.size());
+}
+
+std::uint32_t feature_cache_writer::column(std::string const& name, value const& val)
+{
+    auto itr = column_index_.find(name);
+    if (itr != column_index_.end()) return itr->second;
+    std::uint32_t index = static_cast<std::uint32_t>(columns_.size());
+    column_index_.emplace(name, index);
+    columns_.emplace_back(name, attribute_type(val));
+    return index;
+}
+
+void feature_cache_writer::add(feature_impl const& feature)
+{
+    box2d<double> box = feature.envelope();
+    if (!box.valid()) return;
+    auto wkb = util::to_wkb(feature.get_geometry(), wkbNDR);
+    if (!wkb) return;
+    if (!extent_.valid()) extent_ = box;
+    else extent_.expand_to_include(box);
+
+    std::uint64_t offset = records_.size();
+    append(records_, static_cast<std::uint32_t>(wkb->size()));
+    records_.insert(records_.end(), wkb->buffer(), wkb->buffer() + wkb->size());
+    std::size_t count_pos = records_.size();
+    append(records_, std::uint32_t(0));
+    std::uint32_t count = 0;
+    for (auto const& kv : feature)
+    {
+        value const& val = std::get<1>(kv);
+        if (val.is<value_null>()) continue;
+        append(records_, column(std::get<0>(kv), val));
+        if (val.is<value_bool>())
+        {
+            append(records_, std::uint8_t(tag_bool));
+            append(records_, static_cast<std::uint8_t>(val.get<value_bool>() ? 1 : 0));
+        }
+        else if (val.is<value_integer>())
+        {
+            append(records_, std::uint8_t(tag_integer));
+            append(records_, static_cast<std::int64_t>(val.get<value_integer>()));
+        }
+        else if (val.is<value_double>())
+        {
+            append(records_, std::uint8_t(tag_double));
+            append(records_, val.get<value_double>());
+        }
+        else
+        {
+            std::string str = val.to_string();
+            append(records_, std::uint8_t(tag_string));
+            append(records_, static_cast<std::uint32_t>(str.size()));
+            records_.insert(records_.end(), str.begin(), str.end());
+        }
+        ++count;
+    }
+    std::memcpy(records_.data() + count_pos, &count, sizeof(count));
+    feature_cache_entry entry = {offset, static_cast<std::uint64_t>(records_.size() - offset),
+                                 static_cast<std::int64_t>(feature.id())};
+    entries_.emplace_back(entry, box2d<float>(box.minx(), box.miny(), box.maxx(), box.maxy()));
+}
+
+void feature_cache_writer::write(std::ostream & out, feature_cache_source const& source) const
+{
+    if (feature_cache_header_size + source.options.size() > feature_cache_page_size)
+    {
+        throw std::runtime_error("feature cache options too long");
+    }
+    std::vector<char> columns;
+    for (auto const& col : columns_)
+    {
+        append(columns, static_cast<std::uint8_t>(col.second));
+        append(columns, static_cast<std::uint32_t>(col.first.size()));
+        columns.insert(columns.end(), col.first.begin(), col.first.end());
+    }
+
+    box2d<float> extent(extent_.minx(), extent_.miny(), extent_.maxx(), extent_.maxy());
+    util::packed_rtree_builder<feature_cache_entry> builder(extent);
+    std::uint64_t columns_offset = feature_cache_page_size;
+    std::uint64_t rtree_offset = page_align(columns_offset + columns.size());
+    for (auto const& item : entries_) builder.insert(item.first, item.second);
+    std::ostringstream rtree;
+    builder.write(rtree);
+    std::string rtree_data = rtree.str();
+    std::uint64_t features_offset = page_align(rtree_offset + rtree_data.size());
+
+    std::vector<char> header;
+    header.insert(header.end(), feature_cache_magic, feature_cache_magic + sizeof(feature_cache_magic));
+    append(header, feature_cache_version);
+    append(header, static_cast<std::uint32_t>(columns_.size()));
+    append(header, static_cast<std::uint64_t>(entries_.size()));
+    append(header, extent_.minx());
+    append(header, extent_.miny());
+    append(header, extent_.maxx());
+    append(header, extent_.maxy());
+    append(header, source.size);
+    append(header, geometry_type_);
+    append(header, num_described_);
+    append(header, columns_offset);
+    append(header, static_cast<std::uint64_t>(columns.size()));
+    append(header, rtree_offset);
+    append(header, static_cast<std::uint64_t>(rtree_data.size()));
+    append(header, features_offset);
+    append(header, static_cast<std::uint64_t>(records_.size()));
+    append(header, source.mtime);
+    append(header, feature_cache_byte_order);
+    append(header, static_cast<std::uint32_t>(source.options.size()));
+    header.insert(header.end(), source.options.begin(), source.options.end());
+    header.resize(feature_cache_page_size, 0);
+
+    std::vector<char> padding(feature_cache_page_size, 0);
+    out.write(header.data(), header.size());
+    out.write(columns.data(), columns.size());
+    out.write(padding.data(), rtree_offset - columns_offset - columns.size());
+    out.write(rtree_data.data(), rtree_data.size());
+    out.write(padding.data(), features_offset - rtree_offset - rtree_data.size());
+    out.write(records_.data(), records_.size());
+}
+
+std::string feature_cache::filename(std::string const& source_filename)
+{
+    return source_filename + ".fcache";
+}
+
+boost::optional<feature_cache_source> feature_cache_source::from_file(std::string const& filename,
+                                                                       parameters const& params)
+{
+    boost::optional<feature_cache_source> result;
+    util::file file(filename);
+    if (!file) return result;
+    feature_cache_source source;
+    source.size = file.size();
+    source.mtime = last_write_time(filename);
+    for (char const* name : feature_cache_options)
+    {
+        boost::optional<std::string> param = params.get<std::string>(name);
+        if (!param) continue;
+        std::string val = util::trim_copy(*param);
+        if (val.empty()) continue;
+        // the CSV plugin only uses the first character of these
+        if (std::strcmp(name, "headers") != 0) val.resize(1);
+        source.options += std::string(name) + "=" + val + "\n";
+    }
+    result = std::move(source);
+    return result;
+}
+
+std::shared_ptr<feature_cache const> feature_cache::open(std::string const& source_filename,
+                                                         parameters const& params)
+{
+    std::string cache_filename = filename(source_filename);
+    if (!util::exists(cache_filename)) return nullptr;
+    boost::optional<feature_cache_source> source = feature_cache_source::from_file(source_filename, params);
+    if (!source) return nullptr;
+    std::shared_ptr<feature_cache const> cache;
+    try
+    {
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+        boost::optional<mapped_region_ptr> region = mapped_memory_cache::instance().find(cache_filename, true);
+        if (!region) return nullptr;
+        char const* data = reinterpret_cast<char const*>((*region)->get_address());
+        cache = std::make_shared<feature_cache>(*region, data, (*region)->get_size());
+#else
+        util::file file(cache_filename);
+        if (!file) return nullptr;
+        auto buffer = std::make_shared<std::vector<char>>(file.size());
+        if (!buffer->empty() && std::fread(buffer->data(), buffer->size(), 1, file.get()) != 1) return nullptr;
+        cache = std::make_shared<feature_cache>(buffer, buffer->data(), buffer->size());
+#endif
+    }
+    catch (std::exception const& ex)
+    {
+        MAPNIK_LOG_ERROR(feature_cache) << "feature_cache: ignoring '" << cache_filename << "': " << ex.what();
+        return nullptr;
+    }
+    if (!(cache->source() == *source))
+    {
+        MAPNIK_LOG_WARN(feature_cache) << "feature_cache: ignoring out of date '" << cache_filename << "'";
+        return nullptr;
+    }
+    return cache;
+}
+
+feature_cache::feature_cache(std::shared_ptr<void const> const& storage, char const* data, std::size_t size)
+    : storage_(storage),
+      data_(data),
+      size_(size),
+      ctx_(std::make_shared<context_type>())
+{
+    if (size_ < feature_cache_header_size
+        || std::strncmp(data_, feature_cache_magic, sizeof(feature_cache_magic)) != 0)
+    {
+        throw std::runtime_error("not a feature cache");
+    }
+    if (read_pod<std::uint32_t>(data_ + 16) != feature_cache_version)
+    {
+        throw std::runtime_error("unsupported feature cache version (regenerate with mapnik-index --cache)");
+    }
+    if (read_pod<std::uint32_t>(data_ + 136) != feature_cache_byte_order)
+    {
+        throw std::runtime_error("feature cache written on a host of different byte order");
+    }
+    source_.mtime = read_pod<std::int64_t>(data_ + 128);
+    std::uint32_t options_size = read_pod<std::uint32_t>(data_ + 140);
+    if (feature_cache_header_size + options_size > std::min(size_, feature_cache_page_size))
+    {
+        throw std::runtime_error("corrupt feature cache header");
+    }
+    source_.options.assign(data_ + feature_cache_header_size, options_size);
+    std::uint32_t num_columns = read_pod<std::uint32_t>(data_ + 20);
+    num_features_ = read_pod<std::uint64_t>(data_ + 24);
+    extent_.init(read_pod<double>(data_ + 32), read_pod<double>(data_ + 40),
+                 read_pod<double>(data_ + 48), read_pod<double>(data_ + 56));
+    source_.size = read_pod<std::uint64_t>(data_ + 64);
+    geometry_type_ = read_pod<std::int32_t>(data_ + 72);
+    num_described_ = read_pod<std::uint32_t>(data_ + 76);
+    std::uint64_t columns_offset = read_pod<std::uint64_t>(data_ + 80);
+    std::uint64_t columns_size = read_pod<std::uint64_t>(data_ + 88);
+    std::uint64_t rtree_offset = read_pod<std::uint64_t>(data_ + 96);
+    rtree_size_ = static_cast<std::size_t>(read_pod<std::uint64_t>(data_ + 104));
+    if (columns_offset + columns_size > size_ || rtree_offset + rtree_size_ > size_)
+    {
+        throw std::runtime_error("truncated feature cache");
+    }
+    std::uint64_t features_offset = read_pod<std::uint64_t>(data_ + 112);
+    std::uint64_t features_size = read_pod<std::uint64_t>(data_ + 120);
+    if (features_offset + features_size > size_)
+    {
+        throw std::runtime_error("truncated feature cache");
+    }
+    rtree_ = data_ + rtree_offset;
+    features_ = data_ + features_offset;
+    features_size_ = static_cast<std::size_t>(features_size);
+
+    char const* p = data_ + columns_offset;
+    char const* end = p + columns_size;
+    for (std::uint32_t i = 0; i < num_columns; ++i)
+    {
+        if (end - p < 5) throw std::runtime_error("truncated feature cache");
+        auto type = static_cast<eAttributeType>(read_pod<std::uint8_t>(p));
+        std::uint32_t length = read_pod<std::uint32_t>(p + 1);
+        p += 5;
+        if (static_cast<std::uint32_t>(end - p) < length) throw std::runtime_error("truncated feature cache");
+        columns_.emplace_back(std::string(p, length), type);
+        ctx_->push(columns_.back().first);
+        p += length;
+    }
+    num_described_ = std::min(num_described_, num_columns);
+}
+
+boost::optional<datasource_geometry_t> feature_cache::geometry_type() const
+{
+    boost::optional<datasource_geometry_t> result;
+    if (geometry_type_ >= 0) result = static_cast<datasource_geometry_t>(geometry_type_);
+    return result;
+}
+
+void feature_cache::describe(layer_descriptor & desc) const
+{
+    for (std::uint32_t i = 0; i < num_described_; ++i)
+    {
+        desc.add_descriptor(attribute_descriptor(columns_[i].first, columns_[i].second));
+    }
+}
+
+featureset_ptr feature_cache::features(query const& q) const
+{
+    box2d<double> const& box = q.get_bbox();
+    if (num_features_ == 0 || !extent_.intersects(box)) return make_invalid_featureset();
+    bounding_box_filter<float> filter(box2d<float>(box.minx(), box.miny(), box.maxx(), box.maxy()));
+    std::vector<feature_cache_entry> entries;
+    util::packed_rtree<feature_cache_entry, bounding_box_filter<float>>::query(filter, rtree_, rtree_size_, entries);
+    std::sort(entries.begin(), entries.end(), [](feature_cache_entry const& a, feature_cache_entry const& b)
+              { return a.offset < b.offset; });
+    return std::make_shared<feature_cache_featureset>(shared_from_this(), std::move(entries));
+}
+
+feature_ptr feature_cache::read(feature_cache_entry const& entry) const
+{
+    if (entry.offset + entry.size > features_size_ || entry.size < 8)
+    {
+        throw std::runtime_error("corrupt feature cache record");
+    }
+    char const* p = features_ + entry.offset;
+    char const* end = p + entry.size;
+    feature_ptr feature(feature_factory::create(ctx_, entry.id));
+    std::uint32_t wkb_size = read_pod<std::uint32_t>(p);
+    p += 4;
+    if (static_cast<std::size_t>(end - p) < wkb_size + 4u) throw std::runtime_error("corrupt feature cache record");
+    feature->set_geometry(geometry_utils::from_wkb(p, wkb_size, wkbGeneric));
+    p += wkb_size;
+    std::uint32_t count = read_pod<std::uint32_t>(p);
+    p += 4;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (end - p < 5) throw std::runtime_error("corrupt feature cache record");
+        std::uint32_t index = read_pod<std::uint32_t>(p);
+        std::uint8_t tag = read_pod<std::uint8_t>(p + 4);
+        p += 5;
+        if (index >= columns_.size()) throw std::runtime_error("corrupt feature cache record");
+        std::string const& name = columns_[index].first;
+        std::size_t available = static_cast<std::size_t>(end - p);
+        switch (tag)
+        {
+        case tag_bool:
+            if (available < 1) throw std::runtime_error("corrupt feature cache record");
+            feature->put(name, value_bool(*p != 0));
+            p += 1;
+            break;
+        case tag_integer:
+            if (available < 8) throw std::runtime_error("corrupt feature cache record");
+            feature->put(name, static_cast<value_integer>(read_pod<std::int64_t>(p)));
+            p += 8;
+            break;
+        case tag_double:
+            if (available < 8) throw std::runtime_error("corrupt feature cache record");
+            feature->put(name, read_pod<value_double>(p));
+            p += 8;
+            break;
+        case tag_string:
+        {
+            if (available < 4) throw std::runtime_error("corrupt feature cache record");
+            std::uint32_t length = read_pod<std::uint32_t>(p);
+            p += 4;
+            if (static_cast<std::size_t>(end - p) < length) throw std::runtime_error("corrupt feature cache record");
+            feature->put(name, value_unicode_string::fromUTF8(U_NAMESPACE_QUALIFIER StringPiece(p, static_cast<std::int32_t>(length))));
+            p += length;
+            break;
+        }
+        default:
+            throw std::runtime_error("corrupt feature cache record");
+        }
+    }
+    return feature;
+}
+
+}
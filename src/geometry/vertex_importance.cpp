@@ -0,0 +1,254 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include <mapnik/geometry/vertex_importance.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace mapnik { namespace geometry {
+
+namespace detail {
+
+template <typename Points>
+void effective_areas(Points const& pts, bool ring, vertex_importance & out)
+{
+    std::size_t const offset = out.size();
+    std::size_t const n = pts.size();
+    out.resize(offset + n, std::numeric_limits<double>::infinity());
+    if (n < 3) return;
+
+    auto triangle_area = [&pts] (std::size_t a, std::size_t b, std::size_t c)
+    {
+        auto const& A = pts[a];
+        auto const& B = pts[b];
+        auto const& C = pts[c];
+        return std::abs((A.x - C.x) * (B.y - A.y) - (A.x - B.x) * (C.y - A.y)) / 2.0;
+    };
+
+    std::vector<std::size_t> prev(n);
+    std::vector<std::size_t> next(n);
+    std::vector<double> area(n, -1.0);
+    using entry = std::pair<double, std::size_t>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+
+    next[0] = 1;
+    prev[n - 1] = n - 2;
+    for (std::size_t i = 1; i + 1 < n; ++i)
+    {
+        prev[i] = i - 1;
+        next[i] = i + 1;
+        area[i] = triangle_area(i - 1, i, i + 1);
+        queue.emplace(area[i], i);
+    }
+
+    std::size_t remaining = n - 2;
+    // keep at least two vertices besides the closing pair so rings stay rings
+    std::size_t const min_remaining = ring ? 2 : 0;
+    double max_area = 0.0;
+    while (!queue.empty() && remaining > min_remaining)
+    {
+        entry e = queue.top();
+        queue.pop();
+        std::size_t i = e.second;
+        if (e.first != area[i]) continue; // stale or already removed
+        // effective area must not decrease, otherwise a vertex would be
+        // dropped at a coarser scale than the neighbours it was merged into
+        max_area = std::max(max_area, e.first);
+        out[offset + i] = max_area;
+        area[i] = -1.0;
+        --remaining;
+
+        std::size_t p = prev[i];
+        std::size_t nx = next[i];
+        next[p] = nx;
+        prev[nx] = p;
+        if (p > 0)
+        {
+            area[p] = triangle_area(prev[p], p, nx);
+            queue.emplace(area[p], p);
+        }
+        if (nx + 1 < n)
+        {
+            area[nx] = triangle_area(p, nx, next[nx]);
+            queue.emplace(area[nx], nx);
+        }
+    }
+}
+
+struct compute_importance
+{
+    explicit compute_importance(vertex_importance & out)
+        : out_(out) {}
+
+    void operator() (geometry_empty const&) const {}
+
+    void operator() (point<double> const&) const
+    {
+        out_.push_back(std::numeric_limits<double>::infinity());
+    }
+
+    void operator() (line_string<double> const& line) const
+    {
+        effective_areas(line, false, out_);
+    }
+
+    void operator() (polygon<double> const& poly) const
+    {
+        for (auto const& ring : poly)
+        {
+            effective_areas(ring, true, out_);
+        }
+    }
+
+    void operator() (multi_point<double> const& multi_pt) const
+    {
+        out_.resize(out_.size() + multi_pt.size(), std::numeric_limits<double>::infinity());
+    }
+
+    void operator() (multi_line_string<double> const& multi_line) const
+    {
+        for (auto const& line : multi_line) (*this)(line);
+    }
+
+    void operator() (multi_polygon<double> const& multi_poly) const
+    {
+        for (auto const& poly : multi_poly) (*this)(poly);
+    }
+
+    void operator() (geometry_collection<double> const& collection) const
+    {
+        for (auto const& geom : collection) mapnik::util::apply_visitor(*this, geom);
+    }
+
+    vertex_importance & out_;
+};
+
+struct filter_importance
+{
+    filter_importance(vertex_importance const& importance, double min_area)
+        : importance_(importance),
+          min_area_(min_area),
+          pos_(0) {}
+
+    geometry<double> operator() (geometry_empty const& geom) const
+    {
+        return geom;
+    }
+
+    geometry<double> operator() (point<double> const& pt) const
+    {
+        ++pos_;
+        return pt;
+    }
+
+    geometry<double> operator() (line_string<double> const& line) const
+    {
+        return filter_points(line);
+    }
+
+    geometry<double> operator() (polygon<double> const& poly) const
+    {
+        return filter_polygon(poly);
+    }
+
+    geometry<double> operator() (multi_point<double> const& multi_pt) const
+    {
+        pos_ += multi_pt.size();
+        return multi_pt;
+    }
+
+    geometry<double> operator() (multi_line_string<double> const& multi_line) const
+    {
+        multi_line_string<double> result;
+        result.reserve(multi_line.size());
+        for (auto const& line : multi_line) result.push_back(filter_points(line));
+        return result;
+    }
+
+    geometry<double> operator() (multi_polygon<double> const& multi_poly) const
+    {
+        multi_polygon<double> result;
+        result.reserve(multi_poly.size());
+        for (auto const& poly : multi_poly) result.push_back(filter_polygon(poly));
+        return result;
+    }
+
+    geometry<double> operator() (geometry_collection<double> const& collection) const
+    {
+        geometry_collection<double> result;
+        result.reserve(collection.size());
+        for (auto const& geom : collection) result.push_back(mapnik::util::apply_visitor(*this, geom));
+        return result;
+    }
+
+private:
+    template <typename Points>
+    Points filter_points(Points const& pts) const
+    {
+        Points result;
+        for (auto const& pt : pts)
+        {
+            std::size_t index = pos_++;
+            if (index >= importance_.size() || importance_[index] >= min_area_)
+            {
+                result.push_back(pt);
+            }
+        }
+        return result;
+    }
+
+    polygon<double> filter_polygon(polygon<double> const& poly) const
+    {
+        polygon<double> result;
+        result.reserve(poly.size());
+        for (auto const& ring : poly) result.push_back(filter_points(ring));
+        return result;
+    }
+
+    vertex_importance const& importance_;
+    double const min_area_;
+    mutable std::size_t pos_;
+};
+
+} // ns detail
+
+vertex_importance compute_vertex_importance(geometry<double> const& geom)
+{
+    vertex_importance importance;
+    mapnik::util::apply_visitor(detail::compute_importance(importance), geom);
+    return importance;
+}
+
+geometry<double> filter_by_importance(geometry<double> const& geom,
+                                      vertex_importance const& importance,
+                                      double min_area)
+{
+    return mapnik::util::apply_visitor(detail::filter_importance(importance, min_area), geom);
+}
+
+}}
@@ -28,6 +28,14 @@
 #include <mapnik/memory_featureset.hpp>
 #include <mapnik/boolean.hpp>
 #include <mapnik/geometry/envelope.hpp>
+#include <mapnik/geometry/boost_adapters.hpp>
+#include <mapnik/raster.hpp>
+
+#include <mapnik/warning.hpp>
+MAPNIK_DISABLE_WARNING_PUSH
+#include <mapnik/warning_ignore.hpp>
+#include <boost/geometry/index/rtree.hpp>
+MAPNIK_DISABLE_WARNING_POP
 
 // stl
 #include <algorithm>
@@ -63,6 +71,27 @@ struct accumulate_extent
     bool first_;
 };
 
+struct memory_datasource::spatial_index
+{
+    using value_type = std::pair<box2d<double>, std::size_t>;
+    using tree_type = boost::geometry::index::rtree<value_type, boost::geometry::index::linear<16,4>>;
+    tree_type tree;
+};
+
+namespace {
+
+box2d<double> feature_extent(feature_ptr const& feature, datasource::datasource_t type)
+{
+    if (type == datasource::Raster)
+    {
+        raster_ptr const& source = feature->get_raster();
+        return source ? source->ext_ : box2d<double>();
+    }
+    return geometry::envelope(feature->get_geometry());
+}
+
+}
+
 const char * memory_datasource::name()
 {
     return "memory";
@@ -74,7 +103,9 @@ memory_datasource::memory_datasource(parameters const& _params)
             *params_.get<std::string>("encoding","utf-8")),
       type_(datasource::Vector),
       bbox_check_(*params_.get<boolean_type>("bbox_check", true)),
-      type_set_(false) {}
+      type_set_(false),
+      vertex_importance_(*params_.get<boolean_type>("vertex_importance", false)),
+      vertex_importance_tolerance_(*params_.get<double>("vertex_importance_tolerance", 0.5)) {}
 
 memory_datasource::~memory_datasource() {}
 
@@ -106,8 +137,56 @@ void memory_datasource::push(feature_ptr feature)
             throw std::runtime_error("Can not add a vector feature to a memory datasource that contains rasters");
         }
     }
+    if (vertex_importance_)
+    {
+        if (type_ == datasource::Vector)
+        {
+            importance_.push_back(feature->get_geometry());
+        }
+        else
+        {
+            importance_.push_back(geometry::geometry_empty());
+        }
+    }
     features_.push_back(feature);
     dirty_extent_ = true;
+    if (tree_)
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(tree_mutex_);
+#endif
+        box2d<double> box = feature_extent(feature, type_);
+        if (box.valid()) tree_->tree.insert(std::make_pair(box, features_.size() - 1));
+    }
+}
+
+std::vector<std::size_t> memory_datasource::query_index(box2d<double> const& box) const
+{
+    std::vector<spatial_index::value_type> values;
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(tree_mutex_);
+#endif
+        if (!tree_)
+        {
+            values.reserve(features_.size());
+            for (std::size_t i = 0; i < features_.size(); ++i)
+            {
+                box2d<double> ext = feature_extent(features_[i], type_);
+                if (ext.valid()) values.emplace_back(ext, i);
+            }
+            // packing algorithm
+            tree_ = std::make_unique<spatial_index>(spatial_index{spatial_index::tree_type(values)});
+            values.clear();
+        }
+        tree_->tree.query(boost::geometry::index::intersects(box), std::back_inserter(values));
+    }
+    std::vector<std::size_t> positions;
+    positions.reserve(values.size());
+    for (auto const& value : values) positions.push_back(value.second);
+    // preserve push order
+    std::sort(positions.begin(), positions.end());
+    return positions;
 }
 
 datasource::datasource_t memory_datasource::type() const
@@ -121,7 +200,18 @@ featureset_ptr memory_datasource::features(const query& q) const
     {
         return mapnik::make_invalid_featureset();
     }
-    return std::make_shared<memory_featureset>(q.get_bbox(),*this,bbox_check_);
+    double min_importance = 0.0;
+    if (vertex_importance_ && type_ == datasource::Vector)
+    {
+        auto const& res = q.resolution();
+        min_importance = geometry::importance_threshold(std::get<0>(res), std::get<1>(res),
+                                                        vertex_importance_tolerance_);
+    }
+    if (!bbox_check_)
+    {
+        return std::make_shared<memory_featureset>(q.get_bbox(),*this,bbox_check_,min_importance);
+    }
+    return std::make_shared<memory_featureset>(*this, query_index(q.get_bbox()), min_importance);
 }
 
 
@@ -134,7 +224,7 @@ featureset_ptr memory_datasource::features_at_point(coord2d const& pt, double to
     box2d<double> box = box2d<double>(pt.x, pt.y, pt.x, pt.y);
     box.pad(tol);
     MAPNIK_LOG_DEBUG(memory_datasource) << "memory_datasource: Box=" << box << ", Point x=" << pt.x << ",y=" << pt.y;
-    return std::make_shared<memory_featureset>(box,*this);
+    return std::make_shared<memory_featureset>(*this, query_index(box));
 }
 
 void memory_datasource::set_envelope(box2d<double> const& box)
@@ -173,6 +263,11 @@ size_t memory_datasource::size() const
 void memory_datasource::clear()
 {
     features_.clear();
+    importance_.clear();
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(tree_mutex_);
+#endif
+    tree_.reset();
 }
 
 }
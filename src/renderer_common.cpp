@@ -26,6 +26,7 @@
 #include <mapnik/request.hpp>
 #include <mapnik/attribute.hpp>
 #include <mapnik/safe_cast.hpp>
+#include <mapnik/renderer_common/transformed_geometry_cache.hpp>
 
 namespace mapnik {
 
@@ -40,7 +41,8 @@ renderer_common::renderer_common(renderer_common const& other)
       font_manager_(other.font_manager_),
       query_extent_(other.query_extent_),
       t_(other.t_),
-      detector_(other.detector_)
+      detector_(other.detector_),
+      geometry_cache_() // entries are only valid for the renderer that made them
 {}
 
 renderer_common::renderer_common(Map const& map, unsigned width, unsigned height, double scale_factor,
@@ -56,7 +58,8 @@ renderer_common::renderer_common(Map const& map, unsigned width, unsigned height
      font_manager_(font_library_,map.get_font_file_mapping(),map.get_font_memory_cache()),
      query_extent_(),
      t_(t),
-     detector_(detector)
+     detector_(detector),
+     geometry_cache_()
 {}
 
 renderer_common::renderer_common(Map const &m, attributes const& vars, unsigned offset_x, unsigned offset_y,
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include <mapnik/vertex_importance_cache.hpp>
+
+// stl
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mapnik {
+
+void vertex_importance_cache::push_back(geometry::geometry<double> const& geom)
+{
+    entry e;
+    e.importance = geometry::compute_vertex_importance(geom);
+    e.min_area = std::numeric_limits<double>::infinity();
+    for (double area : e.importance)
+    {
+        e.min_area = std::min(e.min_area, area);
+    }
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    entries_.push_back(std::move(e));
+}
+
+void vertex_importance_cache::clear()
+{
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    entries_.clear();
+}
+
+feature_ptr vertex_importance_cache::filtered(feature_ptr const& feature, std::size_t index, double min_area) const
+{
+    if (!(min_area > 0.0) || !std::isfinite(min_area)) return feature;
+    int band = std::ilogb(min_area);
+    double threshold = std::ldexp(1.0, band);
+    entry const* e = nullptr;
+    {
+#ifdef MAPNIK_THREADSAFE
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        if (index >= entries_.size()) return feature;
+        e = &entries_[index];
+        if (threshold <= e->min_area) return feature;
+        for (auto const& item : e->bands)
+        {
+            if (item.first == band) return item.second;
+        }
+    }
+    // thinned outside the lock, importance is never modified once added
+    feature_ptr result = std::make_shared<feature_impl>(feature->context(), feature->id());
+    result->set_data(feature->get_data());
+    result->set_geometry(geometry::filter_by_importance(feature->get_geometry(), e->importance, threshold));
+#ifdef MAPNIK_THREADSAFE
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif
+    for (auto const& item : e->bands)
+    {
+        // thinned concurrently by another query
+        if (item.first == band) return item.second;
+    }
+    e->bands.emplace_back(band, result);
+    return result;
+}
+
+}
@@ -89,7 +89,11 @@ public:
         // try to determine WKB format automatically
         if (format_ == wkbAuto)
         {
-            if (size_ >= 44
+            if (geopackage_header_size(wkb_, size_) > 0)
+            {
+                format_ = wkbGeoPackage;
+            }
+            else if (size_ >= 44
                 && static_cast<unsigned char>(wkb_[0]) == static_cast<unsigned char>(0x00)
                 && static_cast<unsigned char>(wkb_[38]) == static_cast<unsigned char>(0x7C)
                 && static_cast<unsigned char>(wkb_[size_ - 1]) == static_cast<unsigned char>(0xFE))
@@ -109,6 +113,23 @@ public:
             pos_ = 39;
             break;
 
+        case wkbGeoPackage:
+        {
+            std::size_t header = geopackage_header_size(wkb_, size_);
+            if (header == 0 || header >= size_)
+            {
+                // not a GeoPackage geometry, read() returns an empty geometry
+                byteOrder_ = wkbNDR;
+                pos_ = size_;
+            }
+            else
+            {
+                byteOrder_ = static_cast<wkbByteOrder>(wkb_[header]);
+                pos_ = header + 1;
+            }
+            break;
+        }
+
         case wkbGeneric:
         default:
             byteOrder_ = static_cast<wkbByteOrder>(wkb_[0]);
@@ -122,6 +143,7 @@ public:
     mapnik::geometry::geometry<double> read()
     {
         mapnik::geometry::geometry<double> geom = mapnik::geometry::geometry_empty();
+        if (pos_ + 4 > size_) return geom;
         int type = read_integer();
         switch (type)
         {
@@ -415,6 +437,20 @@ private:
 
 };
 
+std::size_t geopackage_header_size(char const* data, std::size_t size)
+{
+    // magic "GP", version, flags, srs_id
+    if (size < 8 || data[0] != 'G' || data[1] != 'P') return 0;
+    std::uint8_t flags = static_cast<std::uint8_t>(data[3]);
+    // bit 5 flags an extended (non standard WKB) geometry
+    if (flags & 0x20) return 0;
+    static const std::size_t envelope_sizes[] = { 0, 32, 48, 48, 64 };
+    std::uint8_t indicator = (flags >> 1) & 0x07;
+    if (indicator > 4) return 0;
+    std::size_t header = 8 + envelope_sizes[indicator];
+    return header <= size ? header : 0;
+}
+
 mapnik::geometry::geometry<double> geometry_utils::from_wkb(const char* wkb,
                                                             std::size_t size,
                                                             wkbFormat format)
@@ -0,0 +1,338 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+// mapnik
+#include <mapnik/wkb_view.hpp>
+#include <mapnik/global.hpp>
+#include <mapnik/vertex.hpp>
+
+// stl
+#include <cmath>
+#include <cstring>
+
+namespace mapnik {
+
+namespace {
+
+inline std::uint32_t read_uint32(char const* data, bool swap)
+{
+    std::int32_t n;
+    if (swap) read_int32_xdr(data, n);
+    else read_int32_ndr(data, n);
+    return static_cast<std::uint32_t>(n);
+}
+
+inline double read_double(char const* data, bool swap)
+{
+    double d;
+    if (swap) read_double_xdr(data, d);
+    else read_double_ndr(data, d);
+    return d;
+}
+
+// Splits a type word into its base type (1-7) and the size of a
+// coordinate tuple. ISO WKB encodes Z/M/ZM as +1000/+2000/+3000; any
+// other code (e.g. SpatiaLite compressed geometries 1000001+) is not
+// supported and, as in geometry_utils::from_wkb, yields no geometry.
+inline bool decode_type(std::uint32_t type, std::uint32_t & base, std::size_t & stride)
+{
+    std::uint32_t dims = type / 1000;
+    base = type % 1000;
+    if (dims > 3 || base < 1 || base > geometry::geometry_types::GeometryCollection) return false;
+    stride = 16 + (dims == 3 ? 16 : (dims > 0 ? 8 : 0));
+    return true;
+}
+
+}
+
+wkb_view::wkb_view(char const* wkb, std::size_t size, wkbFormat format)
+    : wkb_(wkb),
+      size_(size),
+      offset_(1),
+      format_(format),
+      need_swap_(false)
+{
+    // same heuristic as geometry_utils::from_wkb
+    if (format_ == wkbAuto)
+    {
+        if (geopackage_header_size(wkb_, size_) > 0)
+        {
+            format_ = wkbGeoPackage;
+        }
+        else if (size_ >= 44
+            && static_cast<unsigned char>(wkb_[0]) == static_cast<unsigned char>(0x00)
+            && static_cast<unsigned char>(wkb_[38]) == static_cast<unsigned char>(0x7C)
+            && static_cast<unsigned char>(wkb_[size_ - 1]) == static_cast<unsigned char>(0xFE))
+        {
+            format_ = wkbSpatiaLite;
+        }
+        else
+        {
+            format_ = wkbGeneric;
+        }
+    }
+    wkbByteOrder byte_order = wkbNDR;
+    if (format_ == wkbSpatiaLite)
+    {
+        if (size_ > 1) byte_order = static_cast<wkbByteOrder>(wkb_[1]);
+        offset_ = 39;
+    }
+    else if (format_ == wkbGeoPackage)
+    {
+        std::size_t header = geopackage_header_size(wkb_, size_);
+        if (header > 0 && header < size_)
+        {
+            byte_order = static_cast<wkbByteOrder>(wkb_[header]);
+            offset_ = header + 1;
+        }
+        else
+        {
+            offset_ = size_; // not valid()
+        }
+    }
+    else if (size_ > 0)
+    {
+        byte_order = static_cast<wkbByteOrder>(wkb_[0]);
+    }
+    need_swap_ = (byte_order == wkbXDR);
+}
+
+geometry::geometry_types wkb_view::type() const
+{
+    if (!valid()) return geometry::geometry_types::Unknown;
+    std::uint32_t type;
+    std::size_t stride;
+    if (!decode_type(read_uint32(wkb_ + offset_, need_swap_), type, stride))
+    {
+        return geometry::geometry_types::Unknown;
+    }
+    return static_cast<geometry::geometry_types>(type);
+}
+
+bool wkb_view::is_empty() const
+{
+    geometry::wkb_vertex_adapter va(*this);
+    double x, y;
+    return va.vertex(&x, &y) == SEG_END;
+}
+
+box2d<double> wkb_view::envelope() const
+{
+    box2d<double> bbox;
+    if (!valid()) return bbox;
+    if (format_ == wkbSpatiaLite)
+    {
+        // MbrMinX, MbrMinY, MbrMaxX, MbrMaxY follow the SRID
+        bbox.init(read_double(wkb_ + 6, need_swap_),
+                  read_double(wkb_ + 14, need_swap_),
+                  read_double(wkb_ + 22, need_swap_),
+                  read_double(wkb_ + 30, need_swap_));
+        return bbox;
+    }
+    if (format_ == wkbGeoPackage)
+    {
+        std::uint8_t flags = static_cast<std::uint8_t>(wkb_[3]);
+        // empty geometry flag
+        if (flags & 0x10) return bbox;
+        // an envelope is present unless the indicator is 0, it is stored
+        // as minx, maxx, miny, maxy in the header's own byte order
+        if (((flags >> 1) & 0x07) != 0)
+        {
+            bool header_ndr = (flags & 0x01) != 0;
+#ifdef MAPNIK_BIG_ENDIAN
+            bool native = !header_ndr;
+#else
+            bool native = header_ndr;
+#endif
+            double env[4];
+            if (native)
+            {
+                std::memcpy(env, wkb_ + 8, sizeof(env));
+            }
+            else
+            {
+                for (int i = 0; i < 4; ++i) env[i] = read_double(wkb_ + 8 + 8 * i, !header_ndr);
+            }
+            bbox.init(env[0], env[2], env[1], env[3]);
+            return bbox;
+        }
+    }
+    geometry::wkb_vertex_adapter va(*this);
+    double x, y;
+    bool first = true;
+    unsigned cmd;
+    while ((cmd = va.vertex(&x, &y)) != SEG_END)
+    {
+        if (cmd == SEG_CLOSE) continue;
+        if (first)
+        {
+            first = false;
+            bbox.init(x, y, x, y);
+        }
+        else
+        {
+            bbox.expand_to_include(x, y);
+        }
+    }
+    return bbox;
+}
+
+geometry::geometry<double> wkb_view::to_geometry() const
+{
+    return geometry_utils::from_wkb(wkb_, size_, format_);
+}
+
+namespace geometry {
+
+wkb_vertex_adapter::wkb_vertex_adapter(wkb_view const& view)
+    : view_(view),
+      type_(view.type())
+{
+    rewind(0);
+}
+
+void wkb_vertex_adapter::rewind(unsigned) const
+{
+    // every geometry header, including the top-level one, is
+    // preceded by a single byte (byte order or SpatiaLite marker)
+    pos_ = view_.offset() - 1;
+    pending_ = view_.valid() ? 1 : 0;
+    rings_left_ = 0;
+    points_left_ = 0;
+    stride_ = 16;
+    current_ = geometry_types::Unknown;
+    start_part_ = true;
+}
+
+geometry_types wkb_vertex_adapter::type() const
+{
+    return type_;
+}
+
+std::uint32_t wkb_vertex_adapter::read_uint32() const
+{
+    std::uint32_t n = mapnik::read_uint32(view_.data() + pos_, view_.need_swap());
+    pos_ += 4;
+    return n;
+}
+
+void wkb_vertex_adapter::read_xy(coordinate_type * x, coordinate_type * y) const
+{
+    char const* data = view_.data() + pos_;
+    *x = read_double(data, view_.need_swap());
+    *y = read_double(data + 8, view_.need_swap());
+    pos_ += stride_;
+}
+
+bool wkb_vertex_adapter::next_geometry() const
+{
+    std::size_t const size = view_.size();
+    while (pending_ > 0)
+    {
+        --pending_;
+        pos_ += 1;
+        if (pos_ + 4 > size) break;
+        std::uint32_t type;
+        if (!decode_type(read_uint32(), type, stride_)) break;
+        switch (type)
+        {
+        case geometry_types::Point:
+            current_ = geometry_types::Point;
+            points_left_ = 1;
+            return true;
+        case geometry_types::LineString:
+        case geometry_types::Polygon:
+            if (pos_ + 4 > size) break;
+            current_ = static_cast<geometry_types>(type);
+            if (current_ == geometry_types::Polygon) rings_left_ = read_uint32();
+            else points_left_ = read_uint32();
+            start_part_ = true;
+            return true;
+        case geometry_types::MultiPoint:
+        case geometry_types::MultiLineString:
+        case geometry_types::MultiPolygon:
+        case geometry_types::GeometryCollection:
+            // members are serialised depth-first right after the header
+            if (pos_ + 4 > size) break;
+            pending_ += read_uint32();
+            continue;
+        default:
+            break;
+        }
+        break;
+    }
+    pending_ = 0;
+    return false;
+}
+
+unsigned wkb_vertex_adapter::vertex(coordinate_type * x, coordinate_type * y) const
+{
+    std::size_t const size = view_.size();
+    for (;;)
+    {
+        if (points_left_ > 0)
+        {
+            if (pos_ + stride_ > size)
+            {
+                // truncated blob
+                points_left_ = rings_left_ = pending_ = 0;
+                return mapnik::SEG_END;
+            }
+            read_xy(x, y);
+            --points_left_;
+            if (current_ == geometry_types::Point)
+            {
+                // POINT EMPTY is encoded as NaN coordinates
+                if (std::isnan(*x) || std::isnan(*y)) continue;
+                return mapnik::SEG_MOVETO;
+            }
+            if (start_part_)
+            {
+                start_part_ = false;
+                return mapnik::SEG_MOVETO;
+            }
+            if (current_ == geometry_types::Polygon && points_left_ == 0)
+            {
+                *x = 0;
+                *y = 0;
+                return mapnik::SEG_CLOSE;
+            }
+            return mapnik::SEG_LINETO;
+        }
+        if (rings_left_ > 0)
+        {
+            if (pos_ + 4 > size)
+            {
+                rings_left_ = pending_ = 0;
+                return mapnik::SEG_END;
+            }
+            --rings_left_;
+            points_left_ = read_uint32();
+            start_part_ = true;
+            continue;
+        }
+        if (!next_geometry()) return mapnik::SEG_END;
+    }
+}
+
+} // namespace geometry
+} // namespace mapnik
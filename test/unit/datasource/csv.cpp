@@ -27,6 +27,7 @@
 #include <mapnik/unicode.hpp>
 #include <mapnik/datasource.hpp>
 #include <mapnik/datasource_cache.hpp>
+#include <mapnik/feature_cache.hpp>
 #include <mapnik/geometry.hpp>
 #include <mapnik/geometry/geometry_types.hpp>
 #include <mapnik/geometry/geometry_type.hpp>
@@ -477,6 +478,67 @@ TEST_CASE("csv") {
             }
         } // END SECTION
 
+        SECTION("feature cache")
+        {
+            std::string filename = "test/data/csv/wkt.csv";
+            // cleanup in the case of a failed previous run
+            for (auto const& ext : {".index", ".fcache"})
+            {
+                if (mapnik::util::exists(filename + ext)) mapnik::util::remove(filename + ext);
+            }
+            int ret = create_disk_index(filename, true, "--cache");
+            int ret_posix = (ret >> 8) & 0x000000ff;
+            INFO(ret);
+            INFO(ret_posix);
+            REQUIRE(mapnik::util::exists(filename + ".fcache"));
+
+            using mapnik::geometry::geometry_types;
+            auto ds = get_csv_ds(filename, false);
+            auto fields = ds->get_descriptor().get_descriptors();
+            require_field_names(fields, {"type"});
+            require_field_types(fields, {mapnik::String});
+            CHECK(ds->envelope().valid());
+
+            auto featureset = all_features(ds);
+            require_geometry(featureset->next(), 1, geometry_types::Point);
+            require_geometry(featureset->next(), 1, geometry_types::LineString);
+            require_geometry(featureset->next(), 1, geometry_types::Polygon);
+            require_geometry(featureset->next(), 1, geometry_types::Polygon);
+            require_geometry(featureset->next(), 4, geometry_types::MultiPoint);
+            require_geometry(featureset->next(), 2, geometry_types::MultiLineString);
+            require_geometry(featureset->next(), 2, geometry_types::MultiPolygon);
+            require_geometry(featureset->next(), 2, geometry_types::MultiPolygon);
+            CHECK(!featureset->next());
+
+            // queries are validated against the cached columns
+            mapnik::query q(ds->envelope());
+            q.add_property_name("missing");
+            CHECK_THROWS(ds->features(q));
+
+            // not used with options the cache can't honour
+            mapnik::parameters csv_params;
+            csv_params["type"] = std::string("csv");
+            csv_params["file"] = filename;
+            csv_params["row_limit"] = mapnik::value_integer(2);
+            auto limited_ds = mapnik::datasource_cache::instance().create(csv_params);
+            REQUIRE(bool(limited_ds));
+            auto limited_count = count_features(all_features(limited_ds));
+            CHECK(limited_count > 0);
+            CHECK(limited_count <= 2);
+            CHECK(count_features(all_features(get_csv_ds(filename, true))) == 8);
+
+            // only used with the parse options it was written with
+            mapnik::parameters params;
+            params["file"] = filename;
+            CHECK(mapnik::feature_cache::open(filename, params) != nullptr);
+            params["separator"] = "|";
+            CHECK(mapnik::feature_cache::open(filename, params) == nullptr);
+            for (auto const& ext : {".index", ".fcache"})
+            {
+                if (mapnik::util::exists(filename + ext)) mapnik::util::remove(filename + ext);
+            }
+        } // END SECTION
+
         SECTION("handling of missing header")
         {
             for (auto create_index : { false, true })
@@ -1068,6 +1130,42 @@ MAPNIK_DISABLE_WARNING_POP
             auto feat = fs->next();
             CHECK(feature_count(feat->get_geometry()) == 1);
         } // END SECTION
+
+        SECTION("large input is parsed in parallel blocks") {
+            // big enough to be split into several blocks, with quoted
+            // newlines and a bogus row along the way
+            std::size_t const num_rows = 600000;
+            std::string csv_string("x,y,name\n");
+            for (std::size_t i = 0; i < num_rows; ++i)
+            {
+                csv_string += std::to_string(i % 1000) + "," + std::to_string(i / 1000) + ",";
+                if (i % 1000 == 0) csv_string += "\"n" + std::to_string(i) + "\nline\"\n";
+                else csv_string += "n" + std::to_string(i) + "\n";
+                if (i == 12345) csv_string += "bogus,row,\n";
+            }
+            mapnik::parameters params;
+            params["type"] = std::string("csv");
+            params["inline"] = csv_string;
+            auto ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(bool(ds));
+            CHECK(ds->envelope() == mapnik::box2d<double>(0, 0, 999, (num_rows - 1) / 1000));
+            CHECK(count_features(all_features(ds)) == num_rows);
+
+            mapnik::query q(mapnik::box2d<double>(4.5, 122.5, 5.5, 123.5));
+            q.add_property_name("name");
+            auto fs = ds->features(q);
+            auto feature = fs->next();
+            REQUIRE(bool(feature));
+            CHECK(feature->get("name").to_string() == "n123005");
+            CHECK(!fs->next());
+
+            mapnik::query q2(mapnik::box2d<double>(-0.5, 299.5, 0.5, 300.5));
+            q2.add_property_name("name");
+            fs = ds->features(q2);
+            feature = fs->next();
+            REQUIRE(bool(feature));
+            CHECK(feature->get("name").to_string() == "n300000\nline");
+        } // END SECTION
         mapnik::logger::instance().set_severity(severity);
     }
 } // END TEST CASE
@@ -0,0 +1,174 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include <mapnik/csv/csv_grammar_x3_def.hpp>
+#include "../../../plugins/input/csv/csv_getline.hpp"
+#include "../../../plugins/input/csv/csv_scanner.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// reference: the x3 grammar used by csv_utils::parse_line
+mapnik::csv_line parse_with_grammar(std::string const& row, char separator, char quote)
+{
+    namespace x3 = boost::spirit::x3;
+    auto parser = x3::with<mapnik::grammar::quote_tag>(quote)
+        [ x3::with<mapnik::grammar::separator_tag>(separator)
+          [ mapnik::grammar::line ]
+            ];
+    mapnik::csv_line values;
+    char const* first = row.data();
+    char const* last = first + row.size();
+    REQUIRE(x3::phrase_parse(first, last, parser, mapnik::csv_white_space, values));
+    return values;
+}
+
+// reference: rows as read by csv_utils::getline_csv
+std::vector<std::string> rows_with_getline(std::string const& data, char newline, char quote)
+{
+    std::vector<std::string> rows;
+    std::istringstream stream(data);
+    std::string row;
+    while (csv_utils::getline_csv(stream, row, newline, quote))
+    {
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+std::vector<std::string> rows_with_scanner(std::string const& data, char newline, char quote)
+{
+    std::vector<std::string> rows;
+    char const* first = data.data();
+    char const* last = first + data.size();
+    bool quoted = false;
+    while (first != last)
+    {
+        char const* row_end = csv_utils::find_row_end(first, last, newline, quote, quoted);
+        rows.emplace_back(first, row_end);
+        if (row_end == last) break;
+        first = row_end + 1;
+    }
+    return rows;
+}
+
+// checks both row splitting and field splitting against the reference
+void check_same_as_grammar(std::string const& data, char separator, char quote)
+{
+    std::vector<std::string> rows = rows_with_scanner(data, '\n', quote);
+    CHECK(rows == rows_with_getline(data, '\n', quote));
+    for (auto const& row : rows)
+    {
+        INFO("row: " << row);
+        mapnik::csv_line values;
+        char const* first = row.data();
+        if (csv_utils::split_unquoted_row(first, first + row.size(), separator, quote, values))
+        {
+            CHECK(row.find(quote) == std::string::npos);
+            CHECK(values == parse_with_grammar(row, separator, quote));
+        }
+        else
+        {
+            CHECK(values.empty());
+        }
+    }
+}
+
+}
+
+TEST_CASE("csv scanner") {
+
+SECTION("find_either") {
+    // put the match at every offset across the 8 and 16 byte blocks
+    for (std::size_t pos = 0; pos < 40; ++pos)
+    {
+        std::string data(48, 'x');
+        data[pos] = ';';
+        char const* first = data.data();
+        char const* last = first + data.size();
+        CHECK(csv_utils::find_either(first, last, ',', ';') == first + pos);
+        CHECK(csv_utils::find_either(first, first + pos, ',', ';') == first + pos);
+    }
+    std::string none(33, 'x');
+    CHECK(csv_utils::find_either(none.data(), none.data() + none.size(), ',', ';') == none.data() + none.size());
+}
+
+SECTION("quoted separators and newlines") {
+    check_same_as_grammar("x,y,name\n"
+                          "0,0,\"a,b\"\n"
+                          "1,1,\"multi\nline, with separator\"\n"
+                          "2,2,\"escaped \"\"quote\"\"\"\n"
+                          "3,3,plain\n", ',', '"');
+    check_same_as_grammar("x|y|name\n0|0|'a|b'\n1|1|c\n", '|', '\'');
+}
+
+SECTION("CRLF") {
+    check_same_as_grammar("x,y,name\r\n"
+                          "0,0,\"a,\r\nb\"\r\n"
+                          "1,1,  leading blanks\r\n"
+                          "\r\n"
+                          "2,2,last\r\n", ',', '"');
+}
+
+SECTION("trailing row without newline") {
+    check_same_as_grammar("x,y\n0,0\n1,1", ',', '"');
+    check_same_as_grammar("x,y\n0,0\n\"1\",\"1\"", ',', '"');
+    check_same_as_grammar("x,y\r\n0,0\r\n1,1", ',', '"');
+}
+
+SECTION("long rows") {
+    // fields long enough to cross the vectorised blocks at every alignment
+    std::string data;
+    for (std::size_t i = 0; i < 40; ++i)
+    {
+        data += std::string(i, 'a') + "," + std::string(40 - i, 'b') + ", " + std::to_string(i);
+        if (i % 3 == 0) data += ",\"" + std::string(i, 'c') + ",\n\"";
+        data += (i % 2 == 0) ? "\n" : "\r\n";
+    }
+    check_same_as_grammar(data, ',', '"');
+}
+
+SECTION("quote state carried across buffers") {
+    std::string const data = "0,\"a\nb\",c\n1,d\n";
+    std::size_t const expected = data.find("c\n") + 1;
+    for (std::size_t split = 0; split <= expected; ++split)
+    {
+        char const* first = data.data();
+        char const* middle = first + split;
+        char const* last = first + data.size();
+        bool quoted = false;
+        char const* row_end = csv_utils::find_row_end(first, middle, '\n', '"', quoted);
+        if (row_end == middle)
+        {
+            row_end = csv_utils::find_row_end(middle, last, '\n', '"', quoted);
+        }
+        CHECK(row_end == first + expected);
+        CHECK(!quoted);
+    }
+}
+
+}
@@ -192,14 +192,14 @@ inline void require_geometry(mapnik::feature_ptr feature,
     CHECK(feature_count(feature->get_geometry()) == num_parts);
 }
 
-inline int create_disk_index(std::string const& filename, bool silent = true)
+inline int create_disk_index(std::string const& filename, bool silent = true, std::string const& options = "")
 {
     std::string cmd;
     if (std::getenv("DYLD_LIBRARY_PATH") != nullptr)
     {
         cmd += std::string("DYLD_LIBRARY_PATH=") + std::getenv("DYLD_LIBRARY_PATH") + " ";
     }
-    cmd += "mapnik-index " + filename;
+    cmd += "mapnik-index " + (options.empty() ? "" : options + " ") + filename;
     if (silent)
     {
 #ifndef _WINDOWS
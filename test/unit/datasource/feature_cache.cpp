@@ -0,0 +1,112 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/unicode.hpp>
+#include <mapnik/value.hpp>
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::shared_ptr<std::string> write_cache(mapnik::feature_cache_source const& source)
+{
+    mapnik::layer_descriptor desc("test", "utf-8");
+    desc.add_descriptor(mapnik::attribute_descriptor("name", mapnik::String));
+    mapnik::feature_cache_writer writer(desc, boost::optional<mapnik::datasource_geometry_t>());
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, 1));
+    feature->put_new("name", mapnik::value_unicode_string("first"));
+    feature->set_geometry(mapnik::geometry::point<double>(1, 2));
+    writer.add(*feature);
+    std::ostringstream out;
+    writer.write(out, source);
+    return std::make_shared<std::string>(out.str());
+}
+
+std::shared_ptr<mapnik::feature_cache> load_cache(std::shared_ptr<std::string> const& data)
+{
+    return std::make_shared<mapnik::feature_cache>(data, data->data(), data->size());
+}
+
+}
+
+TEST_CASE("feature cache") {
+
+SECTION("round trip") {
+    mapnik::feature_cache_source source;
+    source.size = 1234;
+    source.mtime = 1600000000;
+    source.options = "separator=;\n";
+    auto cache = load_cache(write_cache(source));
+    CHECK(cache->source() == source);
+    CHECK(cache->size() == 1);
+    auto features = cache->features(mapnik::query(mapnik::box2d<double>(0, 0, 10, 10)));
+    auto feature = features->next();
+    REQUIRE(feature);
+    CHECK(feature->id() == 1);
+    CHECK(feature->get("name").to_string() == "first");
+    CHECK(!features->next());
+}
+
+SECTION("source identity") {
+    mapnik::feature_cache_source source;
+    source.size = 10;
+    source.mtime = 20;
+    mapnik::feature_cache_source other = source;
+    CHECK(source == other);
+    other.mtime = 21;
+    CHECK(!(source == other));
+    other = source;
+    other.options = "quote='\n";
+    CHECK(!(source == other));
+}
+
+SECTION("unknown value tag is a corrupt record") {
+    auto data = write_cache(mapnik::feature_cache_source());
+    std::uint64_t features_offset;
+    std::memcpy(&features_offset, data->data() + 112, 8);
+    std::uint32_t wkb_size;
+    std::memcpy(&wkb_size, data->data() + features_offset, 4);
+    // wkb size, wkb, number of attributes, column index, then the tag
+    std::size_t tag_pos = features_offset + 4 + wkb_size + 4 + 4;
+    REQUIRE((*data)[tag_pos] == 4); // string
+    (*data)[tag_pos] = 42;
+    auto cache = load_cache(data);
+    auto features = cache->features(mapnik::query(mapnik::box2d<double>(0, 0, 10, 10)));
+    CHECK_THROWS(features->next());
+}
+
+SECTION("byte order is checked") {
+    auto data = write_cache(mapnik::feature_cache_source());
+    std::swap((*data)[136], (*data)[139]);
+    CHECK_THROWS(load_cache(data));
+}
+
+}
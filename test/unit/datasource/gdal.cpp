@@ -86,4 +86,36 @@ TEST_CASE("gdal") {
         CHECK(raster->data_.height() == 256);
     }
 
+    SECTION("concurrent featuresets")
+    {
+        std::string dataset = "test/data/tiff/ndvi_256x256_gray32f_tiled.tif";
+        mapnik::datasource_ptr ds = get_gdal_ds(dataset, 1);
+
+        if (!ds)
+        {
+            // GDAL plugin not built.
+            return;
+        }
+
+        mapnik::box2d<double> envelope = ds->envelope();
+        mapnik::query::resolution_type resolution(1.0, 1.0);
+        mapnik::query query(envelope, resolution, 1.0);
+
+        // each featureset holds a dataset handle of its own
+        auto features1 = ds->features(query);
+        auto features2 = ds->features(query);
+        auto feature2 = features2->next();
+        auto feature1 = features1->next();
+        REQUIRE(feature1 != nullptr);
+        REQUIRE(feature2 != nullptr);
+
+        mapnik::raster_ptr raster1 = feature1->get_raster();
+        mapnik::raster_ptr raster2 = feature2->get_raster();
+        REQUIRE(raster1 != nullptr);
+        REQUIRE(raster2 != nullptr);
+        CHECK(raster1->data_.width() == raster2->data_.width());
+        CHECK(raster1->data_.height() == raster2->data_.height());
+        CHECK(raster1->ext_ == raster2->ext_);
+    }
+
 } // END TEST CASE
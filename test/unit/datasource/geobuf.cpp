@@ -30,11 +30,146 @@
 #include <mapnik/geometry/geometry_type.hpp>
 #include <mapnik/util/fs.hpp>
 #include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
 #include <algorithm>
 #include <cctype>
 #include <locale>
 #include <boost/optional/optional_io.hpp>
 
+namespace {
+
+// minimal protobuf writer for generated geobuf fixtures
+void write_varint(std::string & out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+void write_uint(std::string & out, unsigned tag, std::uint64_t value)
+{
+    write_varint(out, (tag << 3) | 0);
+    write_varint(out, value);
+}
+
+void write_bytes(std::string & out, unsigned tag, std::string const& bytes)
+{
+    write_varint(out, (tag << 3) | 2);
+    write_varint(out, bytes.size());
+    out += bytes;
+}
+
+// FeatureCollection of points and two vertex line strings on a 50 x n
+// grid of one degree cells, each with an int id, a name and a rank
+std::string make_feature_collection(std::size_t count)
+{
+    std::string collection;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        bool const line = (i % 3 == 0);
+        std::string coords;
+        write_varint(coords, zigzag(static_cast<std::int64_t>(i % 50) * 1000000 - 25000000));
+        write_varint(coords, zigzag(static_cast<std::int64_t>(i / 50) * 1000000 - 5000000));
+        if (line)
+        {
+            // delta encoded
+            write_varint(coords, zigzag(500000));
+            write_varint(coords, zigzag(250000));
+        }
+        std::string geometry;
+        write_uint(geometry, 1, line ? 2 : 0);
+        write_bytes(geometry, 3, coords);
+        std::string name, rank, props;
+        write_bytes(name, 1, "f" + std::to_string(i));
+        write_uint(rank, 3, i);
+        for (unsigned index : {0u, 0u, 1u, 1u}) write_varint(props, index);
+        std::string feature;
+        write_bytes(feature, 1, geometry);
+        write_varint(feature, (12 << 3) | 0);
+        write_varint(feature, zigzag(static_cast<std::int64_t>(i + 1)));
+        write_bytes(feature, 13, name);
+        write_bytes(feature, 13, rank);
+        write_bytes(feature, 14, props);
+        write_bytes(collection, 1, feature);
+    }
+    std::string data;
+    write_bytes(data, 1, "name");
+    write_bytes(data, 1, "rank");
+    write_bytes(data, 4, collection);
+    return data;
+}
+
+// Opens `filename` with and without lazy_features and checks that both
+// return the same features (ids, envelopes and attributes) in the same
+// order, for the whole extent and for each of `boxes`. Returns the number
+// of features in the extent.
+std::size_t check_lazy_features(std::string const& filename, std::vector<mapnik::box2d<double>> const& boxes = {})
+{
+    mapnik::parameters params;
+    params["type"] = "geobuf";
+    params["file"] = filename;
+    auto eager_ds = mapnik::datasource_cache::instance().create(params);
+    params["lazy_features"] = true;
+    auto lazy_ds = mapnik::datasource_cache::instance().create(params);
+    REQUIRE(bool(eager_ds));
+    REQUIRE(bool(lazy_ds));
+    CHECK(lazy_ds->envelope() == eager_ds->envelope());
+    CHECK(lazy_ds->get_geometry_type() == eager_ds->get_geometry_type());
+    auto fields = eager_ds->get_descriptor().get_descriptors();
+    auto lazy_fields = lazy_ds->get_descriptor().get_descriptors();
+    REQUIRE(lazy_fields.size() == fields.size());
+    for (std::size_t i = 0; i < fields.size(); ++i)
+    {
+        CHECK(lazy_fields[i].get_name() == fields[i].get_name());
+        CHECK(lazy_fields[i].get_type() == fields[i].get_type());
+    }
+    std::vector<mapnik::box2d<double>> queries{eager_ds->envelope()};
+    queries.insert(queries.end(), boxes.begin(), boxes.end());
+    std::size_t total = 0;
+    for (auto const& box : queries)
+    {
+        INFO(box);
+        mapnik::query q(box);
+        for (auto const& field : fields)
+        {
+            q.add_property_name(field.get_name());
+        }
+        auto fs = lazy_ds->features(q);
+        auto expected = eager_ds->features(q);
+        std::size_t count = 0;
+        for (auto f = fs->next(); f != nullptr; f = fs->next())
+        {
+            auto expected_feature = expected->next();
+            REQUIRE(bool(expected_feature));
+            CHECK(f->id() == expected_feature->id());
+            CHECK(f->envelope() == expected_feature->envelope());
+            for (auto const& field : fields)
+            {
+                auto const& name = field.get_name();
+                CHECK(f->get(name) == expected_feature->get(name));
+            }
+            ++count;
+        }
+        CHECK(!expected->next());
+        if (total == 0) total = count;
+    }
+    return total;
+}
+
+} // anonymous ns
+
 
 TEST_CASE("Geobuf") {
 
@@ -250,5 +385,38 @@ TEST_CASE("Geobuf") {
             REQUIRE(line[1].y == 1);
             CHECK(fs->next() == nullptr);
         }
+
+        SECTION("lazy_features decodes features on demand")
+        {
+            for (auto filename : {
+                    "./test/data/geobuf/point.geobuf",
+                    "./test/data/geobuf/multipoint.geobuf",
+                    "./test/data/geobuf/linestring.geobuf",
+                    "./test/data/geobuf/multilinestring.geobuf",
+                    "./test/data/geobuf/polygon.geobuf",
+                    "./test/data/geobuf/multipolygon.geobuf",
+                    "./test/data/geobuf/geometrycollection.geobuf",
+                    "./test/data/geobuf/standalone-feature.geobuf",
+                    "./test/data/geobuf/standalone-geometry.geobuf"})
+            {
+                INFO(filename);
+                CHECK(check_lazy_features(filename) == 1);
+            }
+        }
+
+        SECTION("lazy_features with many features")
+        {
+            std::string const filename("./mapnik-tmp-geobuf-test.geobuf");
+            {
+                std::ofstream out(filename.c_str(), std::ios::binary);
+                out << make_feature_collection(1000);
+            }
+            CHECK(check_lazy_features(filename, {
+                        mapnik::box2d<double>(-10, -3, 10, 3),
+                        mapnik::box2d<double>(-25, -5, -23.5, -4),
+                        mapnik::box2d<double>(0.2, 0.1, 0.3, 0.2),
+                        mapnik::box2d<double>(100, 100, 101, 101)}) == 1000);
+            std::remove(filename.c_str());
+        }
     }
 }
@@ -553,6 +553,122 @@ TEST_CASE("geojson") {
             }
         }
 
+        SECTION("GeoJSON lazy_features parses features on demand")
+        {
+            std::string filename("./test/data/json/featurecollection.json");
+            mapnik::parameters params;
+            params["type"] = "geojson";
+            params["file"] = filename;
+            params["cache_features"] = true;
+            auto cached_ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(bool(cached_ds));
+
+            for (mapnik::value_integer cache_size : {0, 1, 1024})
+            {
+                params["lazy_features"] = true;
+                params["feature_cache_size"] = cache_size;
+                auto ds = mapnik::datasource_cache::instance().create(params);
+                REQUIRE(bool(ds));
+                CHECK(ds->envelope() == cached_ds->envelope());
+                CHECK(ds->get_geometry_type() == cached_ds->get_geometry_type());
+                auto fields = ds->get_descriptor().get_descriptors();
+                REQUIRE(fields.size() == cached_ds->get_descriptor().get_descriptors().size());
+                mapnik::query query(ds->envelope());
+                for (auto const& field : fields)
+                {
+                    query.add_property_name(field.get_name());
+                }
+                // second pass is served (at least partially) from the cache
+                for (int pass = 0; pass < 2; ++pass)
+                {
+                    auto features = ds->features(query);
+                    auto expected = cached_ds->features(query);
+                    std::size_t count = 0;
+                    for (auto feature = features->next(); feature != nullptr; feature = features->next())
+                    {
+                        auto expected_feature = expected->next();
+                        REQUIRE(bool(expected_feature));
+                        CHECK(feature->id() == expected_feature->id());
+                        CHECK(feature->envelope() == expected_feature->envelope());
+                        for (auto const& field : fields)
+                        {
+                            auto const& name = field.get_name();
+                            CHECK(feature->get(name) == expected_feature->get(name));
+                        }
+                        ++count;
+                    }
+                    CHECK(!expected->next());
+                    CHECK(count == 3);
+                }
+                auto point_features = ds->features_at_point(ds->envelope().center(), 10);
+                CHECK(count_features(point_features) == 3);
+            }
+        }
+
+        SECTION("GeoJSON feature cache")
+        {
+            std::string filename("./test/data/json/featurecollection.json");
+            std::string const cache_filename = filename + ".fcache";
+            // cleanup in the case of a failed previous run
+            for (auto const& ext : {".index", ".fcache"})
+            {
+                if (mapnik::util::exists(filename + ext)) mapnik::util::remove(filename + ext);
+            }
+            mapnik::parameters params;
+            params["type"] = "geojson";
+            params["file"] = filename;
+            auto expected_ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(bool(expected_ds));
+            auto expected_fields = expected_ds->get_descriptor().get_descriptors();
+            mapnik::query query(expected_ds->envelope());
+            for (auto const& field : expected_fields)
+            {
+                query.add_property_name(field.get_name());
+            }
+            std::vector<mapnik::feature_ptr> expected;
+            auto expected_features = expected_ds->features(query);
+            for (auto feature = expected_features->next(); feature; feature = expected_features->next())
+            {
+                expected.push_back(feature);
+            }
+
+            int ret = create_disk_index(filename, true, "--cache");
+            int ret_posix = (ret >> 8) & 0x000000ff;
+            INFO(ret);
+            INFO(ret_posix);
+            REQUIRE(mapnik::util::exists(cache_filename));
+
+            auto ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(bool(ds));
+            CHECK(ds->envelope() == expected_ds->envelope());
+            CHECK(ds->get_geometry_type() == expected_ds->get_geometry_type());
+            auto fields = ds->get_descriptor().get_descriptors();
+            REQUIRE(fields.size() == expected_fields.size());
+            for (std::size_t i = 0; i < fields.size(); ++i)
+            {
+                CHECK(fields[i].get_name() == expected_fields[i].get_name());
+                CHECK(fields[i].get_type() == expected_fields[i].get_type());
+            }
+            auto features = ds->features(query);
+            std::size_t count = 0;
+            for (auto feature = features->next(); feature; feature = features->next(), ++count)
+            {
+                REQUIRE(count < expected.size());
+                CHECK(feature->id() == expected[count]->id());
+                CHECK(feature->envelope() == expected[count]->envelope());
+                for (auto const& field : fields)
+                {
+                    CHECK(feature->get(field.get_name()) == expected[count]->get(field.get_name()));
+                }
+            }
+            CHECK(count == expected.size());
+
+            for (auto const& ext : {".index", ".fcache"})
+            {
+                if (mapnik::util::exists(filename + ext)) mapnik::util::remove(filename + ext);
+            }
+        }
+
         SECTION("GeoJSON extra properties")
         {
             // Create datasource
@@ -956,5 +1072,57 @@ TEST_CASE("geojson") {
                 }
             }
         }
+
+        SECTION("GeoJSON large FeatureCollection is parsed in parallel")
+        {
+            std::size_t const num_features = 20000;
+            std::string json = "{\"type\":\"FeatureCollection\",\"features\":[";
+            for (std::size_t i = 0; i < num_features; ++i)
+            {
+                if (i > 0) json += ",";
+                json += "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":["
+                    + std::to_string(i % 200) + "," + std::to_string(i / 200) + "]},"
+                    + "\"properties\":{\"index\":" + std::to_string(i) + ",\"name\":\"feature " + std::to_string(i) + "\""
+                    + (i >= 15000 ? ",\"late\":true" : "") + "}}";
+            }
+            json += "]}";
+
+            mapnik::parameters params;
+            params["type"] = "geojson";
+            params["inline"] = json;
+            auto ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(bool(ds));
+            CHECK(ds->envelope() == mapnik::box2d<double>(0, 0, 199, 99));
+
+            mapnik::query query(ds->envelope());
+            query.add_property_name("index");
+            query.add_property_name("name");
+            auto features = ds->features(query);
+            mapnik::value_integer count = 0;
+            mapnik::context_ptr ctx;
+            for (auto feature = features->next(); feature != nullptr; feature = features->next())
+            {
+                // all features share one schema, whichever worker parsed them
+                if (!ctx) ctx = feature->context();
+                REQUIRE(feature->context() == ctx);
+                REQUIRE(feature->has_key("late"));
+                REQUIRE(feature->get("late").is_null() == (count < 15000));
+                // ids and attributes follow input order
+                REQUIRE(feature->id() == ++count);
+                REQUIRE(feature->get("index").get<mapnik::value_integer>() == count - 1);
+                REQUIRE(feature->get("name").to_string() == "feature " + std::to_string(count - 1));
+            }
+            CHECK(count == static_cast<mapnik::value_integer>(num_features));
+
+            mapnik::query small_query(mapnik::box2d<double>(10.5, 10.5, 12.5, 11.5));
+            CHECK(count_features(ds->features(small_query)) == 2);
+
+            // a malformed feature anywhere in the collection fails the whole datasource
+            std::string broken = json;
+            std::string const marker = "\"index\":15000,";
+            broken.replace(broken.find(marker), marker.size(), "\"index\":15000,,");
+            params["inline"] = broken;
+            CHECK_THROWS(mapnik::datasource_cache::instance().create(params));
+        }
     }
 }
@@ -27,6 +27,9 @@
 #include <mapnik/datasource.hpp>
 #include <mapnik/memory_datasource.hpp>
 #include <mapnik/datasource_cache.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/query.hpp>
 
 
 TEST_CASE("memory datasource") {
@@ -43,4 +46,53 @@ TEST_CASE("memory datasource") {
             CHECK(false); // shouldn't get here
         }
     }
+
+    SECTION("spatial index")
+    {
+        mapnik::parameters params;
+        auto ds = std::make_shared<mapnik::memory_datasource>(params);
+        auto ctx = std::make_shared<mapnik::context_type>();
+        auto push_point = [&](mapnik::value_integer id, double x, double y)
+        {
+            auto feature = mapnik::feature_factory::create(ctx, id);
+            feature->set_geometry(mapnik::geometry::point<double>(x, y));
+            ds->push(feature);
+        };
+        mapnik::value_integer id = 0;
+        for (int y = 0; y < 100; ++y)
+        {
+            for (int x = 0; x < 100; ++x)
+            {
+                push_point(++id, x, y);
+            }
+        }
+        auto query_ids = [&](mapnik::box2d<double> const& box)
+        {
+            std::vector<mapnik::value_integer> ids;
+            auto fs = ds->features(mapnik::query(box));
+            for (auto f = fs->next(); f; f = fs->next()) ids.push_back(f->id());
+            return ids;
+        };
+        // features are returned in push order
+        auto ids = query_ids(mapnik::box2d<double>(10, 20, 12, 21));
+        REQUIRE(ids == std::vector<mapnik::value_integer>({2011, 2012, 2013, 2111, 2112, 2113}));
+        CHECK(query_ids(mapnik::box2d<double>(-10, -10, -1, -1)).empty());
+        CHECK(query_ids(ds->envelope()).size() == 10000);
+
+        // features pushed after the index was built are found
+        push_point(++id, 10.5, 20.5);
+        ids = query_ids(mapnik::box2d<double>(10, 20, 12, 21));
+        CHECK(ids.size() == 7);
+        CHECK(ids.back() == id);
+
+        auto fs = ds->features_at_point(mapnik::coord2d(50.1, 50.1), 0.2);
+        auto f = fs->next();
+        REQUIRE(f);
+        CHECK(f->id() == 50 * 100 + 51);
+        CHECK(!fs->next());
+
+        ds->clear();
+        push_point(1, 1, 1);
+        CHECK(query_ids(mapnik::box2d<double>(0, 0, 2, 2)).size() == 1);
+    }
 }
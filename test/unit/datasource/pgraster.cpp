@@ -0,0 +1,100 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include <mapnik/raster.hpp>
+#include <mapnik/image.hpp>
+#include "../../../plugins/input/pgraster/pgraster_raster_cache.hpp"
+
+namespace {
+
+// 1x1 extent with its lower left corner at (minx, miny)
+mapnik::raster_ptr make_raster(double minx, double miny)
+{
+    mapnik::box2d<double> ext(minx, miny, minx + 1, miny + 1);
+    return std::make_shared<mapnik::raster>(ext, ext, mapnik::image_gray8(4, 4), 1.0);
+}
+
+}
+
+TEST_CASE("pgraster raster cache") {
+
+    SECTION("hit")
+    {
+        pgraster_raster_cache cache(4);
+        cache.insert("public.t", 1, *make_raster(0, 0));
+        cache.insert("public.t", 2, *make_raster(5, 5));
+        cache.insert("public.o_2_t", 1, *make_raster(0, 0));
+        CHECK(cache.size() == 3);
+
+        auto hits = cache.find("public.t", mapnik::box2d<double>(-1, -1, 2, 2));
+        REQUIRE(hits.size() == 1);
+        CHECK(hits.begin()->first == 1);
+        CHECK(hits.begin()->second->ext_ == mapnik::box2d<double>(0, 0, 1, 1));
+        // lookups share the cached instance
+        auto again = cache.find("public.t", mapnik::box2d<double>(-1, -1, 2, 2));
+        CHECK(again.begin()->second == hits.begin()->second);
+        // a feature gets its own copy
+        mapnik::raster_ptr copy = pgraster_raster_cache::clone(*hits.begin()->second);
+        CHECK(copy.get() != hits.begin()->second.get());
+        CHECK(copy->ext_ == hits.begin()->second->ext_);
+        CHECK(copy->data_.width() == 4);
+
+        CHECK(cache.find("public.t", mapnik::box2d<double>(-1, -1, 10, 10)).size() == 2);
+        CHECK(cache.find("public.missing", mapnik::box2d<double>(-1, -1, 10, 10)).empty());
+        // entries of other tables are separate
+        CHECK(cache.find("public.o_2_t", mapnik::box2d<double>(-1, -1, 10, 10)).size() == 1);
+    }
+
+    SECTION("eviction")
+    {
+        pgraster_raster_cache cache(2);
+        cache.insert("t", 1, *make_raster(0, 0));
+        cache.insert("t", 2, *make_raster(2, 2));
+        // a lookup makes 1 the most recently used entry
+        CHECK(cache.find("t", mapnik::box2d<double>(0, 0, 0.5, 0.5)).size() == 1);
+        cache.insert("t", 3, *make_raster(4, 4));
+        CHECK(cache.size() == 2);
+        auto hits = cache.find("t", mapnik::box2d<double>(-1, -1, 10, 10));
+        REQUIRE(hits.size() == 2);
+        CHECK(hits.count(1) == 1);
+        CHECK(hits.count(2) == 0);
+        CHECK(hits.count(3) == 1);
+
+        // replacing an entry does not grow the cache
+        cache.insert("t", 3, *make_raster(6, 6));
+        CHECK(cache.size() == 2);
+        CHECK(cache.find("t", mapnik::box2d<double>(5.5, 5.5, 10, 10)).size() == 1);
+
+        cache.clear();
+        CHECK(cache.size() == 0);
+        CHECK(cache.find("t", mapnik::box2d<double>(-1, -1, 10, 10)).empty());
+    }
+
+    SECTION("disabled")
+    {
+        pgraster_raster_cache cache(0);
+        cache.insert("t", 1, *make_raster(0, 0));
+        CHECK(cache.size() == 0);
+    }
+}
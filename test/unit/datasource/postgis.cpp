@@ -28,7 +28,9 @@
 #include <mapnik/geometry/geometry_type.hpp>
 #include <mapnik/unicode.hpp>
 #include <mapnik/util/fs.hpp>
+#include <mapnik/util/conversions.hpp>
 #include "../../../plugins/input/postgis/connection_manager.hpp"
+#include "../../../plugins/input/postgis/numeric2string.hpp"
 
 /*
   Compile and run just this test:
@@ -66,6 +68,31 @@ bool run(std::string const& command, bool okay_to_fail = false)
 }
 
 
+// binary NUMERIC as sent by the server: ndigits, weight, sign, dscale and
+// base 10000 digits, all big endian int16
+std::string make_numeric(std::int16_t weight, std::uint16_t sign, std::int16_t dscale,
+                         std::vector<std::int16_t> const& digits)
+{
+    std::string buf;
+    auto put = [&buf](std::int16_t v) {
+        buf.push_back(static_cast<char>((v >> 8) & 0xff));
+        buf.push_back(static_cast<char>(v & 0xff));
+    };
+    put(static_cast<std::int16_t>(digits.size()));
+    put(weight);
+    put(static_cast<std::int16_t>(sign));
+    put(dscale);
+    for (auto d : digits) put(d);
+    return buf;
+}
+
+double numeric_via_string(std::string const& buf)
+{
+    double val = 0;
+    REQUIRE(mapnik::util::string2double(numeric2string(buf.data()), val));
+    return val;
+}
+
 std::string const dbname("mapnik-tmp-postgis-test-db");
 bool status = false;
 
@@ -248,6 +275,49 @@ TEST_CASE("postgis") {
             REQUIRE(false == feature->get("col+bool").to_bool());
         }
 
+        SECTION("Postgis async prefetch")
+        {
+            mapnik::parameters params(base_params);
+            params["table"] = "test";
+            params["max_async_connection"] = "2";
+            params["async_prefetch"] = "true";
+            auto ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(ds != nullptr);
+
+            // more queries than connections, the last one is queued until
+            // one of the first two has received its rows
+            mapnik::feature_style_context_map ctx_map;
+            mapnik::processor_context_ptr proc_ctx = ds->get_context(ctx_map);
+            REQUIRE(proc_ctx != nullptr);
+            mapnik::query q(ds->envelope());
+            std::vector<mapnik::featureset_ptr> featuresets;
+            for (int i = 0; i < 3; ++i)
+            {
+                featuresets.push_back(ds->features_with_context(q, proc_ctx));
+            }
+            for (auto const& featureset : featuresets)
+            {
+                CHECK(count_features(featureset) == 8);
+            }
+        }
+
+        SECTION("Postgis clip_geometries")
+        {
+            mapnik::parameters params(base_params);
+            params["table"] = "test";
+            params["clip_geometries"] = "true";
+            auto ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(ds != nullptr);
+            auto featureset = all_features(ds);
+            CHECK(count_features(featureset) == 8);
+
+            params["twkb_encoding"] = "true";
+            ds = mapnik::datasource_cache::instance().create(params);
+            REQUIRE(ds != nullptr);
+            featureset = all_features(ds);
+            CHECK(count_features(featureset) == 8);
+        }
+
         SECTION("Postgis cursorresultest")
         {
             mapnik::parameters params(base_params);
@@ -446,3 +516,63 @@ SECTION("ConnectionCreator::id() should not expose password")
 }
 
 }
+
+TEST_CASE("postgis numeric")
+{
+    SECTION("scale")
+    {
+        // 12345.678
+        std::string buf = make_numeric(1, 0x0000, 3, {1, 2345, 6780});
+        double val = 0;
+        REQUIRE(numeric2double(buf.data(), val));
+        CHECK(val == 12345.678);
+        CHECK(val == numeric_via_string(buf));
+        // 0.0001
+        buf = make_numeric(-1, 0x0000, 4, {1});
+        REQUIRE(numeric2double(buf.data(), val));
+        CHECK(val == 0.0001);
+        CHECK(val == numeric_via_string(buf));
+        // 1e20
+        buf = make_numeric(5, 0x0000, 0, {1});
+        REQUIRE(numeric2double(buf.data(), val));
+        CHECK(val == 1e20);
+        CHECK(val == numeric_via_string(buf));
+        // 0.00
+        buf = make_numeric(0, 0x0000, 2, {});
+        REQUIRE(numeric2double(buf.data(), val));
+        CHECK(val == 0.0);
+    }
+
+    SECTION("sign")
+    {
+        std::string buf = make_numeric(1, 0x4000, 3, {1, 2345, 6780});
+        double val = 0;
+        REQUIRE(numeric2double(buf.data(), val));
+        CHECK(val == -12345.678);
+        CHECK(val == numeric_via_string(buf));
+        buf = make_numeric(-1, 0x4000, 4, {1});
+        REQUIRE(numeric2double(buf.data(), val));
+        CHECK(val == -0.0001);
+        CHECK(val == numeric_via_string(buf));
+    }
+
+    SECTION("NaN")
+    {
+        std::string buf = make_numeric(0, 0xC000, 0, {});
+        double val = 42;
+        CHECK_FALSE(numeric2double(buf.data(), val));
+    }
+
+    SECTION("inexact values are left to numeric2string")
+    {
+        // mantissa above 2^53
+        std::string buf = make_numeric(4, 0x0000, 0, {9999, 9999, 9999, 9999, 9999});
+        double val = 0;
+        CHECK_FALSE(numeric2double(buf.data(), val));
+        CHECK(numeric_via_string(buf) == 99999999999999999999.0);
+        // scale beyond 10^-22
+        buf = make_numeric(-7, 0x0000, 28, {1});
+        CHECK_FALSE(numeric2double(buf.data(), val));
+        CHECK(numeric_via_string(buf) == 1e-28);
+    }
+}
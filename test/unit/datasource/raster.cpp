@@ -0,0 +1,81 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+
+#include <mapnik/datasource.hpp>
+#include <mapnik/params.hpp>
+#include <mapnik/query.hpp>
+#include "../../../plugins/input/raster/raster_pyramid.hpp"
+
+TEST_CASE("raster pyramid") {
+
+    SECTION("pyramid_levels parsing")
+    {
+        mapnik::parameters params;
+        CHECK(raster_pyramid_levels(params, "world.tif") == 0);
+        params["pyramid_levels"] = mapnik::value_integer(3);
+        CHECK(raster_pyramid_levels(params, "world_${z}.tif") == 3);
+        // the levels need a file pattern
+        CHECK_THROWS_AS(raster_pyramid_levels(params, "world.tif"), mapnik::datasource_exception);
+        params["pyramid_levels"] = mapnik::value_integer(-1);
+        CHECK_THROWS_AS(raster_pyramid_levels(params, "world_${z}.tif"), mapnik::datasource_exception);
+        params["pyramid_levels"] = mapnik::value_integer(31);
+        CHECK_THROWS_AS(raster_pyramid_levels(params, "world_${z}.tif"), mapnik::datasource_exception);
+        params["pyramid_levels"] = "2";
+        CHECK(raster_pyramid_levels(params, "world_${z}.tif") == 2);
+
+        CHECK(raster_pyramid_file("tiles/${z}/world.tif", 0) == "tiles/0/world.tif");
+        CHECK(raster_pyramid_file("tiles/${z}/world_${z}.tif", 2) == "tiles/2/world_2.tif");
+    }
+
+    SECTION("level selection")
+    {
+        mapnik::box2d<double> const extent(0, 0, 1000, 1000);
+        std::vector<raster_pyramid_level> levels{
+            {"world_0.tif", 4096, 4096},
+            {"world_1.tif", 2048, 2048},
+            {"world_2.tif", 1024, 1024},
+            {"world_3.tif", 512, 512}};
+        auto select = [&](double res_x, double res_y, double filter_factor = 1.0) {
+            mapnik::query q(extent, mapnik::query::resolution_type(res_x, res_y));
+            q.set_filter_factor(filter_factor);
+            return raster_pyramid_select(levels, extent, q);
+        };
+        // output finer than the full resolution
+        CHECK(select(10.0, 10.0) == 0);
+        CHECK(select(4.096, 4.096) == 0);
+        // the most reduced level that is still detailed enough
+        CHECK(select(2.0, 2.0) == 1);
+        CHECK(select(1.024, 1.024) == 2);
+        CHECK(select(1.0, 1.0) == 2);
+        CHECK(select(0.1, 0.1) == 3);
+        // the filter factor asks for more source pixels
+        CHECK(select(1.024, 1.024, 2.0) == 1);
+        // both directions must be detailed enough
+        CHECK(select(0.5, 2.0) == 1);
+        // without a pyramid there is only the full resolution
+        std::vector<raster_pyramid_level> single{{"world.tif", 4096, 4096}};
+        mapnik::query q(extent, mapnik::query::resolution_type(0.1, 0.1));
+        CHECK(raster_pyramid_select(single, extent, q) == 0);
+    }
+}
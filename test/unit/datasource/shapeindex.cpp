@@ -26,14 +26,21 @@
 #include <mapnik/datasource_cache.hpp>
 #include <mapnik/mapped_memory_cache.hpp>
 #include <mapnik/util/fs.hpp>
+#include <mapnik/feature.hpp>
 #include <cstdlib>
 #include <fstream>
+#include <tuple>
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
 #include <mapnik/warning_ignore.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem/convenience.hpp>
 MAPNIK_DISABLE_WARNING_POP
 
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
 namespace {
 
 std::size_t count_shapefile_features(std::string const& filename)
@@ -67,7 +74,48 @@ std::size_t count_shapefile_features(std::string const& filename)
     return feature_count;
 }
 
-int create_shapefile_index(std::string const& filename, bool index_parts, bool silent = true)
+// attributes and envelope of every feature, independent of storage order
+std::vector<std::string> shapefile_features(std::string const& filename)
+{
+#if defined(MAPNIK_MEMORY_MAPPED_FILE)
+    mapnik::mapped_memory_cache::instance().clear();
+#endif
+    mapnik::parameters params;
+    params["type"] = "shape";
+    params["file"] = filename;
+    auto ds = mapnik::datasource_cache::instance().create(params);
+    REQUIRE(ds != nullptr);
+    mapnik::query query(ds->envelope());
+    for (auto const& field : ds->get_descriptor().get_descriptors())
+    {
+        query.add_property_name(field.get_name());
+    }
+    auto features = ds->features(query);
+    REQUIRE(features != nullptr);
+    std::vector<std::string> result;
+    for (auto feature = features->next(); feature; feature = features->next())
+    {
+        std::ostringstream s;
+        s << feature->envelope();
+        for (auto const& kv : *feature)
+        {
+            s << "|" << std::get<0>(kv) << "=" << std::get<1>(kv).to_string();
+        }
+        result.push_back(s.str());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void copy_file(std::string const& from, std::string const& to)
+{
+    std::ifstream in(from.c_str(), std::ios::binary);
+    std::ofstream out(to.c_str(), std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+}
+
+int create_shapefile_index(std::string const& filename, bool index_parts, bool packed = false, bool silent = true,
+                           std::string const& reorder = "")
 {
     std::string cmd;
     if (std::getenv("DYLD_LIBRARY_PATH") != nullptr)
@@ -77,6 +125,8 @@ int create_shapefile_index(std::string const& filename, bool index_parts, bool s
 
     cmd += "shapeindex ";
     if (index_parts) cmd+= "--index-parts ";
+    if (packed) cmd+= "--packed ";
+    if (!reorder.empty()) cmd+= "--reorder=" + reorder + " ";
     cmd += filename;
     if (silent)
     {
@@ -149,10 +199,14 @@ TEST_CASE("shapeindex")
             {
                 if (boost::iends_with(path,".shp"))
                 {
-                    for (bool index_parts : {false, true} )
+                    for (auto val : {std::make_tuple(false, false), std::make_tuple(true, false),
+                                     std::make_tuple(false, true), std::make_tuple(true, true)})
                     {
+                        bool index_parts = std::get<0>(val);
+                        bool packed = std::get<1>(val);
                         CAPTURE(path);
                         CAPTURE(index_parts);
+                        CAPTURE(packed);
 
                         std::string index_path = path.substr(0, path.rfind(".")) + ".index";
                         // remove *.index if present
@@ -165,11 +219,11 @@ TEST_CASE("shapeindex")
                         // create *.index
                         if (feature_count > 0)
                         {
-                            REQUIRE(create_shapefile_index(path, index_parts) == EXIT_SUCCESS);
+                            REQUIRE(create_shapefile_index(path, index_parts, packed) == EXIT_SUCCESS);
                         }
                         else
                         {
-                            REQUIRE(create_shapefile_index(path, index_parts) != EXIT_SUCCESS);
+                            REQUIRE(create_shapefile_index(path, index_parts, packed) != EXIT_SUCCESS);
                             REQUIRE(!mapnik::util::exists(index_path)); // index won't be created if there's no features
                         }
                         // count features
@@ -187,3 +241,37 @@ TEST_CASE("shapeindex")
         }
     }
 }
+
+TEST_CASE("shapeindex reorder")
+{
+    std::string shape_plugin("./plugins/input/shape.input");
+    if (mapnik::util::exists(shape_plugin))
+    {
+        std::string directory_name("/tmp/mapnik-tests/");
+        boost::filesystem::create_directories(directory_name);
+        REQUIRE(mapnik::util::exists(directory_name));
+
+        for (std::string order : {"hilbert", "zorder"})
+        {
+            CAPTURE(order);
+            std::string source = "test/data/shp/boundaries";
+            std::string path = directory_name + "shapeindex_reorder";
+            for (auto ext : {".shp", ".shx", ".dbf"})
+            {
+                copy_file(source + ext, path + ext);
+            }
+            if (mapnik::util::exists(path + ".index"))
+            {
+                mapnik::util::remove(path + ".index");
+            }
+            auto expected = shapefile_features(path + ".shp");
+            REQUIRE(!expected.empty());
+            REQUIRE(create_shapefile_index(path + ".shp", false, true, true, order) == EXIT_SUCCESS);
+            REQUIRE(mapnik::util::exists(path + ".index"));
+            // same features, attributes still matching their geometries
+            CHECK(shapefile_features(path + ".shp") == expected);
+            mapnik::util::remove(path + ".index");
+            CHECK(shapefile_features(path + ".shp") == expected);
+        }
+    }
+}
@@ -24,6 +24,9 @@
 
 #include <mapnik/quad_tree.hpp>
 #include <mapnik/util/spatial_index.hpp>
+#include <mapnik/util/packed_rtree.hpp>
+
+#include <algorithm>
 
 TEST_CASE("spatial_index")
 {
@@ -84,4 +87,57 @@ TEST_CASE("spatial_index")
         REQUIRE(results[3] == 2);
         REQUIRE(results.size() == 4);
     }
+
+    SECTION("mapnik::util::packed_rtree<T>")
+    {
+        using value_type = std::int32_t;
+        using filter_type = mapnik::bounding_box_filter<float>;
+        mapnik::box2d<float> extent(0,0,100,100);
+        // small fanout to get a few levels
+        mapnik::util::packed_rtree_builder<value_type> builder(extent, 4);
+        for (value_type i = 0; i < 100; ++i)
+        {
+            float x = static_cast<float>(i % 10) * 10;
+            float y = static_cast<float>(i / 10) * 10;
+            builder.insert(i, mapnik::box2d<float>(x, y, x + 5, y + 5));
+        }
+        REQUIRE(builder.count() == 100);
+        std::ostringstream out(std::ios::binary);
+        builder.write(out);
+        std::string data = out.str();
+        REQUIRE(data.size() > 4096);
+        REQUIRE(mapnik::util::check_packed_rtree(data.data(), data.size()));
+        REQUIRE(!mapnik::util::check_packed_rtree(data.data(), 100));
+
+        using packed_rtree = mapnik::util::packed_rtree<value_type, filter_type>;
+        REQUIRE(packed_rtree::bounding_box(data.data(), data.size()) == extent);
+
+        // in memory and streamed queries agree
+        filter_type filter(mapnik::box2d<float>(12, 12, 33, 23));
+        std::vector<value_type> results;
+        packed_rtree::query(filter, data.data(), data.size(), results);
+        std::sort(results.begin(), results.end());
+        std::vector<value_type> expected = { 11, 12, 13, 21, 22, 23 };
+        REQUIRE(results == expected);
+
+        std::istringstream in(data, std::ios::binary);
+        REQUIRE(mapnik::util::check_packed_rtree(in));
+        results.clear();
+        packed_rtree::query(filter, in, results);
+        std::sort(results.begin(), results.end());
+        REQUIRE(results == expected);
+
+        // whole extent
+        results.clear();
+        packed_rtree::query(filter_type(extent), data.data(), data.size(), results);
+        REQUIRE(results.size() == 100);
+
+        // quad tree index is not a packed R-tree
+        mapnik::quad_tree<value_type> tree(mapnik::box2d<double>(0,0,100,100));
+        tree.insert(1, mapnik::box2d<double>(10,10,20,20));
+        std::ostringstream quad_out(std::ios::binary);
+        tree.write(quad_out);
+        std::istringstream quad_in(quad_out.str(), std::ios::binary);
+        REQUIRE(!mapnik::util::check_packed_rtree(quad_in));
+    }
 }
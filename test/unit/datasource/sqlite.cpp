@@ -0,0 +1,116 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "catch.hpp"
+#include "ds_test_util.hpp"
+
+#include <mapnik/datasource.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/util/fs.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string const sqlite_file("./mapnik-tmp-sqlite-test.sqlite");
+
+// creates the table through initdb, which runs on every connection the
+// datasource opens and is written to be idempotent
+mapnik::parameters sqlite_params(std::string const& table, bool create = true)
+{
+    mapnik::parameters params;
+    params["type"] = "sqlite";
+    params["file"] = sqlite_file;
+    params["table"] = table;
+    params["geometry_field"] = "geom";
+    params["key_field"] = "id";
+    params["use_spatial_index"] = false;
+    params["extent"] = "0,0,4,4";
+    if (!create) return params;
+    params["initdb"] = "CREATE TABLE IF NOT EXISTS pts (id INTEGER PRIMARY KEY, name TEXT, geom BLOB);"
+        "INSERT OR IGNORE INTO pts "
+        "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < 1000) "
+        // POINT(1 2)
+        "SELECT x, 'p' || x, X'0101000000000000000000F03F0000000000000040' FROM n";
+    return params;
+}
+
+} // anonymous ns
+
+TEST_CASE("sqlite") {
+
+    std::string sqlite_plugin("./plugins/input/sqlite.input");
+    if (mapnik::util::exists(sqlite_plugin))
+    {
+        std::remove(sqlite_file.c_str());
+        // an empty file is an empty database
+        std::ofstream(sqlite_file.c_str()).close();
+
+        SECTION("pixel size tokens are substituted as text")
+        {
+            auto ds = mapnik::datasource_cache::instance().create(
+                sqlite_params("(SELECT id, geom, '!pixel_width!' AS pw, !pixel_height! * 2 AS ph2 FROM pts)"));
+            REQUIRE(ds != nullptr);
+            mapnik::query q(ds->envelope(), mapnik::query::resolution_type(0.5, 0.25), 1.0);
+            q.add_property_name("pw");
+            q.add_property_name("ph2");
+            auto fs = ds->features(q);
+            auto f = fs->next();
+            REQUIRE(f != nullptr);
+            CHECK(f->get("pw").to_string() == "2");
+            CHECK(f->get("ph2").to_double() == 8.0);
+        }
+
+        SECTION("concurrent queries")
+        {
+            // populate first, concurrent inserts from initdb would hit SQLITE_BUSY
+            REQUIRE(mapnik::datasource_cache::instance().create(sqlite_params("pts")) != nullptr);
+            auto ds = mapnik::datasource_cache::instance().create(sqlite_params("pts", false));
+            REQUIRE(ds != nullptr);
+            std::size_t const expected = count_features(all_features(ds));
+            CHECK(expected == 1000);
+            std::vector<std::size_t> counts(8, 0);
+            std::vector<std::thread> threads;
+            for (std::size_t i = 0; i < counts.size(); ++i)
+            {
+                threads.emplace_back([&ds, &counts, i]() {
+                    // several queries per thread reuse its connection and
+                    // the cached statement
+                    for (int n = 0; n < 4; ++n)
+                    {
+                        counts[i] += count_features(all_features(ds));
+                    }
+                });
+            }
+            for (auto & t : threads) t.join();
+            for (auto count : counts)
+            {
+                CHECK(count == 4 * expected);
+            }
+        }
+
+        std::remove(sqlite_file.c_str());
+    }
+}
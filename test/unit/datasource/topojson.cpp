@@ -179,4 +179,55 @@ TEST_CASE("TopoJSON")
         }
     }
 
+    SECTION("decoded arcs")
+    {
+        // arc 0 is shared by both polygons, and reversed in the second one
+        mapnik::topojson::topology topo;
+        REQUIRE(parse_topology_string(HEREDOC(
+              {
+                  "type": "Topology",
+                  "transform": {"scale": [1, 1], "translate": [0, 0]},
+                  "objects": {
+                      "a": {"type": "Polygon", "arcs": [[0, 1]]},
+                      "b": {"type": "Polygon", "arcs": [[-1, 2]]}
+                  },
+                  "arcs": [[[0, 0], [0, 1]],
+                           [[0, 1], [1, 0], [0, -1], [-1, 0]],
+                           [[0, 0], [-1, 0], [0, 1], [1, 0]]]
+              }
+              ), topo));
+        REQUIRE(topo.geometries.size() == 2);
+
+        mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+        mapnik::transcoder tr("utf8");
+        std::vector<mapnik::box2d<double>> expected;
+        for (auto const& geom : topo.geometries)
+        {
+            mapnik::topojson::feature_generator<mapnik::context_ptr> visitor(ctx, tr, topo, 1);
+            mapnik::feature_ptr feature = mapnik::util::apply_visitor(visitor, geom);
+            REQUIRE(feature);
+            expected.push_back(feature->envelope());
+        }
+        CHECK(expected[0] == mapnik::box2d<double>(0, 0, 1, 1));
+        CHECK(expected[1] == mapnik::box2d<double>(-1, 0, 0, 1));
+
+        mapnik::topojson::arc_stats stats = mapnik::topojson::decode_arcs(topo);
+        CHECK(stats.num_arcs == 3);
+        CHECK(stats.num_coordinates == 10);
+        CHECK(stats.memory_usage > 0);
+        CHECK(topo.arcs.empty());
+        CHECK(mapnik::topojson::num_arcs(topo) == 3);
+
+        for (std::size_t i = 0; i < topo.geometries.size(); ++i)
+        {
+            auto const& geom = topo.geometries[i];
+            mapnik::box2d<double> bbox = mapnik::util::apply_visitor(mapnik::topojson::bounding_box_visitor(topo), geom);
+            CHECK(bbox == expected[i]);
+            mapnik::topojson::feature_generator<mapnik::context_ptr> visitor(ctx, tr, topo, 1);
+            mapnik::feature_ptr feature = mapnik::util::apply_visitor(visitor, geom);
+            REQUIRE(feature);
+            CHECK(feature->envelope() == expected[i]);
+        }
+    }
+
 }
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <mapnik/geometry/vertex_importance.hpp>
+#include <mapnik/vertex_importance_cache.hpp>
+#include <mapnik/feature.hpp>
+
+#include <cmath>
+
+TEST_CASE("vertex importance") {
+
+SECTION("line_string") {
+
+    mapnik::geometry::line_string<double> line;
+    line.emplace_back(0, 0);
+    line.emplace_back(1, 0.1); // tiny wiggle
+    line.emplace_back(2, 0);
+    line.emplace_back(3, 5);   // big spike
+    line.emplace_back(4, 0);
+    mapnik::geometry::geometry<double> geom(line);
+    auto importance = mapnik::geometry::compute_vertex_importance(geom);
+    REQUIRE(importance.size() == 5);
+    CHECK(std::isinf(importance[0]));
+    CHECK(std::isinf(importance[4]));
+    CHECK(importance[1] < importance[3]);
+    // effective area never decreases along the elimination order
+    CHECK(importance[2] >= importance[1]);
+
+    auto all = mapnik::geometry::filter_by_importance(geom, importance, 0.0);
+    CHECK(all.get<mapnik::geometry::line_string<double>>().size() == 5);
+    auto coarse = mapnik::geometry::filter_by_importance(geom, importance, 6.0);
+    auto const& coarse_line = coarse.get<mapnik::geometry::line_string<double>>();
+    REQUIRE(coarse_line.size() == 3);
+    CHECK(coarse_line[1].y == 5);
+    auto ends = mapnik::geometry::filter_by_importance(geom, importance, 1e9);
+    CHECK(ends.get<mapnik::geometry::line_string<double>>().size() == 2);
+}
+
+SECTION("polygon rings keep at least four points") {
+
+    mapnik::geometry::polygon<double> poly;
+    mapnik::geometry::linear_ring<double> ring;
+    ring.emplace_back(0, 0);
+    ring.emplace_back(1, 0);
+    ring.emplace_back(2, 0.01);
+    ring.emplace_back(3, 0);
+    ring.emplace_back(3, 3);
+    ring.emplace_back(0, 3);
+    ring.emplace_back(0, 0);
+    poly.push_back(std::move(ring));
+    mapnik::geometry::geometry<double> geom(poly);
+    auto importance = mapnik::geometry::compute_vertex_importance(geom);
+    REQUIRE(importance.size() == 7);
+    auto filtered = mapnik::geometry::filter_by_importance(geom, importance, 1e9);
+    auto const& filtered_poly = filtered.get<mapnik::geometry::polygon<double>>();
+    REQUIRE(filtered_poly.size() == 1);
+    CHECK(filtered_poly.front().size() == 4);
+}
+
+SECTION("multi geometries are flattened in storage order") {
+
+    mapnik::geometry::multi_line_string<double> multi_line;
+    for (int i = 0; i < 2; ++i)
+    {
+        mapnik::geometry::line_string<double> line;
+        line.emplace_back(0, i);
+        line.emplace_back(1, i + 0.5);
+        line.emplace_back(2, i);
+        multi_line.push_back(std::move(line));
+    }
+    mapnik::geometry::geometry<double> geom(multi_line);
+    auto importance = mapnik::geometry::compute_vertex_importance(geom);
+    REQUIRE(importance.size() == 6);
+    CHECK(std::isinf(importance[3]));
+    auto filtered = mapnik::geometry::filter_by_importance(geom, importance, 1e9);
+    auto const& filtered_multi = filtered.get<mapnik::geometry::multi_line_string<double>>();
+    REQUIRE(filtered_multi.size() == 2);
+    CHECK(filtered_multi[0].size() == 2);
+    CHECK(filtered_multi[1].size() == 2);
+}
+
+SECTION("thinned features are shared within a zoom band") {
+
+    mapnik::geometry::line_string<double> line;
+    line.emplace_back(0, 0);
+    line.emplace_back(1, 0.1); // effective area 0.1
+    line.emplace_back(2, 0);
+    line.emplace_back(3, 5);   // big spike
+    line.emplace_back(4, 0);
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    mapnik::feature_ptr feature = std::make_shared<mapnik::feature_impl>(ctx, 1);
+    feature->set_geometry(mapnik::geometry::geometry<double>(line));
+
+    mapnik::vertex_importance_cache cache;
+    cache.push_back(feature->get_geometry());
+    REQUIRE(cache.size() == 1);
+    // nothing to drop: no copy
+    CHECK(cache.filtered(feature, 0, 0.0) == feature);
+    CHECK(cache.filtered(feature, 0, 0.05) == feature);
+    // unknown position
+    CHECK(cache.filtered(feature, 1, 1e9) == feature);
+
+    auto thinned = cache.filtered(feature, 0, 6.0);
+    REQUIRE(thinned != feature);
+    CHECK(thinned->id() == feature->id());
+    // 6 is rounded down to 4: the vertex of effective area 5 stays
+    CHECK(thinned->get_geometry().get<mapnik::geometry::line_string<double>>().size() == 4);
+    // 6 and 7 fall in the same band [4, 8)
+    CHECK(cache.filtered(feature, 0, 7.0) == thinned);
+    auto coarser = cache.filtered(feature, 0, 1e9);
+    CHECK(coarser != thinned);
+    CHECK(coarser->get_geometry().get<mapnik::geometry::line_string<double>>().size() == 2);
+    // the original is left untouched
+    CHECK(feature->get_geometry().get<mapnik::geometry::line_string<double>>().size() == 5);
+}
+
+SECTION("threshold") {
+
+    // 0.5px tolerance at 2 pixels per map unit
+    CHECK(mapnik::geometry::importance_threshold(2.0, 2.0, 0.5) == Approx(0.0625));
+    CHECK(mapnik::geometry::importance_threshold(0.0, 2.0, 0.5) == 0.0);
+}
+}
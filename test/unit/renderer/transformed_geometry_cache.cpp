@@ -0,0 +1,307 @@
+#include "catch.hpp"
+
+#include <mapnik/agg_renderer.hpp>
+#include <mapnik/color.hpp>
+#include <mapnik/feature.hpp>
+#include <mapnik/feature_factory.hpp>
+#include <mapnik/feature_type_style.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/image.hpp>
+#include <mapnik/image_util.hpp>
+#include <mapnik/layer.hpp>
+#include <mapnik/map.hpp>
+#include <mapnik/memory_datasource.hpp>
+#include <mapnik/rule.hpp>
+#include <mapnik/symbolizer.hpp>
+#include <mapnik/projection.hpp>
+#include <mapnik/proj_transform.hpp>
+#include <mapnik/renderer_common/transformed_geometry_cache.hpp>
+
+namespace {
+
+// stands in for a vertex_converter, counting chain evaluations
+struct counting_converter
+{
+    counting_converter()
+        : count(0) {}
+
+    template <typename VertexAdapter, typename Processor>
+    void apply(VertexAdapter & geom, Processor & proc)
+    {
+        ++count;
+        proc.add_path(geom);
+    }
+
+    unsigned count;
+};
+
+mapnik::feature_ptr make_feature(mapnik::value_integer id)
+{
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, id));
+    mapnik::geometry::multi_line_string<double> multi_line;
+    for (int i = 0; i < 2; ++i)
+    {
+        mapnik::geometry::line_string<double> line;
+        line.emplace_back(0, i);
+        line.emplace_back(10, i);
+        multi_line.push_back(std::move(line));
+    }
+    feature->set_geometry(std::move(multi_line));
+    return feature;
+}
+
+mapnik::line_symbolizer make_line(double width, char const* stroke)
+{
+    mapnik::line_symbolizer sym;
+    mapnik::put(sym, mapnik::keys::stroke_width, width);
+    mapnik::put(sym, mapnik::keys::stroke, mapnik::color(stroke));
+    return sym;
+}
+
+// map with a single layer holding `geometry`, styled by `rules` in order
+mapnik::Map make_map(mapnik::geometry::geometry<double> && geometry, std::vector<mapnik::rule> rules)
+{
+    mapnik::parameters params;
+    params["type"] = "memory";
+    auto ds = std::make_shared<mapnik::memory_datasource>(params);
+    mapnik::context_ptr ctx = std::make_shared<mapnik::context_type>();
+    mapnik::feature_ptr feature(mapnik::feature_factory::create(ctx, 1));
+    feature->set_geometry(std::move(geometry));
+    ds->push(feature);
+
+    mapnik::Map map(256, 256);
+    mapnik::feature_type_style style;
+    for (auto & r : rules) style.add_rule(std::move(r));
+    map.insert_style("style", std::move(style));
+    mapnik::layer lyr("layer");
+    lyr.set_datasource(ds);
+    lyr.add_style("style");
+    map.add_layer(lyr);
+    // the line crosses the map edges so that it is clipped
+    map.zoom_to_box(mapnik::box2d<double>(-5, -5, 5, 5));
+    return map;
+}
+
+mapnik::geometry::line_string<double> make_line_string()
+{
+    mapnik::geometry::line_string<double> line;
+    line.emplace_back(-10, -2);
+    line.emplace_back(0, 3);
+    line.emplace_back(10, -1);
+    return line;
+}
+
+mapnik::transformed_geometry_key make_key(mapnik::feature_impl const& feature)
+{
+    mapnik::transformed_geometry_key key;
+    key.feature_id = feature.id();
+    key.extent = mapnik::box2d<double>(0, 0, 10, 10);
+    key.scale_x = 1.0;
+    key.scale_y = 1.0;
+    return key;
+}
+
+}
+
+TEST_CASE("transformed geometry cache") {
+
+SECTION("records all parts as one path") {
+    mapnik::transformed_geometry_cache cache;
+    counting_converter converter;
+    auto feature = make_feature(1);
+    cache.start_rule();
+    mapnik::transformed_path const& path = cache.get(*feature, make_key(*feature), converter);
+    CHECK(converter.count == 2);
+    CHECK(path.type == mapnik::geometry::geometry_types::LineString);
+    REQUIRE(path.vertices.size() == 4);
+    CHECK(path.vertices[0].cmd == mapnik::SEG_MOVETO);
+    CHECK(path.vertices[2].cmd == mapnik::SEG_MOVETO);
+    CHECK(path.vertices[3].y == 1);
+
+    mapnik::transformed_path_adapter adapter(path);
+    double x, y;
+    unsigned count = 0;
+    while (adapter.vertex(&x, &y) != mapnik::SEG_END) ++count;
+    CHECK(count == 4);
+}
+
+SECTION("only active when two symbolizers have the same key") {
+    mapnik::transformed_geometry_cache cache;
+    auto feature = make_feature(1);
+    mapnik::transformed_geometry_key key = make_key(*feature);
+    key.clip = mapnik::transformed_geometry_key::clip_line;
+    mapnik::transformed_geometry_key offset = key;
+    offset.offset = 2.0;
+    double padding = 0.0;
+    CHECK(!cache.active());
+    cache.start_rule();
+    cache.add_candidate(key, 1.0);
+    cache.add_candidate(offset, 3.0);
+    CHECK(!cache.active());
+    CHECK(!cache.shared(key, padding));
+
+    // a casing and a fill line: both clip to the box of the wider one
+    cache.add_candidate(key, 2.0);
+    CHECK(cache.active());
+    CHECK(cache.shared(key, padding));
+    CHECK(padding == 2.0);
+    CHECK(!cache.shared(offset, padding));
+    CHECK(padding == 2.0);
+
+    cache.start_rule();
+    CHECK(!cache.active());
+    CHECK(!cache.shared(key, padding));
+}
+
+SECTION("shared between symbolizers with the same key") {
+    mapnik::transformed_geometry_cache cache;
+    counting_converter converter;
+    auto feature = make_feature(1);
+    cache.start_rule();
+    mapnik::transformed_geometry_key key = make_key(*feature);
+    cache.get(*feature, key, converter);
+    cache.get(*feature, key, converter);
+    CHECK(converter.count == 2);
+    CHECK(cache.hits() == 1);
+
+    // any difference in the converter config is a different entry
+    mapnik::transformed_geometry_key padded = key;
+    padded.clip = mapnik::transformed_geometry_key::clip_line;
+    padded.clip_box = mapnik::box2d<double>(-1, -1, 11, 11);
+    cache.get(*feature, padded, converter);
+    padded.clip_box.pad(0.5);
+    cache.get(*feature, padded, converter);
+    mapnik::transformed_geometry_key offset = key;
+    offset.offset = 2.0;
+    cache.get(*feature, offset, converter);
+    CHECK(converter.count == 8);
+    CHECK(cache.size() == 4);
+    CHECK(cache.hits() == 1);
+}
+
+SECTION("keyed by projection") {
+    mapnik::projection merc("epsg:3857");
+    mapnik::projection wgs84("epsg:4326");
+    mapnik::proj_transform identity(merc, merc);
+    mapnik::proj_transform reproject(wgs84, merc);
+    mapnik::transformed_geometry_cache cache;
+    counting_converter converter;
+    auto feature = make_feature(1);
+    cache.start_rule();
+    mapnik::transformed_geometry_key key = make_key(*feature);
+    key.prj_trans = &identity;
+    key.prj_trans_equal = identity.equal();
+    cache.get(*feature, key, converter);
+    key.prj_trans = &reproject;
+    key.prj_trans_equal = reproject.equal();
+    cache.get(*feature, key, converter);
+    CHECK(converter.count == 4);
+    CHECK(cache.hits() == 0);
+}
+
+SECTION("entries are dropped for every rule and feature") {
+    mapnik::transformed_geometry_cache cache;
+    counting_converter converter;
+    auto feature = make_feature(1);
+    auto other = make_feature(2);
+    cache.start_rule();
+    cache.get(*feature, make_key(*feature), converter);
+    CHECK(cache.size() == 1);
+    cache.start_rule();
+    CHECK(cache.size() == 0);
+    cache.get(*other, make_key(*other), converter);
+    cache.start_rule();
+    cache.get(*feature, make_key(*feature), converter);
+    CHECK(converter.count == 6);
+    CHECK(cache.hits() == 0);
+}
+
+SECTION("vertex budget") {
+    auto feature = make_feature(1);
+    counting_converter converter;
+    mapnik::transformed_geometry_cache cache(6);
+    cache.start_rule();
+    mapnik::transformed_geometry_key key = make_key(*feature);
+    cache.get(*feature, key, converter);
+    key.offset = 1.0;
+    mapnik::transformed_path const& path = cache.get(*feature, key, converter);
+    CHECK(path.vertices.size() == 4);
+    CHECK(cache.size() == 1);
+}
+
+}
+
+TEST_CASE("transformed geometry cache in the agg renderer") {
+
+SECTION("casing and fill lines of a rule share the clipped path") {
+    mapnik::rule casing_and_fill;
+    casing_and_fill.append(make_line(6.0, "black"));
+    casing_and_fill.append(make_line(3.0, "white"));
+    std::vector<mapnik::rule> rules;
+    rules.push_back(std::move(casing_and_fill));
+    mapnik::Map map = make_map(make_line_string(), std::move(rules));
+    mapnik::image_rgba8 image(map.width(), map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(map, image);
+    ren.apply();
+    CHECK(ren.geometry_cache().misses() == 1);
+    CHECK(ren.geometry_cache().hits() == 1);
+
+    // same lines in separate rules don't share, and look the same
+    mapnik::rule casing, fill;
+    casing.append(make_line(6.0, "black"));
+    fill.append(make_line(3.0, "white"));
+    std::vector<mapnik::rule> separate;
+    separate.push_back(std::move(casing));
+    separate.push_back(std::move(fill));
+    mapnik::Map separate_map = make_map(make_line_string(), std::move(separate));
+    mapnik::image_rgba8 expected(separate_map.width(), separate_map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> separate_ren(separate_map, expected);
+    separate_ren.apply();
+    CHECK(separate_ren.geometry_cache().misses() == 0);
+    CHECK(separate_ren.geometry_cache().hits() == 0);
+    CHECK(image.painted());
+    CHECK(mapnik::compare(image, expected) == 0);
+}
+
+SECTION("dashed lines keep their own path") {
+    mapnik::rule r;
+    r.append(make_line(6.0, "black"));
+    mapnik::line_symbolizer dashed = make_line(3.0, "white");
+    mapnik::put(dashed, mapnik::keys::stroke_dasharray, mapnik::dash_array{{2.0, 2.0}});
+    r.append(std::move(dashed));
+    std::vector<mapnik::rule> rules;
+    rules.push_back(std::move(r));
+    mapnik::Map map = make_map(make_line_string(), std::move(rules));
+    mapnik::image_rgba8 image(map.width(), map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(map, image);
+    ren.apply();
+    CHECK(ren.geometry_cache().misses() == 0);
+    CHECK(ren.geometry_cache().hits() == 0);
+}
+
+SECTION("polygon fill and outline don't share") {
+    mapnik::rule r;
+    mapnik::polygon_symbolizer poly;
+    mapnik::put(poly, mapnik::keys::fill, mapnik::color("red"));
+    r.append(std::move(poly));
+    r.append(make_line(2.0, "black"));
+    std::vector<mapnik::rule> rules;
+    rules.push_back(std::move(r));
+    mapnik::geometry::linear_ring<double> ring;
+    ring.emplace_back(-10, -10);
+    ring.emplace_back(10, -10);
+    ring.emplace_back(10, 3);
+    ring.emplace_back(-10, -10);
+    mapnik::geometry::polygon<double> polygon;
+    polygon.push_back(std::move(ring));
+    mapnik::Map map = make_map(std::move(polygon), std::move(rules));
+    mapnik::image_rgba8 image(map.width(), map.height());
+    mapnik::agg_renderer<mapnik::image_rgba8> ren(map, image);
+    ren.apply();
+    CHECK(image.painted());
+    CHECK(ren.geometry_cache().misses() == 0);
+    CHECK(ren.geometry_cache().hits() == 0);
+}
+
+}
@@ -0,0 +1,150 @@
+#include "catch.hpp"
+// mapnik
+#include <mapnik/wkb.hpp>
+#include <mapnik/wkb_view.hpp>
+#include <mapnik/vertex.hpp>
+#include <mapnik/geometry.hpp>
+#include <mapnik/geometry/envelope.hpp>
+#include <mapnik/geometry/is_empty.hpp>
+// stl
+#include "parse_hex.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <boost/algorithm/string.hpp>
+
+TEST_CASE("wkb_view")
+{
+    SECTION("envelope and vertices match from_wkb")
+    {
+        std::string filename("test/unit/data/well-known-geometries.test");
+        std::ifstream is(filename.c_str(),std::ios_base::in | std::ios_base::binary);
+        if (!is) throw std::runtime_error("could not open: '" + filename + "'");
+
+        for (std::string line; std::getline(is, line,'\n');)
+        {
+            std::vector<std::string> columns;
+            boost::split(columns, line, boost::is_any_of(";"));
+            REQUIRE(columns.size() == 3);
+            std::vector<char> wkb;
+            REQUIRE(mapnik::util::parse_hex(columns[1], wkb));
+            mapnik::geometry::geometry<double> geom = mapnik::geometry_utils::from_wkb(wkb.data(), wkb.size(), mapnik::wkbAuto);
+            mapnik::wkb_view view(wkb.data(), wkb.size(), mapnik::wkbAuto);
+            INFO(columns[0]);
+            CHECK(view.is_empty() == mapnik::geometry::is_empty(geom));
+            if (!mapnik::geometry::is_empty(geom))
+            {
+                CHECK(view.envelope() == mapnik::geometry::envelope(geom));
+                CHECK(mapnik::geometry::envelope(view.to_geometry()) == mapnik::geometry::envelope(geom));
+            }
+            else
+            {
+                CHECK(!view.envelope().valid());
+            }
+        }
+    }
+
+    SECTION("vertex adapter")
+    {
+        // POLYGON((0 0,10 0,10 10,0 0))
+        std::vector<char> wkb;
+        REQUIRE(mapnik::util::parse_hex("01030000000100000004000000000000000000000000000000000000000000000000002440000000000000000000000000000024400000000000002440"
+                                        "00000000000000000000000000000000", wkb));
+        mapnik::wkb_view view(wkb.data(), wkb.size());
+        mapnik::geometry::wkb_vertex_adapter va(view);
+        CHECK(va.type() == mapnik::geometry::geometry_types::Polygon);
+        double x, y;
+        CHECK(va.vertex(&x, &y) == mapnik::SEG_MOVETO);
+        CHECK(x == 0.0);
+        CHECK(y == 0.0);
+        CHECK(va.vertex(&x, &y) == mapnik::SEG_LINETO);
+        CHECK(x == 10.0);
+        CHECK(va.vertex(&x, &y) == mapnik::SEG_LINETO);
+        CHECK(y == 10.0);
+        CHECK(va.vertex(&x, &y) == mapnik::SEG_CLOSE);
+        CHECK(va.vertex(&x, &y) == mapnik::SEG_END);
+        va.rewind(0);
+        CHECK(va.vertex(&x, &y) == mapnik::SEG_MOVETO);
+        // the adapter keeps its own copy of the view
+        mapnik::geometry::wkb_vertex_adapter va_tmp(mapnik::wkb_view(wkb.data(), wkb.size()));
+        CHECK(va_tmp.vertex(&x, &y) == mapnik::SEG_MOVETO);
+        CHECK(va_tmp.vertex(&x, &y) == mapnik::SEG_LINETO);
+        CHECK(x == 10.0);
+        // truncated blob must not read past the end
+        mapnik::wkb_view truncated(wkb.data(), wkb.size() - 8);
+        mapnik::geometry::wkb_vertex_adapter va2(truncated);
+        unsigned count = 0;
+        while (va2.vertex(&x, &y) != mapnik::SEG_END) ++count;
+        CHECK(count == 3);
+    }
+
+    SECTION("GeoPackage")
+    {
+        std::string const polygon("01030000000100000004000000000000000000000000000000000000000000000000002440000000000000000000000000000024400000000000002440"
+                                  "00000000000000000000000000000000");
+        // little endian header with an xy envelope (0 10 0 10), srs_id 4326
+        std::vector<char> gpkg;
+        REQUIRE(mapnik::util::parse_hex("47500003E6100000"
+                                        "0000000000000000000000000000244000000000000000000000000000002440" + polygon, gpkg));
+        mapnik::wkb_view view(gpkg.data(), gpkg.size(), mapnik::wkbAuto);
+        CHECK(view.format() == mapnik::wkbGeoPackage);
+        CHECK(view.type() == mapnik::geometry::geometry_types::Polygon);
+        CHECK(view.envelope() == mapnik::box2d<double>(0, 0, 10, 10));
+        mapnik::geometry::geometry<double> geom = mapnik::geometry_utils::from_wkb(gpkg.data(), gpkg.size(), mapnik::wkbAuto);
+        CHECK(geom.is<mapnik::geometry::polygon<double>>());
+        CHECK(mapnik::geometry::envelope(geom) == mapnik::box2d<double>(0, 0, 10, 10));
+
+        // no envelope, it is computed from the vertices
+        std::vector<char> bare;
+        REQUIRE(mapnik::util::parse_hex("47500001E6100000" + polygon, bare));
+        mapnik::wkb_view bare_view(bare.data(), bare.size(), mapnik::wkbGeoPackage);
+        CHECK(bare_view.envelope() == mapnik::box2d<double>(0, 0, 10, 10));
+        CHECK(mapnik::geometry::envelope(bare_view.to_geometry()) == mapnik::box2d<double>(0, 0, 10, 10));
+
+        // big endian header, the WKB itself stays little endian
+        std::vector<char> xdr;
+        REQUIRE(mapnik::util::parse_hex("47500002000010E6"
+                                        "0000000000000000402400000000000000000000000000004024000000000000" + polygon, xdr));
+        mapnik::wkb_view xdr_view(xdr.data(), xdr.size(), mapnik::wkbGeoPackage);
+        CHECK(xdr_view.envelope() == mapnik::box2d<double>(0, 0, 10, 10));
+
+        // empty geometry flag, the envelope is not valid
+        std::vector<char> empty;
+        REQUIRE(mapnik::util::parse_hex("47500011E6100000"
+                                        "0101000000000000000000F87F000000000000F87F", empty));
+        mapnik::wkb_view empty_view(empty.data(), empty.size(), mapnik::wkbAuto);
+        CHECK(empty_view.format() == mapnik::wkbGeoPackage);
+        CHECK(!empty_view.envelope().valid());
+
+        // not a GeoPackage blob
+        mapnik::wkb_view invalid(gpkg.data() + 1, gpkg.size() - 1, mapnik::wkbGeoPackage);
+        CHECK(!invalid.valid());
+        CHECK(mapnik::geometry::is_empty(mapnik::geometry_utils::from_wkb(gpkg.data() + 1, gpkg.size() - 1, mapnik::wkbGeoPackage)));
+    }
+
+    SECTION("type codes")
+    {
+        // LINESTRING Z(0 0 5,10 10 5)
+        std::string const coords("000000000000000000000000000000000000000000001440"
+                                 "000000000000244000000000000024400000000000001440");
+        std::vector<char> wkb;
+        REQUIRE(mapnik::util::parse_hex("01EA03000002000000" + coords, wkb));
+        mapnik::wkb_view view(wkb.data(), wkb.size());
+        CHECK(view.type() == mapnik::geometry::geometry_types::LineString);
+        CHECK(view.envelope() == mapnik::box2d<double>(0, 0, 10, 10));
+
+        // same bytes tagged as a SpatiaLite compressed line string (1000002)
+        // or with an unknown dimension flag (4002): nothing must be decoded
+        for (std::string const type : {"42420F00", "A20F0000"})
+        {
+            INFO(type);
+            std::vector<char> unsupported;
+            REQUIRE(mapnik::util::parse_hex("01" + type + "02000000" + coords, unsupported));
+            mapnik::wkb_view unsupported_view(unsupported.data(), unsupported.size());
+            CHECK(unsupported_view.type() == mapnik::geometry::geometry_types::Unknown);
+            CHECK(unsupported_view.is_empty());
+            CHECK(!unsupported_view.envelope().valid());
+            CHECK(mapnik::geometry::is_empty(unsupported_view.to_geometry()));
+        }
+    }
+}
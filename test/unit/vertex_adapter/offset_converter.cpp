@@ -8,6 +8,9 @@
 
 // stl
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
 
 namespace offset_test {
 
@@ -382,4 +385,83 @@ SECTION("offsect converter does not skip SEG_MOVETO or SEG_CLOSE vertices") {
     CHECK(close_count == 2);
 }
 
+
+SECTION("converters sharing pooled buffers produce identical output") {
+
+    auto collect = [] (mapnik::offset_converter<fake_path> & conv)
+    {
+        std::vector<std::tuple<double, double, unsigned>> result;
+        unsigned cmd;
+        double x, y;
+        while ((cmd = conv.vertex(&x, &y)) != mapnik::SEG_END)
+        {
+            result.emplace_back(x, y, cmd);
+        }
+        return result;
+    };
+
+    fake_path path1 = {0, 0, 10, 0, 10, 10, 20, 10};
+    fake_path path2 = {0, 0, 5, 5, 10, 0};
+    std::vector<std::tuple<double, double, unsigned>> expected1, expected2;
+    {
+        mapnik::offset_converter<fake_path> conv(path1);
+        conv.set_offset(1);
+        expected1 = collect(conv);
+    }
+    {
+        // picks up the buffer released above
+        mapnik::offset_converter<fake_path> conv(path2);
+        conv.set_offset(-2);
+        expected2 = collect(conv);
+    }
+    REQUIRE(expected1.size() > 0);
+    REQUIRE(expected2.size() > 0);
+
+    // live at the same time, each converter must own its buffer
+    path1.rewind(0);
+    path2.rewind(0);
+    mapnik::offset_converter<fake_path> conv1(path1);
+    mapnik::offset_converter<fake_path> conv2(path2);
+    conv1.set_offset(1);
+    conv2.set_offset(-2);
+    double x, y;
+    conv1.vertex(&x, &y);
+    CHECK(collect(conv2) == expected2);
+    conv1.rewind(0);
+    CHECK(collect(conv1) == expected1);
+}
+
+SECTION("moved converter keeps its buffer") {
+    fake_path path = {0, 0, 10, 0, 10, 10};
+    mapnik::offset_converter<fake_path> conv(path);
+    conv.set_offset(1);
+    double x, y;
+    std::vector<std::pair<double, double>> expected;
+    while (conv.vertex(&x, &y) != mapnik::SEG_END) expected.emplace_back(x, y);
+    REQUIRE(expected.size() > 0);
+
+    mapnik::offset_converter<fake_path> moved(std::move(conv));
+    moved.rewind(0);
+    std::vector<std::pair<double, double>> result;
+    while (moved.vertex(&x, &y) != mapnik::SEG_END) result.emplace_back(x, y);
+    CHECK(result == expected);
+}
+
+SECTION("converter outliving the thread's buffer pool") {
+    // destroyed after the pool at thread exit, in reverse order of construction
+    struct holder
+    {
+        fake_path path = {0, 0, 10, 0};
+        std::unique_ptr<mapnik::offset_converter<fake_path>> conv;
+    };
+    std::thread worker([] {
+        thread_local holder h;
+        h.conv.reset(new mapnik::offset_converter<fake_path>(h.path));
+        h.conv->set_offset(1);
+        double x, y;
+        while (h.conv->vertex(&x, &y) != mapnik::SEG_END) {}
+    });
+    worker.join();
+}
+
 }
@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+// mapnik
+#include <mapnik/geometry.hpp>
+#include <mapnik/vertex_adapters.hpp>
+#include <mapnik/polygon_clipper.hpp>
+
+// stl
+#include <sstream>
+#include <string>
+
+namespace {
+
+template <typename T>
+std::string dump(T & path)
+{
+    unsigned cmd;
+    double x = 0;
+    double y = 0;
+    unsigned idx = 0;
+    std::ostringstream s;
+    path.rewind(0);
+    while ((cmd = path.vertex(&x, &y)) != mapnik::SEG_END)
+    {
+        if (idx++ > 0) s << ",";
+        s << x << " " << y << " " << cmd;
+    }
+    return s.str();
+}
+
+mapnik::geometry::linear_ring<double> make_ring(std::initializer_list<double> coords)
+{
+    mapnik::geometry::linear_ring<double> ring;
+    for (auto itr = coords.begin(); itr != coords.end(); itr += 2)
+    {
+        ring.emplace_back(*itr, *(itr + 1));
+    }
+    ring.emplace_back(ring.front());
+    return ring;
+}
+
+std::string clip(mapnik::geometry::polygon<double> const& poly, mapnik::box2d<double> const& box)
+{
+    mapnik::geometry::polygon_vertex_adapter<double> va(poly);
+    mapnik::polygon_clipper<mapnik::geometry::polygon_vertex_adapter<double>> clipper(va);
+    clipper.clip_box(box.minx(), box.miny(), box.maxx(), box.maxy());
+    return dump(clipper);
+}
+
+}
+
+TEST_CASE("polygon clipper") {
+
+mapnik::box2d<double> box(0, 0, 10, 10);
+
+SECTION("inside") {
+    mapnik::geometry::polygon<double> poly;
+    poly.push_back(make_ring({1, 1, 9, 1, 9, 9}));
+    CHECK(clip(poly, box) == "1 1 1,9 1 2,9 9 2,0 0 79");
+}
+
+SECTION("outside") {
+    mapnik::geometry::polygon<double> poly;
+    poly.push_back(make_ring({11, 11, 19, 11, 19, 19}));
+    CHECK(clip(poly, box) == "");
+}
+
+SECTION("covering") {
+    mapnik::geometry::polygon<double> poly;
+    poly.push_back(make_ring({-10, -10, 20, -10, 20, 20, -10, 20}));
+    CHECK(clip(poly, box) == "0 10 1,0 0 2,10 0 2,10 10 2,0 0 79");
+}
+
+SECTION("hole outside is dropped, hole inside kept") {
+    mapnik::geometry::polygon<double> poly;
+    poly.push_back(make_ring({-10, -10, 20, -10, 20, 20, -10, 20}));
+    poly.push_back(make_ring({12, 12, 18, 12, 18, 18}));
+    poly.push_back(make_ring({2, 2, 4, 2, 4, 4}));
+    CHECK(clip(poly, box) == "0 10 1,0 0 2,10 0 2,10 10 2,0 0 79,2 2 1,4 2 2,4 4 2,0 0 79");
+}
+
+SECTION("collapsed boundary edges") {
+    // leaves through the right edge, loops above the box and comes back
+    // through the right edge: Sutherland-Hodgman yields a back-tracking
+    // spike along x=10 which must not reach the rasterizer
+    mapnik::geometry::polygon<double> poly;
+    poly.push_back(make_ring({5, 2, 15, 2, 15, 20, 8, 20, 8, 15, 12, 15, 12, 4, 5, 4}));
+    CHECK(clip(poly, box) == "5 2 1,10 2 2,10 4 2,5 4 2,0 0 79");
+}
+
+}
@@ -31,6 +31,8 @@
 
 #include "process_csv_file.hpp"
 #include "process_geojson_file_x3.hpp"
+#include "process_feature_cache.hpp"
+#include <mapnik/datasource_cache.hpp>
 
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
@@ -56,6 +58,11 @@ bool is_geojson(std::string const& filename)
         || boost::iends_with(filename,".json");
 }
 
+bool is_topojson(std::string const& filename)
+{
+    return boost::iends_with(filename,".topojson");
+}
+
 }}
 
 int main (int argc, char** argv)
@@ -72,10 +79,12 @@ int main (int argc, char** argv)
     std::string manual_headers;
     mapnik::box2d<float> bbox;
     bool use_bbox = false;
+    bool cache = false;
+    std::string input_plugins = "./plugins/input/";
     po::variables_map vm;
     try
     {
-        po::options_description desc("Mapnik CSV/GeoJSON index utility");
+        po::options_description desc("Mapnik CSV/GeoJSON/TopoJSON index utility");
         desc.add_options()
             ("help,h", "Produce usage message")
             ("version,V","Print version string")
@@ -88,6 +97,8 @@ int main (int argc, char** argv)
             ("files",po::value<std::vector<std::string> >(),"Files to index: file1 file2 ...fileN")
             ("validate-features", "Validate GeoJSON features")
             ("bbox,b", po::value<std::string>(), "Only index features within bounding box: --bbox=minx,miny,maxx,maxy")
+            ("cache", "Also write a binary feature cache (<file>.fcache), TopoJSON files are only cached")
+            ("input-plugins", po::value<std::string>(), "Input plugins directory used by --cache (default ./plugins/input/)")
             ;
 
         po::positional_options_description p;
@@ -145,6 +156,14 @@ int main (int argc, char** argv)
         {
             use_bbox = true;
         }
+        if (vm.count("cache"))
+        {
+            cache = true;
+        }
+        if (vm.count("input-plugins"))
+        {
+            input_plugins = vm["input-plugins"].as<std::string>();
+        }
     }
     catch (std::exception const& ex)
     {
@@ -161,7 +180,8 @@ int main (int argc, char** argv)
             continue;
         }
 
-        if (mapnik::detail::is_csv(filename) || mapnik::detail::is_geojson(filename))
+        if (mapnik::detail::is_csv(filename) || mapnik::detail::is_geojson(filename)
+            || (cache && mapnik::detail::is_topojson(filename)))
         {
             files_to_process.push_back(filename);
         }
@@ -176,6 +196,27 @@ int main (int argc, char** argv)
     std::clog << "max tree depth:" << depth << std::endl;
     std::clog << "split ratio:" << ratio << std::endl;
 
+    if (cache)
+    {
+        mapnik::datasource_cache::instance().register_datasources(input_plugins);
+    }
+    // features are cached through the datasource plugins, which parse the files
+    // exactly as they do when rendering
+    auto cache_features = [&](std::string const& filename, std::string const& type)
+    {
+        mapnik::parameters params;
+        params["type"] = type;
+        params["file"] = filename;
+        if (type == "csv")
+        {
+            if (separator != 0) params["separator"] = std::string(1, separator);
+            if (quote != 0) params["quote"] = std::string(1, quote);
+            if (!manual_headers.empty()) params["headers"] = manual_headers;
+        }
+        std::clog << "caching features of '" << filename << "'\n";
+        return mapnik::detail::process_feature_cache(filename, params, verbose);
+    };
+
     using box_type = mapnik::box2d<float>;
     using item_type = std::pair<box_type, std::pair<std::uint64_t, std::uint64_t>>;
 
@@ -187,6 +228,16 @@ int main (int argc, char** argv)
             continue;
         }
 
+        if (mapnik::detail::is_topojson(filename))
+        {
+            if (!cache_features(filename, "topojson"))
+            {
+                std::clog << "Error: failed to process " << filename << std::endl;
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
         std::vector<item_type> boxes;
         box_type extent;
         if (mapnik::detail::is_csv(filename))
@@ -244,6 +295,11 @@ int main (int argc, char** argv)
                 file.flush();
                 file.close();
             }
+            if (cache && !cache_features(filename, mapnik::detail::is_csv(filename) ? "csv" : "geojson"))
+            {
+                std::clog << "Error: failed to process " << filename << std::endl;
+                return EXIT_FAILURE;
+            }
         }
         else
         {
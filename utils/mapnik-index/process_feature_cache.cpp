@@ -0,0 +1,85 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "process_feature_cache.hpp"
+
+#include <mapnik/datasource.hpp>
+#include <mapnik/datasource_cache.hpp>
+#include <mapnik/feature_cache.hpp>
+#include <mapnik/query.hpp>
+#include <mapnik/util/fs.hpp>
+
+#include <fstream>
+#include <iostream>
+
+namespace mapnik { namespace detail {
+
+bool process_feature_cache(std::string const& filename, mapnik::parameters const& params, bool verbose)
+{
+    std::string cache_filename = mapnik::feature_cache::filename(filename);
+    // make sure the datasource reads the source file
+    if (mapnik::util::exists(cache_filename)) mapnik::util::remove(cache_filename);
+    try
+    {
+        // taken before parsing, so a source modified meanwhile invalidates the cache
+        auto source = mapnik::feature_cache_source::from_file(filename, params);
+        if (!source)
+        {
+            std::clog << "Error : cannot open " << filename << std::endl;
+            return false;
+        }
+        auto ds = mapnik::datasource_cache::instance().create(params);
+        mapnik::layer_descriptor desc = ds->get_descriptor();
+        mapnik::feature_cache_writer writer(desc, ds->get_geometry_type());
+        mapnik::query q(ds->envelope());
+        for (auto const& attr : desc.get_descriptors())
+        {
+            q.add_property_name(attr.get_name());
+        }
+        auto features = ds->features(q);
+        if (features)
+        {
+            for (auto feature = features->next(); feature; feature = features->next())
+            {
+                writer.add(*feature);
+            }
+        }
+        std::ofstream file(cache_filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!file)
+        {
+            std::clog << "cannot open feature cache file for writing \"" << cache_filename << "\"" << std::endl;
+            return false;
+        }
+        file.exceptions(std::ios::failbit | std::ios::badbit);
+        writer.write(file, *source);
+        if (verbose) std::clog << "cached features=" << writer.size() << std::endl;
+    }
+    catch (std::exception const& ex)
+    {
+        std::clog << "Error: failed to cache features of " << filename << ": " << ex.what() << std::endl;
+        if (mapnik::util::exists(cache_filename)) mapnik::util::remove(cache_filename);
+        return false;
+    }
+    return true;
+}
+
+}}
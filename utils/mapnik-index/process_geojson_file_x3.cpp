@@ -40,6 +40,9 @@ MAPNIK_DISABLE_WARNING_POP
 #include <mapnik/json/unicode_string_grammar_x3.hpp>
 #include <mapnik/json/positions_grammar_x3.hpp>
 #include <mapnik/json/extract_bounding_boxes_x3.hpp>
+#include <mapnik/util/parallel_for.hpp>
+// stl
+#include <atomic>
 
 namespace {
 
@@ -221,12 +224,57 @@ bool validate_geojson_feature(mapnik::json::geojson_value & value, Keys const& k
     return true;
 };
 
+// features per available thread below which validation runs serially
+constexpr std::size_t parallel_validation_min_features = 1024;
+
+auto const& geojson_value = mapnik::json::grammar::geojson_value;
+
+template <typename Iterator, typename Index>
+bool validate_feature(Iterator start, Index const& index, mapnik::json::keys_map & keys, bool verbose)
+{
+    using namespace boost::spirit;
+    using space_type = mapnik::json::grammar::space_type;
+#if BOOST_VERSION >= 106700
+    auto feature_grammar = x3::with<mapnik::json::grammar::keys_tag>(keys)
+        [ geojson_value ];
+#else
+    auto feature_grammar = x3::with<mapnik::json::grammar::keys_tag>(std::ref(keys))
+        [ geojson_value ];
+#endif
+    Iterator feat_itr = start + index.first;
+    Iterator feat_end = feat_itr + index.second;
+    mapnik::json::geojson_value feature_value;
+    try
+    {
+        bool result = x3::phrase_parse(feat_itr, feat_end, feature_grammar, space_type(), feature_value);
+        if (!result || feat_itr != feat_end)
+        {
+            if (verbose) std::clog << "Failed to parse: offset=" << index.first << " size=" << index.second << std::endl;
+            return false;
+        }
+    }
+    catch (x3::expectation_failure<std::string::const_iterator> const& ex)
+    {
+        if (verbose) std::clog << ex.what() << std::endl;
+        return false;
+    }
+    catch (...)
+    {
+        if (verbose) std::clog << "Failed to parse: offset=" << index.first << " size=" << index.second << std::endl;
+        return false;
+    }
+    if (!validate_geojson_feature(feature_value, keys, verbose))
+    {
+        if (verbose) std::clog << "Failed to validate: [" << std::string(start + index.first, feat_end) << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 using box_type = mapnik::box2d<float>;
 using boxes_type = std::vector<std::pair<box_type, std::pair<std::uint64_t, std::uint64_t>>>;
 using base_iterator_type = char const*;
 
-auto const& geojson_value = mapnik::json::grammar::geojson_value;
-
 }
 
 namespace mapnik { namespace detail {
@@ -283,58 +331,52 @@ std::pair<bool,typename T::value_type::first_type> process_geojson_file_x3(T & b
         return std::make_pair(false, extent);
     }
 
-    using namespace boost::spirit;
-    using space_type = mapnik::json::grammar::space_type;
-    auto keys = mapnik::json::get_keys();
-#if BOOST_VERSION >= 106700
-    auto feature_grammar = x3::with<mapnik::json::grammar::keys_tag>(keys)
-        [ geojson_value ];
-#else
-    auto feature_grammar = x3::with<mapnik::json::grammar::keys_tag>(std::ref(keys))
-        [ geojson_value ];
-#endif
-    for (auto const& item : boxes)
+    // features are validated in parallel, each worker with its own keys map
+    // (the grammar adds unknown property names to it). Once a feature fails,
+    // features after it are skipped and the first failure is parsed again on
+    // this thread to report it.
+    std::atomic<std::size_t> first_failure(boxes.size());
+    if (validate_features)
     {
-        if (item.first.valid())
+        mapnik::util::parallel_for(boxes.size(), parallel_validation_min_features,
+                                   [&](std::size_t first, std::size_t last)
         {
-            if (!extent.valid()) extent = item.first;
-            else extent.expand_to_include(item.first);
-            if (validate_features)
+            auto keys = mapnik::json::get_keys();
+            for (std::size_t i = first; i < last && i < first_failure.load(); ++i)
             {
-                base_iterator_type feat_itr = start + item.second.first;
-                base_iterator_type feat_end = feat_itr + item.second.second;
-                mapnik::json::geojson_value feature_value;
-                try
-                {
-                    bool result = x3::phrase_parse(feat_itr, feat_end, feature_grammar, space_type(), feature_value);
-                    if (!result || feat_itr != feat_end)
-                    {
-                        if (verbose) std::clog << "Failed to parse: offset=" << item.second.first << " size=" << item.second.second << std::endl;
-                        return std::make_pair(false, extent);
-                    }
-                }
-                catch (x3::expectation_failure<std::string::const_iterator> const& ex)
-                {
-                    if (verbose) std::clog << ex.what() << std::endl;
-                    return std::make_pair(false, extent);
-                }
-                catch (...)
-                {
-                    if (verbose) std::clog << "Failed to parse: offset=" << item.second.first << " size=" << item.second.second << std::endl;
-                    return std::make_pair(false, extent);
-                }
-                if (!validate_geojson_feature(feature_value, keys, verbose))
+                auto const& item = boxes[i];
+                if (!item.first.valid() || !validate_feature(start, item.second, keys, false))
                 {
-                    if (verbose) std::clog << "Failed to validate: [" << std::string(start + item.second.first, feat_end ) << "]" << std::endl;
-                    return std::make_pair(false, extent);
+                    std::size_t current = first_failure.load();
+                    while (i < current && !first_failure.compare_exchange_weak(current, i)) {}
+                    break;
                 }
             }
+        });
+    }
+    std::size_t const failed = first_failure.load();
+    for (std::size_t i = 0; i < boxes.size() && i <= failed; ++i)
+    {
+        auto const& item = boxes[i];
+        if (item.first.valid())
+        {
+            if (!extent.valid()) extent = item.first;
+            else extent.expand_to_include(item.first);
         }
-        else if (validate_features)
+    }
+    if (failed < boxes.size())
+    {
+        auto const& item = boxes[failed];
+        if (!item.first.valid())
         {
             if (verbose) std::clog << "Invalid bbox encountered " << item.first << std::endl;
-            return std::make_pair(false, extent);
         }
+        else if (verbose)
+        {
+            auto keys = mapnik::json::get_keys();
+            validate_feature(start, item.second, keys, verbose);
+        }
+        return std::make_pair(false, extent);
     }
     return std::make_pair(true, extent);
 }
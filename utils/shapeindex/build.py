@@ -32,6 +32,7 @@ program_env = plugin_base.Clone()
 source = Split(
     """
     shapeindex.cpp
+    reorder_shapefile.cpp
     """
     )
 
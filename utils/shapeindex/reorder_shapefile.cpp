@@ -0,0 +1,334 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#include "reorder_shapefile.hpp"
+
+// mapnik
+#include <mapnik/geometry/box2d.hpp>
+#include <mapnik/util/fs.hpp>
+#include <mapnik/util/packed_rtree.hpp>
+#ifdef _WINDOWS
+#include <mapnik/util/utf_conv_win.hpp>
+#endif
+
+// stl
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace mapnik { namespace detail {
+
+namespace {
+
+std::int32_t read_xdr_int(char const* data)
+{
+    std::uint8_t const* b = reinterpret_cast<std::uint8_t const*>(data);
+    return static_cast<std::int32_t>((std::uint32_t(b[0]) << 24) | (std::uint32_t(b[1]) << 16) |
+                                     (std::uint32_t(b[2]) << 8) | std::uint32_t(b[3]));
+}
+
+void write_xdr_int(char * data, std::int32_t val)
+{
+    std::uint32_t v = static_cast<std::uint32_t>(val);
+    data[0] = static_cast<char>((v >> 24) & 0xff);
+    data[1] = static_cast<char>((v >> 16) & 0xff);
+    data[2] = static_cast<char>((v >> 8) & 0xff);
+    data[3] = static_cast<char>(v & 0xff);
+}
+
+template <typename T>
+T read_ndr(char const* data)
+{
+    T val;
+    std::memcpy(&val, data, sizeof(T));
+    return val;
+}
+
+box2d<double> read_envelope(char const* data)
+{
+    return box2d<double>(read_ndr<double>(data), read_ndr<double>(data + 8),
+                         read_ndr<double>(data + 16), read_ndr<double>(data + 24));
+}
+
+template <typename Stream>
+bool open_stream(Stream & stream, std::string const& filename, std::ios::openmode mode)
+{
+#ifdef _WINDOWS
+    stream.open(mapnik::utf8_to_utf16(filename).c_str(), mode | std::ios::binary);
+#else
+    stream.open(filename.c_str(), mode | std::ios::binary);
+#endif
+    if (!stream)
+    {
+        std::clog << "Error : cannot open " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct record
+{
+    std::uint64_t key;
+    std::uint32_t index;    // position in the original files
+    std::uint32_t offset;   // .shp offset in bytes
+    std::uint32_t length;   // content length in bytes
+};
+
+// Renames each `first` to `second`. If one of them fails, the files
+// already renamed are moved back, so either all or none are renamed.
+bool rename_files(std::vector<std::pair<std::string, std::string>> const& files)
+{
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        if (std::rename(files[i].first.c_str(), files[i].second.c_str()) != 0)
+        {
+            std::clog << "Error : cannot rename " << files[i].first << " to " << files[i].second << std::endl;
+            while (i-- > 0)
+            {
+                if (std::rename(files[i].second.c_str(), files[i].first.c_str()) != 0)
+                {
+                    std::clog << "Error : cannot restore " << files[i].first
+                              << " from " << files[i].second << std::endl;
+                }
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous ns
+
+bool reorder_shapefile(std::string const& shapename, shapefile_order order, bool verbose)
+{
+    std::string const shp_name = shapename + ".shp";
+    std::string const shx_name = shapename + ".shx";
+    std::string const dbf_name = shapename + ".dbf";
+    bool const has_dbf = mapnik::util::exists(dbf_name);
+
+    std::vector<record> records;
+    std::vector<char> shp_header(100);
+    std::vector<char> shx_header(100);
+    {
+        std::ifstream shx;
+        if (!open_stream(shx, shx_name, std::ios::in)) return false;
+        if (!shx.read(shx_header.data(), shx_header.size()) || read_xdr_int(shx_header.data()) != 9994)
+        {
+            std::clog << "Error : " << shx_name << " is not a shapefile index" << std::endl;
+            return false;
+        }
+        std::int64_t shx_length = std::int64_t(read_xdr_int(shx_header.data() + 24)) * 2;
+        std::size_t count = shx_length > 100 ? static_cast<std::size_t>((shx_length - 100) / 8) : 0;
+        std::vector<char> entries(count * 8);
+        shx.read(entries.data(), entries.size());
+        count = static_cast<std::size_t>(shx.gcount() / 8);
+        records.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::int32_t offset = read_xdr_int(entries.data() + i * 8);
+            std::int32_t length = read_xdr_int(entries.data() + i * 8 + 4);
+            if (offset < 50 || length < 0)
+            {
+                std::clog << "Error : invalid record " << i << " in " << shx_name << std::endl;
+                return false;
+            }
+            records.push_back({0, static_cast<std::uint32_t>(i),
+                        static_cast<std::uint32_t>(offset) * 2, static_cast<std::uint32_t>(length) * 2});
+        }
+    }
+
+    std::ifstream shp;
+    if (!open_stream(shp, shp_name, std::ios::in)) return false;
+    if (!shp.read(shp_header.data(), shp_header.size()) || read_xdr_int(shp_header.data()) != 9994)
+    {
+        std::clog << "Error : " << shp_name << " is not a shapefile" << std::endl;
+        return false;
+    }
+    box2d<double> extent = read_envelope(shp_header.data() + 36);
+
+    // compute keys from record envelopes, null shapes go last
+    char buffer[44];
+    for (auto & rec : records)
+    {
+        rec.key = std::numeric_limits<std::uint64_t>::max();
+        shp.seekg(rec.offset + 8, std::ios::beg);
+        std::size_t size = std::min<std::size_t>(sizeof(buffer), rec.length);
+        if (size < 4 || !shp.read(buffer, size)) continue;
+        std::int32_t shape_type = read_ndr<std::int32_t>(buffer);
+        box2d<double> box;
+        if (shape_type == 1 || shape_type == 11 || shape_type == 21) // point, pointz, pointm
+        {
+            if (size < 20) continue;
+            double x = read_ndr<double>(buffer + 4);
+            double y = read_ndr<double>(buffer + 12);
+            box.init(x, y, x, y);
+        }
+        else if (shape_type != 0)
+        {
+            if (size < 36) continue;
+            box = read_envelope(buffer + 4);
+        }
+        if (!box.valid()) continue;
+        rec.key = (order == shapefile_order::hilbert) ? mapnik::util::hilbert_index(box, extent)
+            : mapnik::util::zorder_index(box, extent);
+    }
+    shp.clear();
+    std::stable_sort(records.begin(), records.end(),
+                     [](record const& a, record const& b) { return a.key < b.key; });
+
+    std::string const shp_tmp = shp_name + ".tmp";
+    std::string const shx_tmp = shx_name + ".tmp";
+    std::string const dbf_tmp = dbf_name + ".tmp";
+    auto cleanup = [&]()
+    {
+        mapnik::util::remove(shp_tmp);
+        mapnik::util::remove(shx_tmp);
+        if (has_dbf) mapnik::util::remove(dbf_tmp);
+        return false;
+    };
+    {
+        std::ofstream shp_out;
+        std::ofstream shx_out;
+        if (!open_stream(shp_out, shp_tmp, std::ios::out | std::ios::trunc)) return cleanup();
+        if (!open_stream(shx_out, shx_tmp, std::ios::out | std::ios::trunc)) return cleanup();
+        shp_out.write(shp_header.data(), shp_header.size());
+        shx_out.write(shx_header.data(), shx_header.size());
+        std::vector<char> data;
+        std::uint32_t offset = 100;
+        std::int32_t record_number = 1;
+        char entry[8];
+        for (auto const& rec : records)
+        {
+            data.resize(8 + rec.length);
+            shp.seekg(rec.offset, std::ios::beg);
+            if (!shp.read(data.data(), data.size()))
+            {
+                std::clog << "Error : cannot read record " << rec.index + 1 << " from " << shp_name << std::endl;
+                return cleanup();
+            }
+            write_xdr_int(data.data(), record_number++);
+            shp_out.write(data.data(), data.size());
+            write_xdr_int(entry, static_cast<std::int32_t>(offset / 2));
+            write_xdr_int(entry + 4, static_cast<std::int32_t>(rec.length / 2));
+            shx_out.write(entry, sizeof(entry));
+            offset += static_cast<std::uint32_t>(data.size());
+        }
+        // records may have been scattered in the original, fix up file length
+        write_xdr_int(shp_header.data() + 24, static_cast<std::int32_t>(offset / 2));
+        shp_out.seekp(0, std::ios::beg);
+        shp_out.write(shp_header.data(), shp_header.size());
+        if (!shp_out || !shx_out)
+        {
+            std::clog << "Error : failed writing " << shp_tmp << std::endl;
+            return cleanup();
+        }
+    }
+    shp.close();
+
+    if (has_dbf)
+    {
+        std::ifstream dbf;
+        std::ofstream dbf_out;
+        if (!open_stream(dbf, dbf_name, std::ios::in)) return cleanup();
+        char header[32];
+        if (!dbf.read(header, sizeof(header)))
+        {
+            std::clog << "Error : cannot read " << dbf_name << std::endl;
+            return cleanup();
+        }
+        std::uint32_t num_records = read_ndr<std::uint32_t>(header + 4);
+        std::uint16_t header_length = read_ndr<std::uint16_t>(header + 8);
+        std::uint16_t record_length = read_ndr<std::uint16_t>(header + 10);
+        if (num_records != records.size() || header_length < sizeof(header))
+        {
+            std::clog << "Error : " << dbf_name << " does not match " << shx_name << std::endl;
+            return cleanup();
+        }
+        if (!open_stream(dbf_out, dbf_tmp, std::ios::out | std::ios::trunc)) return cleanup();
+        std::vector<char> data(header_length);
+        dbf.seekg(0, std::ios::beg);
+        dbf.read(data.data(), data.size());
+        dbf_out.write(data.data(), data.size());
+        data.resize(record_length);
+        for (auto const& rec : records)
+        {
+            dbf.seekg(header_length + std::uint64_t(rec.index) * record_length, std::ios::beg);
+            if (!dbf.read(data.data(), data.size()))
+            {
+                std::clog << "Error : cannot read record " << rec.index + 1 << " from " << dbf_name << std::endl;
+                return cleanup();
+            }
+            dbf_out.write(data.data(), data.size());
+        }
+        dbf_out.put(0x1a); // end of file marker
+        if (!dbf_out)
+        {
+            std::clog << "Error : failed writing " << dbf_tmp << std::endl;
+            return cleanup();
+        }
+    }
+
+    shp.close();
+    // move the originals aside first, so that a failing rename can be rolled
+    // back without ever leaving a mix of old and new files
+    std::vector<std::pair<std::string, std::string>> backups = {
+        {shp_name, shp_name + ".orig"}, {shx_name, shx_name + ".orig"}};
+    std::vector<std::pair<std::string, std::string>> updates = {
+        {shp_tmp, shp_name}, {shx_tmp, shx_name}};
+    if (has_dbf)
+    {
+        backups.emplace_back(dbf_name, dbf_name + ".orig");
+        updates.emplace_back(dbf_tmp, dbf_name);
+    }
+    for (auto const& backup : backups)
+    {
+        if (mapnik::util::exists(backup.second)) mapnik::util::remove(backup.second);
+    }
+    if (!rename_files(backups)) return cleanup();
+    if (!rename_files(updates))
+    {
+        std::vector<std::pair<std::string, std::string>> restore;
+        for (auto const& backup : backups) restore.emplace_back(backup.second, backup.first);
+        if (!rename_files(restore))
+        {
+            std::clog << "Error : original files of " << shapename << " are left as *.orig" << std::endl;
+        }
+        return cleanup();
+    }
+    for (auto const& backup : backups)
+    {
+        mapnik::util::remove(backup.second);
+    }
+    if (verbose)
+    {
+        std::clog << "reordered " << records.size() << " records" << std::endl;
+    }
+    return true;
+}
+
+}}
@@ -0,0 +1,48 @@
+/*****************************************************************************
+ *
+ * This file is part of Mapnik (c++ mapping toolkit)
+ *
+ * Copyright (C) 2021 Artem Pavlenko
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *****************************************************************************/
+
+#ifndef MAPNIK_UTILS_REORDER_SHAPEFILE_HPP
+#define MAPNIK_UTILS_REORDER_SHAPEFILE_HPP
+
+#include <string>
+
+namespace mapnik { namespace detail {
+
+enum class shapefile_order
+{
+    hilbert,
+    zorder
+};
+
+// Rewrites <shapename>.shp/.shx/.dbf with records sorted along a space
+// filling curve through the centres of their envelopes, so features close
+// to each other on the map are also close to each other on disk. The new
+// files are written next to the originals; once complete the originals
+// are moved to *.orig, the new files renamed into place and the backups
+// removed. If a rename fails, the renames done so far are rolled back.
+// Only if that rollback fails too (e.g. the directory became read-only
+// halfway) are the originals left behind as *.orig, which is reported.
+bool reorder_shapefile(std::string const& shapename, shapefile_order order, bool verbose);
+
+}}
+
+#endif // MAPNIK_UTILS_REORDER_SHAPEFILE_HPP
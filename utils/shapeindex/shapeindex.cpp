@@ -26,11 +26,13 @@
 #include <mapnik/version.hpp>
 #include <mapnik/util/fs.hpp>
 #include <mapnik/quad_tree.hpp>
+#include <mapnik/util/packed_rtree.hpp>
 //#include <mapnik/util/spatial_index.hpp>
 #include <mapnik/geometry/envelope.hpp>
 #include "shapefile.hpp"
 #include "shape_io.hpp"
 #include "shape_index_featureset.hpp"
+#include "reorder_shapefile.hpp"
 #include <mapnik/warning.hpp>
 MAPNIK_DISABLE_WARNING_PUSH
 #include <mapnik/warning_ignore.hpp>
@@ -53,6 +55,9 @@ int main (int argc,char** argv)
 
     bool verbose=false;
     bool index_parts = false;
+    bool packed = false;
+    unsigned int fanout = mapnik::util::packed_rtree_default_fanout;
+    std::string reorder;
     unsigned int depth = DEFAULT_DEPTH;
     double ratio = DEFAULT_RATIO;
     std::vector<std::string> shape_files;
@@ -67,6 +72,9 @@ int main (int argc,char** argv)
             ("verbose,v","verbose output")
             ("depth,d", po::value<unsigned int>(), "max tree depth\n(default 8)")
             ("ratio,r",po::value<double>(),"split ratio (default 0.55)")
+            ("packed","write packed Hilbert R-tree index (default: quad tree)")
+            ("fanout",po::value<unsigned int>(),"packed R-tree node size (default 64)")
+            ("reorder",po::value<std::string>(),"rewrite .shp/.shx/.dbf in spatial order before indexing: hilbert or zorder")
             ("shape_files",po::value<std::vector<std::string> >(),"shape files to index: file1 file2 ...fileN")
             ;
 
@@ -103,6 +111,23 @@ int main (int argc,char** argv)
         {
             index_parts = true;
         }
+        if (vm.count("packed"))
+        {
+            packed = true;
+        }
+        if (vm.count("fanout"))
+        {
+            fanout = vm["fanout"].as<unsigned int>();
+        }
+        if (vm.count("reorder"))
+        {
+            reorder = vm["reorder"].as<std::string>();
+            if (reorder != "hilbert" && reorder != "zorder")
+            {
+                std::clog << "Error: unknown --reorder value '" << reorder << "' (expected hilbert or zorder)" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
         if (vm.count("depth"))
         {
             depth = vm["depth"].as<unsigned int>();
@@ -123,8 +148,15 @@ int main (int argc,char** argv)
         return EXIT_FAILURE;
     }
 
-    std::clog << "max tree depth:" << depth << std::endl;
-    std::clog << "split ratio:" << ratio << std::endl;
+    if (packed)
+    {
+        std::clog << "packed R-tree fanout:" << fanout << std::endl;
+    }
+    else
+    {
+        std::clog << "max tree depth:" << depth << std::endl;
+        std::clog << "split ratio:" << ratio << std::endl;
+    }
 
     if (shape_files.size() == 0)
     {
@@ -148,6 +180,17 @@ int main (int argc,char** argv)
             std::clog << "Error : shapefile index file (*.shx) " << shxname << " does not exist" << std::endl;
             continue;
         }
+        if (!reorder.empty())
+        {
+            std::clog << "reordering records (" << reorder << ")" << std::endl;
+            auto order = (reorder == "hilbert") ? mapnik::detail::shapefile_order::hilbert
+                : mapnik::detail::shapefile_order::zorder;
+            if (!mapnik::detail::reorder_shapefile(shapename, order, verbose))
+            {
+                std::clog << "Error : failed to reorder " << shapename_full << std::endl;
+                continue;
+            }
+        }
         shape_file shp (shapename_full);
 
         if (! shp.is_open())
@@ -192,6 +235,12 @@ int main (int argc,char** argv)
                 static_cast<float>(extent.maxy())};
 
         mapnik::quad_tree<mapnik::detail::node, mapnik::box2d<float> > tree(extent_f, depth, ratio);
+        mapnik::util::packed_rtree_builder<mapnik::detail::node> packed_tree(extent_f, fanout);
+        auto insert = [&](mapnik::detail::node const& item, mapnik::box2d<float> const& box)
+        {
+            if (packed) packed_tree.insert(item, box);
+            else tree.insert(item, box);
+        };
         int count = 0;
 
         if (shape_type != shape_io::shape_null)
@@ -261,7 +310,7 @@ int main (int argc,char** argv)
                                     static_cast<float>(item_ext.miny()),
                                     static_cast<float>(item_ext.maxx()),
                                     static_cast<float>(item_ext.maxy())};
-                            tree.insert(mapnik::detail::node(offset * 2, start, end, std::move(ext_f)), ext_f);
+                            insert(mapnik::detail::node(offset * 2, start, end, std::move(ext_f)), ext_f);
                             ++count;
                         }
                     }
@@ -283,7 +332,7 @@ int main (int argc,char** argv)
                             static_cast<float>(item_ext.maxx()),
                             static_cast<float>(item_ext.maxy())};
 
-                    tree.insert(mapnik::detail::node(offset * 2, -1, 0, std::move(ext_f)), ext_f);
+                    insert(mapnik::detail::node(offset * 2, -1, 0, std::move(ext_f)), ext_f);
                     ++count;
                 }
             }
@@ -302,6 +351,13 @@ int main (int argc,char** argv)
                 std::clog << "cannot open index file for writing file \""
                           << (shapename+".index") << "\"" << std::endl;
             }
+            else if (packed)
+            {
+                file.exceptions(std::ios::failbit | std::ios::badbit);
+                packed_tree.write(file);
+                file.flush();
+                file.close();
+            }
             else
             {
                 tree.trim();